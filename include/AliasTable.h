@@ -0,0 +1,41 @@
+#ifndef ALIAS_TABLE_H
+#define ALIAS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Walker/Vose alias method: O(1) sampling from a discrete weighted distribution.
+// Slot i keeps itself with probability[i] and otherwise yields alias[i]. The static
+// helpers work on caller-provided flat arrays, so many tables can share one buffer
+// (e.g. one per row of a CSR structure).
+class AliasTable {
+public:
+    AliasTable() = default;
+    explicit AliasTable(const std::vector<double>& weights);
+
+    size_t size() const { return probability.size(); }
+    bool empty() const { return probability.empty(); }
+
+    std::uint32_t sample(std::mt19937& rng) const {
+        return sample(probability.data(), alias.data(), static_cast<std::uint32_t>(probability.size()), rng);
+    }
+
+    // Fill probability/alias[0, count) for the given non-negative weights (not all zero)
+    static void build(const double* weights, size_t count, float* probability, std::uint32_t* alias);
+
+    // Draw an index in [0, count) from a table built by build()
+    static std::uint32_t sample(const float* probability, const std::uint32_t* alias, std::uint32_t count, std::mt19937& rng) {
+        // Multiply-shift picks the slot without a division; 24 bits give the float coin
+        const std::uint32_t slot = static_cast<std::uint32_t>((static_cast<std::uint64_t>(rng()) * count) >> 32);
+        const float coin = static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f);
+        return coin < probability[slot] ? slot : alias[slot];
+    }
+
+private:
+    std::vector<float> probability;
+    std::vector<std::uint32_t> alias;
+};
+
+#endif // ALIAS_TABLE_H
@@ -3,19 +3,64 @@
 
 #include <vector>
 #include<string>
+#include <random>
+#include <atomic>
+#include <cstdint>
+#include "Oscillators.h"
+#include "PCMEncoder.h"
+#include "ColoredNoise.h"
+#include "AudioMixer.h"
+#include "AudioFeatures.h"
+#include "StreamSink.h"
 
 enum class AudioType {
 	SINE_WAVE,
 	WHITE_NOISE,
 	PINK_NOISE,
 	CHIRP,
-	COMBINED
+	COMBINED,
+	SQUARE_WAVE,
+	SAWTOOTH_WAVE,
+	TRIANGLE_WAVE,
+	BROWN_NOISE,
+	BLUE_NOISE,
+	VIOLET_NOISE
 };
 
+// WAV container: AUTO writes RIFF and switches to RF64 only when the data exceeds 4 GB
+enum class WAVContainer {
+	AUTO,
+	RIFF,
+	RF64,
+	BW64
+};
+
+// Samples are planar: channel c occupies data[c * numFrames(), (c + 1) * numFrames())
 struct AudioSample {
 	std::vector<float> data;
 	int sampleRate;
 	int numChannels;
+
+	size_t numFrames() const { return numChannels > 0 ? data.size() / numChannels : 0; }
+	float* channel(int c) { return data.data() + c * numFrames(); }
+	const float* channel(int c) const { return data.data() + c * numFrames(); }
+};
+
+struct StreamConfig {
+	StreamTarget target = StreamTarget::STDOUT;
+	std::string path;          // FIFO or socket path
+	double speed = 1.0;        // 1 = real time, N = N x real time, 0 = as fast as the reader takes it
+	double latency = 0.2;      // most audio buffered between producer and writer, in seconds
+	double period = 0.01;      // audio per write, in seconds
+	double maxSeconds = 0.0;   // 0 = endless
+};
+
+struct StreamStats {
+	std::uint64_t framesWritten = 0;
+	std::uint64_t underruns = 0;     // writes the producer could not fill in time
+	std::uint64_t silentFrames = 0;  // silence inserted on underruns
+	std::uint64_t lateWrites = 0;    // writes that started more than one period behind schedule
+	bool readerClosed = false;
 };
 
 class AudioData {
@@ -24,25 +69,72 @@ public:
 
 	void setAudioType(AudioType type);
 	void setNumChannels(int channels);
+	// Frequency law of CHIRP clips (linear by default)
+	void setSweepType(SweepType type);
+	// Sample encoding of exported WAV files (16-bit PCM by default)
+	void setSampleFormat(SampleFormat format);
+	void setWAVContainer(WAVContainer container);
+	// Add TPDF dither when quantizing to PCM
+	void setDither(bool enabled);
+	// Each channel mixes a shared signal with one of its own: 1.0 (default) gives identical
+	// channels, 0.0 fully independent ones
+	void setChannelCorrelation(double correlation);
+	// Delay of the shared signal per channel, in seconds (missing entries are 0)
+	void setChannelDelays(const std::vector<double>& seconds);
+	// 0 = one worker per hardware thread
+	void setNumThreads(int threads);
+	// Extra delivery rates: every clip is also exported as audio_<n>_<rate>.wav, resampled
+	// from the generated master instead of being synthesized again
+	void setOutputRates(const std::vector<int>& rates);
+	// Features exported next to each clip as audio_<n>_<feature>.npy, shaped
+	// (channels, frames, values); none by default
+	void setFeatures(const std::vector<AudioFeature>& features);
+	void setFeatureConfig(const FeatureConfig& config);
 	void generate();
 	void exportToDirectory(const std::string& directory) const;
 
 	std::vector<AudioSample> getAudioSamples() const;
 
+	// Stream consecutive clips as raw interleaved audio in the configured sample format
+	// until maxSeconds, *stop or the reader going away. A producer thread renders into a
+	// lock-free ring buffer holding at most `latency` seconds; the calling thread paces
+	// the writes and plays silence when the producer falls behind. Clips without frames
+	// throw std::invalid_argument.
+	StreamStats stream(const StreamConfig& config, const std::atomic<bool>* stop = nullptr) const;
+
+	// Resample one master to several rates in a single pass over its samples
+	static std::vector<AudioSample> resample(const AudioSample& master, const std::vector<int>& rates, int numThreads = 0);
+
 private:
 	int numSamples;
 	int sampleRate;
 	int durationSeconds;
 	AudioType audioType;
 	int numChannels;
+	SweepType sweepType;
+	SampleFormat sampleFormat;
+	bool ditherEnabled;
+	WAVContainer wavContainer;
+	double channelCorrelation;
+	std::vector<double> channelDelays;
+	int numThreads;
+	std::vector<int> outputRates;
+	std::vector<AudioFeature> features;
+	FeatureConfig featureConfig;
 	std::vector<AudioSample> audioSamples;
-	std::vector<float> generateSineWave();
-	std::vector<float> generateWhiteNoise();
-	std::vector<float> generatePinkNoise();
-	std::vector<float> generateChirp();
-	std::vector<float> generateCombined();
+	size_t samplesPerChannel() const;
+	// Clip index of a batch, identical whether generated or streamed
+	void renderClip(int index, unsigned int batchSeed, AudioSample& sample, std::vector<float>& shared) const;
+
+	// Generators write count samples to out, drawing parameters and noise from rng
+	void generateSignal(std::mt19937& rng, float* out, size_t count) const;
+	void generateTone(Waveform waveform, std::mt19937& rng, float* out, size_t count) const;
+	void generateNoise(NoiseColor color, std::mt19937& rng, float* out, size_t count) const;
+	void generateChirp(std::mt19937& rng, float* out, size_t count) const;
+	void generateCombined(std::mt19937& rng, float* out, size_t count) const;
 
-	void writeWAVFile(const std::string& filename, const AudioSample& sample) const;
+	void writeWAVFile(const std::string& filename, const AudioSample& sample, std::uint32_t ditherSeed) const;
+	void writeFeatureFiles(const std::string& prefix, const AudioSample& sample) const;
 };
 
 #endif // AUDIO_DATA_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef AUDIO_FEATURES_H
+#define AUDIO_FEATURES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "FFT.h"
+
+enum class AudioFeature {
+    SPECTROGRAM,      // STFT magnitude, frames x (frameSize / 2 + 1)
+    MEL_SPECTROGRAM,  // mel-filtered power, frames x numMelBands
+    MFCC              // DCT-II of the log mel power, frames x numCoefficients
+};
+
+struct FeatureConfig {
+    int frameSize = 1024;  // FFT size, a power of two
+    int hopSize = 256;
+    int numMelBands = 64;
+    int numCoefficients = 13;
+    float minFrequency = 0.0f;
+    float maxFrequency = 0.0f;  // 0 = Nyquist
+};
+
+// Framewise spectral features of float samples. Frames are Hann-windowed and start every
+// hopSize samples (no centering; a clip shorter than one frame is zero-padded to one
+// frame). Mel bands use the HTK mel scale with triangular filters stored as sparse
+// weight spans; MFCCs are the orthonormal DCT-II of 10 * log10(mel power). Frames are
+// independent, so they are split across threads.
+class AudioFeatures {
+public:
+    AudioFeatures(int sampleRate, const FeatureConfig& config);
+
+    size_t numFrames(size_t samples) const;
+    // Values per frame of a feature
+    size_t featureSize(AudioFeature feature) const;
+
+    // Compute the requested features; out[f] receives numFrames(count) x featureSize(features[f])
+    // values in row-major order
+    void compute(const float* samples, size_t count, const std::vector<AudioFeature>& features,
+        std::vector<std::vector<float>>& out, int numThreads = 0) const;
+
+private:
+    FeatureConfig config;
+    FFT fft;
+    std::vector<float> window;
+
+    // Mel filter m covers bins [melFirst[m], melFirst[m] + melLength[m]) with weights at melOffset[m]
+    std::vector<int> melFirst;
+    std::vector<int> melLength;
+    std::vector<size_t> melOffset;
+    std::vector<float> melWeights;
+
+    // numCoefficients x numMelBands
+    std::vector<float> dct;
+};
+
+#endif // AUDIO_FEATURES_H
@@ -0,0 +1,82 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Renders the next count samples of a source into out; called on consecutive spans
+using AudioSource = std::function<void(float* out, size_t count)>;
+
+// Linear ADSR in seconds; the release ends with the track
+struct Envelope {
+    float attack = 0.0f;
+    float decay = 0.0f;
+    float sustain = 1.0f;
+    float release = 0.0f;
+};
+
+struct MixerTrack {
+    AudioSource source;
+    float gain = 1.0f;
+    // Position and length in samples; a negative length plays until the mix ends
+    // (release and fade-out then never start)
+    std::int64_t start = 0;
+    std::int64_t length = -1;
+    Envelope envelope;
+    // Linear fades in seconds
+    float fadeIn = 0.0f;
+    float fadeOut = 0.0f;
+};
+
+// Sums tracks block by block. Each track's source only renders while it is active,
+// and its gain, envelope and fades are folded into one per-sample gain curve.
+class AudioMixer {
+public:
+    explicit AudioMixer(double sampleRate);
+
+    void addTrack(const MixerTrack& track);
+
+    // Write the next count samples of the mix to out
+    void render(float* out, size_t count);
+
+private:
+    double sampleRate;
+    std::vector<MixerTrack> tracks;
+    std::int64_t position;
+};
+
+// Polyphase rational resampler (outputRate / inputRate reduced to up / down). Each
+// output sample is a dot product of one precomputed windowed-sinc phase with a
+// contiguous input window, so the inner loop is a flat multiply-accumulate. Streams:
+// call process() on consecutive blocks, then finish() to flush the filter tail.
+class Resampler {
+public:
+    // tapsPerPhase is the kernel width for upsampling; downsampling widens it by the ratio
+    Resampler(int inputRate, int outputRate, int tapsPerPhase = 32);
+
+    // Append the output produced by count more input samples
+    void process(const float* in, size_t count, std::vector<float>& out);
+    // Append the remaining output; the total is ceil(inputs * outputRate / inputRate)
+    void finish(std::vector<float>& out);
+
+    int getOutputRate() const;
+
+private:
+    void emit(std::vector<float>& out, std::int64_t available, std::int64_t limit);
+
+    int outputRate;
+    std::int64_t up;
+    std::int64_t down;
+    int taps;
+    // coefficients[phase * taps + k] weights input (center - taps / 2 + 1 + k)
+    std::vector<float> coefficients;
+    // Input samples from absolute index bufferStart on (negative indices are the zero history)
+    std::vector<float> buffer;
+    std::int64_t bufferStart;
+    std::int64_t inputCount;
+    std::int64_t outputCount;
+};
+
+#endif // AUDIO_MIXER_H
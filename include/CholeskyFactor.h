@@ -0,0 +1,32 @@
+#ifndef CHOLESKY_FACTOR_H
+#define CHOLESKY_FACTOR_H
+
+#include <cstddef>
+#include <vector>
+
+// Cholesky factor L of a symmetric positive semi-definite matrix C = L L^T. Applying it
+// to rows of independent unit-variance draws gives rows with covariance C, so a
+// correlation matrix is factored once and then mixes any number of noise rows.
+class CholeskyFactor {
+public:
+    // matrix is size x size, row-major; throws std::invalid_argument if it is not
+    // symmetric positive semi-definite
+    CholeskyFactor(const std::vector<double>& matrix, size_t size);
+
+    // Rows of L per packed panel, the output columns one kernel step produces
+    static constexpr size_t LANES = 4;
+
+    size_t size() const { return n; }
+    // L[i][j], zero above the diagonal
+    double at(size_t i, size_t j) const;
+
+    // out[r] = L in[r] for `rows` contiguous rows of size() values; in and out must not overlap
+    void apply(const double* in, double* out, size_t rows) const;
+
+private:
+    size_t n;
+    // Panel p holds rows p * LANES.. of L column by column: [j][lane], zero padded
+    std::vector<double> panels;
+};
+
+#endif // CHOLESKY_FACTOR_H
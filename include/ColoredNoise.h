@@ -0,0 +1,53 @@
+#ifndef COLORED_NOISE_H
+#define COLORED_NOISE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Spectral slope of the generated noise (power per octave)
+enum class NoiseColor {
+    WHITE,   // flat
+    PINK,    // -3 dB/octave
+    BROWN,   // -6 dB/octave
+    BLUE,    // +3 dB/octave
+    VIOLET   // +6 dB/octave
+};
+
+// Block-based colored noise. White noise comes from a counter-based hash, so a whole
+// block is filled in one vectorizable loop; pink uses the Voss-McCartney algorithm,
+// brown a leaky integrator, and blue/violet are first differences of pink/white.
+// Output is scaled to an RMS of about 1/3 for every color, so peaks stay near [-1, 1].
+class ColoredNoise {
+public:
+    ColoredNoise(NoiseColor color, double sampleRate, std::uint64_t seed);
+
+    // Write amplitude * noise to out[0, count)
+    void render(float* out, size_t count, float amplitude = 1.0f);
+
+private:
+    static constexpr int PINK_ROWS = 16;
+
+    // Uniform white noise in [-1, 1) of one stream for the next count counter values
+    void fillWhite(float* out, size_t count, std::uint32_t stream) const;
+    void renderPink(const float* white, const float* rowWhite, float* out, size_t count);
+
+    NoiseColor color;
+    std::uint32_t key;
+    std::uint64_t counter;
+
+    // Voss-McCartney rows: row k is redrawn every 2^k samples
+    std::array<float, PINK_ROWS> rows;
+    float rowSum;
+    std::uint32_t pinkCounter;
+
+    // Brown: y = leak * y + white, rescaled by brownScale
+    float brownLeak;
+    float brownScale;
+    float brownState;
+
+    // Last undifferenced sample, carried across blocks for blue and violet
+    float previous;
+};
+
+#endif // COLORED_NOISE_H
@@ -0,0 +1,89 @@
+#ifndef DATE_TIME_H
+#define DATE_TIME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Calendar arithmetic on the proleptic Gregorian calendar with day counts since
+// 1970-01-01, and fixed-width writers for its fields. Nothing here touches the C
+// library's time functions except localOffset().
+class DateTime {
+public:
+    static constexpr std::int64_t SECONDS_PER_DAY = 86400;
+
+    // Days since 1970-01-01 of a date and back (H. Hinnant's algorithms)
+    static std::int64_t daysFromCivil(std::int64_t year, unsigned month, unsigned day);
+    static void civilFromDays(std::int64_t days, std::int64_t& year, unsigned& month, unsigned& day);
+
+    static std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+        return a / b - ((a % b != 0 && (a < 0) != (b < 0)) ? 1 : 0);
+    }
+
+    // Day count of a "YYYY-MM-DD" date; throws std::invalid_argument if malformed
+    static std::int64_t parseDate(std::string_view text);
+
+    // Offset of local time from UTC in seconds at an instant, from the platform's time zone rules
+    static int localOffset(std::int64_t epochSeconds);
+
+    // Write YYYY-MM-DD (years clamped to 0..9999), HH:MM:SS, or a decimal integer at out
+    // and return the end
+    static char* writeDate(std::int64_t days, char* out);
+    static char* writeTime(unsigned secondOfDay, char* out);
+    static char* writeInteger(std::int64_t value, char* out);
+
+    static void write2(char* out, unsigned value) {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+    }
+    static void write4(char* out, unsigned value) {
+        write2(out, value / 100);
+        write2(out + 2, value % 100);
+    }
+};
+
+enum class TimestampFormat {
+    DATE_TIME,      // YYYY-MM-DD HH:MM:SS
+    ISO_8601,       // YYYY-MM-DDTHH:MM:SSZ in UTC, YYYY-MM-DDTHH:MM:SS+hh:mm in local time
+    EPOCH_SECONDS,
+    EPOCH_MILLIS
+};
+
+enum class TimeZone {
+    LOCAL,
+    UTC
+};
+
+// Formats a sequence of timestamps. The last rendering is kept and only the fields that
+// changed are rewritten, so a fixed-step series mostly re-renders its seconds or
+// minutes. The local offset is cached for the interval over which it was last seen
+// unchanged, so the platform is asked about once per day of data.
+class TimestampFormatter {
+public:
+    static constexpr size_t MAX_LENGTH = 25;
+
+    explicit TimestampFormatter(TimestampFormat format = TimestampFormat::DATE_TIME, TimeZone zone = TimeZone::LOCAL);
+
+    // The timestamp of an instant in seconds since the epoch; valid until the next call
+    std::string_view format(std::int64_t epochSeconds);
+
+private:
+    int offsetAt(std::int64_t epochSeconds);
+
+    TimestampFormat timestampFormat;
+    TimeZone zone;
+    char text[MAX_LENGTH];
+    size_t length;
+    // Wall-clock fields of the last rendering; -1 before the first
+    std::int64_t renderedDay;
+    int renderedHour;
+    int renderedMinute;
+    int renderedOffset;
+    // The offset is known to hold on [offsetFrom, offsetUntil)
+    int offset;
+    std::int64_t offsetFrom;
+    std::int64_t offsetUntil;
+};
+
+#endif // DATE_TIME_H
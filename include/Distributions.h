@@ -1,6 +1,7 @@
 #ifndef DISTRIBUTIONS_H
 #define DISTRIBUTIONS_H
 
+#include <cstddef>
 #include <random>
 #include <vector>
 
@@ -38,6 +39,11 @@ public:
         const std::vector<std::pair<double, double>>& normalParams,
         int numSamples);
 
+    // Batch kernels filling out[0, count) from a caller-owned generator, one 32-bit draw
+    // per value in the common case; normals use a ziggurat.
+    static void fillUniform(std::mt19937& rng, double* out, size_t count, double min, double max);
+    static void fillNormal(std::mt19937& rng, double* out, size_t count, double mean = 0.0, double stddev = 1.0);
+
 private:
     static std::mt19937& getGenerator();
 };
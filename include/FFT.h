@@ -0,0 +1,39 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Real-input FFT of a power-of-two size N. The N real samples are packed into an N/2-point
+// complex transform (even samples real, odd samples imaginary), run through an iterative
+// radix-2 butterfly on split real/imaginary arrays, and unpacked into bins 0..N/2.
+// Bit-reversal indices and twiddles are precomputed; each stage's twiddles are stored
+// contiguously so the butterfly loop reads them with unit stride and vectorizes.
+// The tables are read-only after construction, so one FFT can be shared across threads.
+class FFT {
+public:
+    explicit FFT(size_t size);
+
+    size_t size() const;
+    size_t numBins() const;
+
+    // in[0, size) -> re/im[0, size / 2 + 1); re and im are also used as scratch
+    void forwardReal(const float* in, float* re, float* im) const;
+
+private:
+    // In-place complex FFT of size / 2 points, input already in bit-reversed order
+    void butterflies(float* re, float* im) const;
+
+    size_t n;
+    size_t half;
+    std::vector<std::uint32_t> bitReverse;
+    // Twiddles of the stage with span 2h start at index h - 1
+    std::vector<float> stageCos;
+    std::vector<float> stageSin;
+    // exp(-2 pi i k / n) for unpacking the real transform
+    std::vector<float> unpackCos;
+    std::vector<float> unpackSin;
+};
+
+#endif // FFT_H
@@ -1,6 +1,8 @@
 #ifndef FILE_EXPORT_H
 #define FILE_EXPORT_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -34,6 +36,22 @@ public:
 	static void exportToINI(const std::string& filename,
 		const std::unordered_map<std::string, std::unordered_map<std::string, std::string>>& sections);
 
+	//export a float array to a NumPy .npy file (little-endian float32, C order)
+	static void exportToNPY(const std::string& filename,
+		const std::vector<size_t>& shape,
+		const float* data);
+
+	//export unsigned integers to .npy (little-endian uint16, uint32 or uint64)
+	static void exportToNPY(const std::string& filename,
+		const std::vector<size_t>& shape,
+		const std::uint16_t* data);
+	static void exportToNPY(const std::string& filename,
+		const std::vector<size_t>& shape,
+		const std::uint32_t* data);
+	static void exportToNPY(const std::string& filename,
+		const std::vector<size_t>& shape,
+		const std::uint64_t* data);
+
 };
 
 #endif // !FILE_EXPORT_H
@@ -0,0 +1,67 @@
+#ifndef IMAGE_AUGMENTATION_H
+#define IMAGE_AUGMENTATION_H
+
+#include <random>
+#include <vector>
+
+struct Image;
+
+// Concrete augmentation drawn for one image
+struct AugmentationParams {
+    int cropX = 0;
+    int cropY = 0;
+    int cropWidth = 0;
+    int cropHeight = 0;
+    bool flipHorizontal = false;
+    bool flipVertical = false;
+    float rotationDegrees = 0.0f;
+    float blurSigma = 0.0f;
+    float hueShiftDegrees = 0.0f;
+    float saturationScale = 1.0f;
+    float valueScale = 1.0f;
+};
+
+// Random crop / flip / rotate / Gaussian blur / HSV jitter for generated images.
+// The geometric ops are composed into one affine map and sampled bilinearly, the
+// color jitter is folded into a 3x3 color matrix, and the separable blur consumes
+// rows through a small ring buffer, so every output row is produced in one pass.
+class ImageAugmenter {
+public:
+    ImageAugmenter();
+
+    // Random crop of the given size (0 keeps the full image)
+    void setCrop(int width, int height);
+    void setFlipProbability(double horizontal, double vertical);
+    // Rotation angle is drawn uniformly from [-maxDegrees, maxDegrees]
+    void setRotationRange(float maxDegrees);
+    void setBlurSigmaRange(float minSigma, float maxSigma);
+    // Hue shift in degrees, saturation and value as +/- fractional scales
+    void setHSVJitter(float hueDegrees, float saturation, float value);
+
+    // True if crop, flip or rotation can move pixels (which would invalidate shape labels)
+    bool changesGeometry() const;
+
+    AugmentationParams sample(std::mt19937& rng, int width, int height) const;
+
+    // Apply one set of parameters; rows are split across numThreads workers
+    Image apply(const Image& input, const AugmentationParams& params, int numThreads = 1) const;
+    // Same, writing into output and reusing its storage (output must not alias input)
+    void apply(const Image& input, const AugmentationParams& params, Image& output, int numThreads = 1) const;
+
+    // Augment every image in place, one image per worker
+    void applyBatch(std::vector<Image>& images, std::mt19937& rng, int numThreads = 0) const;
+
+private:
+    int cropWidth;
+    int cropHeight;
+    double horizontalFlipProbability;
+    double verticalFlipProbability;
+    float maxRotationDegrees;
+    float minBlurSigma;
+    float maxBlurSigma;
+    float hueJitter;
+    float saturationJitter;
+    float valueJitter;
+};
+
+#endif // IMAGE_AUGMENTATION_H
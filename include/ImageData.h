@@ -5,27 +5,118 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <optional>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include "NoiseGenerators.h"
+#include "ImageAugmentation.h"
 
 // We'll use our own simple image representation instead of OpenCV
 struct RGBPixel {
     unsigned char r, g, b;
 };
 
+// Sample type of an Image; 16-bit and float images are for HDR / sensor simulation
+enum class PixelFormat {
+    UINT8,
+    UINT16,
+    FLOAT32
+};
+
+inline size_t bytesPerSample(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::UINT16:
+            return 2;
+        case PixelFormat::FLOAT32:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+// Per-sample-type behaviour. Colors are picked on the 8-bit 0..255 "level" scale and
+// converted once; integer formats saturate, float keeps the value (HDR).
+template<typename T>
+struct PixelTraits;
+
+template<>
+struct PixelTraits<unsigned char> {
+    static constexpr PixelFormat format = PixelFormat::UINT8;
+    static unsigned char fromLevel(float level) { return static_cast<unsigned char>(level); }
+    static unsigned char average(unsigned char a, unsigned char b, unsigned char c) { return static_cast<unsigned char>((a + b + c) / 3); }
+    static unsigned char saturate(float value) { return static_cast<unsigned char>(std::clamp(value + 0.5f, 0.0f, 255.0f)); }
+    static unsigned char random(std::mt19937& rng) { return static_cast<unsigned char>(std::uniform_int_distribution<int>(0, 255)(rng)); }
+};
+
+template<>
+struct PixelTraits<std::uint16_t> {
+    static constexpr PixelFormat format = PixelFormat::UINT16;
+    static std::uint16_t fromLevel(float level) { return static_cast<std::uint16_t>(level * 257.0f); }
+    static std::uint16_t average(std::uint16_t a, std::uint16_t b, std::uint16_t c) { return static_cast<std::uint16_t>((a + b + c) / 3); }
+    static std::uint16_t saturate(float value) { return static_cast<std::uint16_t>(std::clamp(value + 0.5f, 0.0f, 65535.0f)); }
+    static std::uint16_t random(std::mt19937& rng) { return static_cast<std::uint16_t>(std::uniform_int_distribution<int>(0, 65535)(rng)); }
+};
+
+template<>
+struct PixelTraits<float> {
+    static constexpr PixelFormat format = PixelFormat::FLOAT32;
+    static float fromLevel(float level) { return level * (1.0f / 255.0f); }
+    static float average(float a, float b, float c) { return (a + b + c) / 3.0f; }
+    static float saturate(float value) { return value; }
+    static float random(std::mt19937& rng) { return std::uniform_real_distribution<float>(0.0f, 1.0f)(rng); }
+};
+
+// Non-owning view of an image whose sample type and channel count are compile-time
+// constants, so per-pixel loops have no format or channel branches
+template<typename T, int C>
+struct ImageView {
+    static constexpr int channels = C;
+    T* data;
+    int width;
+    int height;
+
+    T* row(int y) const {
+        return data + static_cast<size_t>(y) * width * C;
+    }
+};
+
+// Type-erased image: format and channel count are runtime fields over raw sample bytes.
+// at()/getPixel()/setPixel() address 8-bit images and throw std::logic_error on others;
+// use view<T, C>() for typed access.
 struct Image {
     int width;
     int height;
     int channels;
+    PixelFormat format;
     std::vector<unsigned char> data;
     
-    Image(int w, int h, int c) : width(w), height(h), channels(c) {
-        data.resize(width * height * channels, 0);
+    Image(int w, int h, int c, PixelFormat f = PixelFormat::UINT8) : width(w), height(h), channels(c), format(f) {
+        data.resize(static_cast<size_t>(width) * height * channels * bytesPerSample(format), 0);
+    }
+
+    template<typename T, int C>
+    ImageView<T, C> view() {
+        checkView<T, C>();
+        return { reinterpret_cast<T*>(data.data()), width, height };
+    }
+
+    template<typename T, int C>
+    ImageView<const T, C> view() const {
+        checkView<T, C>();
+        return { reinterpret_cast<const T*>(data.data()), width, height };
     }
     
     unsigned char& at(int y, int x, int channel) {
+        checkBytes();
         return data[(y * width + x) * channels + channel];
     }
     
     const unsigned char& at(int y, int x, int channel) const {
+        checkBytes();
         return data[(y * width + x) * channels + channel];
     }
     
@@ -50,37 +141,178 @@ struct Image {
             at(y, x, 2) = pixel.b;
         }
     }
+
+private:
+    template<typename T, int C>
+    void checkView() const {
+        if (PixelTraits<std::remove_const_t<T>>::format != format || C != channels) {
+            throw std::logic_error("Image view type does not match the image format");
+        }
+    }
+
+    void checkBytes() const {
+        if (format != PixelFormat::UINT8) {
+            throw std::logic_error("Byte access needs an 8-bit image; use view<T, C>()");
+        }
+    }
 };
 
+// Call fn(view) with the ImageView matching the image's runtime format and channel count.
+// This is the one place the runtime format is inspected; fn is instantiated per format.
+template<typename T, typename Img, typename Fn>
+void visitChannels(Img& img, Fn&& fn) {
+    switch (img.channels) {
+        case 1:
+            fn(img.template view<T, 1>());
+            break;
+        case 2:
+            fn(img.template view<T, 2>());
+            break;
+        case 3:
+            fn(img.template view<T, 3>());
+            break;
+        case 4:
+            fn(img.template view<T, 4>());
+            break;
+        default:
+            throw std::invalid_argument("Images must have between 1 and 4 channels");
+    }
+}
+
+template<typename Img, typename Fn>
+void visitImage(Img& img, Fn&& fn) {
+    switch (img.format) {
+        case PixelFormat::UINT8:
+            visitChannels<unsigned char>(img, fn);
+            break;
+        case PixelFormat::UINT16:
+            visitChannels<std::uint16_t>(img, fn);
+            break;
+        case PixelFormat::FLOAT32:
+            visitChannels<float>(img, fn);
+            break;
+    }
+}
+
 enum class ImageType {
     RANDOM_NOISE,
     GEOMETRIC_SHAPES,
     GRADIENT,
-    PATTERN
+    PATTERN,
+    PERLIN_NOISE,
+    WORLEY_NOISE
 };
 
+enum class ShapeKind {
+    RECTANGLE,
+    CIRCLE
+};
+
+// Label for one drawn shape. The mask covers the pixels still visible once later shapes
+// are drawn, as COCO uncompressed RLE: column-major run lengths starting with a 0-run.
+struct ShapeAnnotation {
+    ShapeKind kind;
+    RGBPixel color;
+    int bboxX;
+    int bboxY;
+    int bboxWidth;
+    int bboxHeight;
+    int area;
+    std::vector<int> rleCounts;
+};
+
+struct ImageAnnotation {
+    int width = 0;
+    int height = 0;
+    std::vector<ShapeAnnotation> shapes;
+};
+
+// Outcome of writing one image file
+struct ImageWriteResult {
+    int index;
+    std::string filename;
+    bool success;
+    std::string error;
+};
+
+// Totals for a streaming run; failures keep the per-file details
+struct ImageStreamSummary {
+    int written = 0;
+    int failed = 0;
+    std::vector<ImageWriteResult> failures;
+};
+
+// Called once per file, serialized across workers
+using ImageProgressCallback = std::function<void(const ImageWriteResult&)>;
+
 class ImageData {
 public:
     ImageData(int numImage, int width, int height, int channels);
 
     void setImageType(ImageType type);
+    // UINT16 and FLOAT32 images export as 16-bit PPM and PFM respectively
+    void setPixelFormat(PixelFormat format);
+    // frequency = lattice cells across the image width for the first octave; frequency,
+    // lacunarity and gain must be positive and octaves at least 1 (std::invalid_argument)
+    void setNoiseParameters(float frequency, int octaves, float lacunarity = 2.0f, float gain = 0.5f);
+    // 0 = one worker per hardware thread
+    void setNumThreads(int threads);
+    // Augment each image right after it is rendered
+    void setAugmenter(const ImageAugmenter& augmenter);
+    // Record masks and boxes for GEOMETRIC_SHAPES while they are rasterized
+    void setAnnotationsEnabled(bool enabled);
     void generate();
     void exportToDirectory(const std::string& directory) const;
+    // COCO-style JSON for the annotations of the last generate() call
+    void exportAnnotations(const std::string& filename) const;
+
+    // Streaming mode: each worker renders, encodes and writes one image at a time into a
+    // recycled buffer, so peak memory is bounded by threads x image size. Nothing is kept
+    // in getImages(). With annotations enabled they are written to annotations.json.
+    ImageStreamSummary generateToDirectory(const std::string& directory,
+        const ImageProgressCallback& onProgress = nullptr);
     
     std::vector<Image> getImages() const;
+    std::vector<ImageAnnotation> getAnnotations() const;
     
 private:
-    Image generateRandomNoise();
-    Image generateGeometricShapes();
-    Image generateGradientImage();
-    Image generatePatternImage();
+    // Render image `index` from its own RNG stream into canvas (reusing its storage); when
+    // augmenting, the result lands in augmented. Returns the buffer holding the final image.
+    Image& renderImage(int index, unsigned int batchSeed, int rowThreads, Image& canvas, Image& augmented,
+        ImageAnnotation* annotation) const;
+
+    // Generators are instantiated per sample type and channel count (see visitImage)
+    template<typename T, int C>
+    void generateRandomNoise(ImageView<T, C> img, std::mt19937& rng) const;
+    template<typename T, int C>
+    void generateGeometricShapes(ImageView<T, C> img, std::mt19937& rng, ImageAnnotation* annotation) const;
+    template<typename T, int C>
+    void generateGradientImage(ImageView<T, C> img, std::mt19937& rng) const;
+    template<typename T, int C>
+    void generatePatternImage(ImageView<T, C> img, std::mt19937& rng) const;
+    template<typename T, int C, typename Noise>
+    void generateNoiseTexture(ImageView<T, C> img, const Noise& noise, std::mt19937& rng, int rowThreads) const;
+
+    std::string imageFileName(const std::string& directory, size_t index) const;
+    static void writeImageFile(const std::string& filename, const Image& img, std::vector<unsigned char>& buffer);
+    // COCO JSON for the images; if written is given, only images with a nonzero entry
+    void writeAnnotations(const std::string& filename, const std::vector<ImageAnnotation>& annotations,
+        const std::vector<unsigned char>* written = nullptr) const;
+    void checkAnnotationSupport() const;
     
     std::vector<Image> images;
+    std::vector<ImageAnnotation> annotations;
     int numImages;
     int width;
     int height;
     int channels;
     ImageType imageType;
+    PixelFormat pixelFormat;
+    float noiseFrequency;
+    FractalParameters fractalParameters;
+    int numThreads;
+    std::optional<ImageAugmenter> augmenter;
+    bool annotationsEnabled;
 };
 
 #endif // !IMAGE_DATA_H
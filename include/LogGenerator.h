@@ -0,0 +1,97 @@
+#ifndef LOG_GENERATOR_H
+#define LOG_GENERATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "StreamSink.h"
+#include "TemplateEngine.h"
+
+enum class LogFormat {
+    SYSLOG,          // RFC 5424
+    JSON,            // one object per line
+    APACHE_COMBINED  // Apache/NGINX combined access log
+};
+
+struct LogConfig {
+    LogFormat format = LogFormat::JSON;
+    // Custom line layout overriding the format's preset: literal text with $field
+    // placeholders ($$ for a dollar sign). Fields: timestamp (ISO-8601 UTC), epoch_ms,
+    // clf_time, level, priority, host, service, pid, ip, uuid, latency (ms), method,
+    // path, status, bytes, referrer, user_agent, message.
+    std::string pattern;
+    // Time of line 0 in milliseconds since the Unix epoch; later lines advance
+    // monotonically with random spacing at this average rate
+    std::int64_t startTimeMs = 1767225600000;  // 2026-01-01T00:00:00Z
+    double linesPerSecond = 1000.0;
+    // Relative weights of DEBUG, INFO, WARN, ERROR and FATAL
+    std::vector<double> levelWeights = { 10.0, 75.0, 10.0, 4.0, 1.0 };
+    // Log-normal request latency
+    double latencyMedianMs = 25.0;
+    double latencySigma = 0.8;
+    int numHosts = 16;
+    std::vector<std::string> services = { "api", "auth", "billing", "search", "worker" };
+    // Message templates in TextData template syntax; empty uses the built-in set. Slots
+    // given here are added to (or replace) the built-in message slots.
+    std::vector<std::string> messageTemplates;
+    std::unordered_map<std::string, TemplateSlot> messageSlots;
+};
+
+// Structured log-line generator. The line layout is compiled once into a plan of
+// literal runs and field ops, so rendering a line is one pass of raw writes into a
+// buffer sized for the longest possible line. Lines are produced in blocks of
+// BLOCK_LINES, each from its own random stream and with timestamps computed from the
+// line index, so blocks render independently on any number of threads and still
+// concatenate into one monotonic log.
+class LogGenerator {
+public:
+    static constexpr size_t BLOCK_LINES = 4096;
+
+    explicit LogGenerator(const LogConfig& config);
+
+    // Append `count` lines (at most BLOCK_LINES) of block `block`, each ending in '\n'.
+    // lineEnds, if given, receives the size of out after each line.
+    void renderBlock(std::uint64_t block, size_t count, unsigned int seed, std::string& out,
+        std::vector<size_t>* lineEnds = nullptr) const;
+
+    // Render `lines` lines (0 = until stopped) on numThreads threads and write them in
+    // order, rendering the next batch while the previous one is written. Returns the
+    // number of lines written; it is short if stop was set or the reader went away.
+    std::uint64_t write(StreamSink& sink, std::uint64_t lines, unsigned int seed, int numThreads = 0,
+        const std::atomic<bool>* stop = nullptr) const;
+
+private:
+    enum class Field {
+        LITERAL, TIMESTAMP, EPOCH_MS, CLF_TIME, LEVEL, PRIORITY, HOST, SERVICE, PID, IP,
+        UUID, LATENCY, METHOD, PATH, STATUS, BYTES, REFERRER, USER_AGENT, MESSAGE
+    };
+    struct Op {
+        Field field;
+        std::uint32_t offset;  // LITERAL: run of literals
+        std::uint32_t length;
+    };
+    struct RenderState;
+
+    // Write one line (without its newline) at out and return its end
+    char* renderLine(std::uint64_t line, RenderState& state, char* out) const;
+
+    std::vector<Op> plan;
+    std::string literals;
+    size_t maxLineLength;  // bound on one rendered line, for the raw line buffer
+    bool escapeJson;
+    std::int64_t startTimeUs;
+    double intervalUs;
+    // Latency quantiles (ms) at evenly spaced probabilities, interpolated per draw
+    std::vector<double> latencyQuantiles;
+    std::vector<float> levelProbability;
+    std::vector<std::uint32_t> levelAlias;
+    std::vector<std::string> hosts;
+    std::vector<std::string> services;
+    std::shared_ptr<const TemplateEngine> messages;
+};
+
+#endif // LOG_GENERATOR_H
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, a file mapping on Windows).
+// Pages are loaded lazily by the OS, so opening even multi-GB files is instant.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void release();
+
+    const char* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,109 @@
+#ifndef MARKOV_MODEL_H
+#define MARKOV_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+// Order-n word Markov model over integer token IDs. Built once (from a word sequence or
+// by training on corpus files), then read-only, so one instance can be shared by any
+// number of generating threads. All tables are flat POD arrays:
+//   - vocabulary: word characters plus offsets, indexed by token ID
+//   - states: n token IDs per state, found through an open-addressing hash table
+//   - transitions: CSR rows (one per state) of next tokens with per-row alias tables,
+//     so each step is one hash probe plus an O(1) weighted draw
+// Unseen contexts back off to the unigram distribution. Because the tables are plain
+// arrays, save() writes them as-is and load() samples straight from a memory mapping.
+class MarkovModel {
+public:
+    // Count the (n + 1)-grams of words taken as one running sequence
+    MarkovModel(const std::vector<std::string>& words, int order);
+
+    // Train on text files. Each file is memory-mapped, split into chunks at whitespace
+    // and tokenized in parallel; the per-chunk n-gram counts are then merged. Tokens are
+    // whitespace-separated, ASCII-lowercased, with surrounding punctuation stripped.
+    // n-grams do not span files.
+    static MarkovModel trainFromFiles(const std::vector<std::string>& filenames, int order, int numThreads = 0);
+
+    // Binary model file in host byte order; load() maps it instead of reading it and
+    // checks every table once, throwing std::runtime_error if one is inconsistent
+    void save(const std::string& filename) const;
+    static MarkovModel load(const std::string& filename);
+
+    MarkovModel(MarkovModel&&) = default;
+    MarkovModel& operator=(MarkovModel&&) = default;
+    MarkovModel(const MarkovModel&) = delete;
+    MarkovModel& operator=(const MarkovModel&) = delete;
+
+    int getOrder() const;
+    size_t vocabularySize() const;
+    size_t numStates() const;
+    std::string_view word(std::uint32_t id) const;
+
+    // Fill context[0, order) with a state drawn in proportion to its frequency
+    void sampleStart(std::mt19937& rng, std::uint32_t* context) const;
+    // Draw the token following context[0, order)
+    std::uint32_t sampleNext(const std::uint32_t* context, std::mt19937& rng) const;
+
+private:
+    // Read-only view of one table, either into tables below or into a mapped file
+    template<typename T>
+    struct Array {
+        const T* data = nullptr;
+        size_t size = 0;
+        const T& operator[](size_t i) const { return data[i]; }
+    };
+
+    // Storage of a model built in memory (empty when loaded from a file)
+    struct Tables {
+        std::vector<std::uint64_t> wordOffsets;  // vocabularySize() + 1 entries
+        std::vector<char> wordChars;
+        std::vector<std::uint32_t> stateTokens;  // numStates() * order
+        std::vector<std::uint32_t> stateSlots;   // hash table of state index + 1 (0 = empty)
+        std::vector<std::uint64_t> rowOffsets;   // numStates() + 1 entries
+        std::vector<std::uint32_t> nextTokens;
+        std::vector<float> nextProbability;
+        std::vector<std::uint32_t> nextAlias;    // row-local indices
+        // Alias tables over states (weighted by occurrences) and over the vocabulary
+        std::vector<float> startProbability;
+        std::vector<std::uint32_t> startAlias;
+        std::vector<float> unigramProbability;
+        std::vector<std::uint32_t> unigramAlias;
+    };
+
+    explicit MarkovModel(int order);
+
+    // Build the tables from a vocabulary and lexicographically sorted (n + 1)-gram counts
+    void build(const std::vector<std::string>& vocabulary, const std::vector<double>& unigramCounts,
+        const std::vector<std::uint32_t>& grams, const std::vector<std::uint64_t>& gramCounts);
+    // Point the views at the owned tables
+    void bind();
+
+    // Index of the state for context, or -1
+    std::int64_t findState(const std::uint32_t* context) const;
+    std::uint64_t hashContext(const std::uint32_t* context) const;
+
+    int order;
+    Tables tables;
+    std::unique_ptr<MappedFile> mapping;
+
+    Array<std::uint64_t> wordOffsets;
+    Array<char> wordChars;
+    Array<std::uint32_t> stateTokens;
+    Array<std::uint32_t> stateSlots;
+    Array<std::uint64_t> rowOffsets;
+    Array<std::uint32_t> nextTokens;
+    Array<float> nextProbability;
+    Array<std::uint32_t> nextAlias;
+    Array<float> startProbability;
+    Array<std::uint32_t> startAlias;
+    Array<float> unigramProbability;
+    Array<std::uint32_t> unigramAlias;
+};
+
+#endif // MARKOV_MODEL_H
@@ -0,0 +1,49 @@
+#ifndef NOISE_GENERATORS_H
+#define NOISE_GENERATORS_H
+
+#include <array>
+#include <random>
+
+// Octave (fBm) controls shared by the procedural noise generators
+struct FractalParameters {
+    int octaves = 4;
+    float lacunarity = 2.0f;
+    float gain = 0.5f;
+};
+
+// Perlin gradient noise. The permutation and gradient tables are built once from
+// the given RNG stream, so each instance is an independent, read-only noise field.
+class GradientNoise {
+public:
+    explicit GradientNoise(std::mt19937& rng);
+
+    // Add amplitude * noise(x0 + i * dx, y) to out[i] for i in [0, count), values in [-1, 1]
+    void addRow(float y, float x0, float dx, int count, float amplitude, float* out) const;
+
+    // Fill out[i] with normalized fBm in [-1, 1] over one row
+    void fractalRow(float y, float x0, float dx, int count, const FractalParameters& params, float* out) const;
+
+private:
+    std::array<int, 512> permutation;
+    std::array<float, 256> gradientX;
+    std::array<float, 256> gradientY;
+};
+
+// Worley (cellular) noise using one jittered feature point per lattice cell, F1 distance
+class CellularNoise {
+public:
+    explicit CellularNoise(std::mt19937& rng);
+
+    // Add amplitude * noise(x0 + i * dx, y) to out[i] for i in [0, count), values in [-1, 1]
+    void addRow(float y, float x0, float dx, int count, float amplitude, float* out) const;
+
+    // Fill out[i] with normalized fBm in [-1, 1] over one row
+    void fractalRow(float y, float x0, float dx, int count, const FractalParameters& params, float* out) const;
+
+private:
+    std::array<int, 512> permutation;
+    std::array<float, 256> jitterX;
+    std::array<float, 256> jitterY;
+};
+
+#endif // NOISE_GENERATORS_H
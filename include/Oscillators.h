@@ -0,0 +1,63 @@
+#ifndef OSCILLATORS_H
+#define OSCILLATORS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Waveform {
+    SINE,
+    SQUARE,
+    SAWTOOTH,
+    TRIANGLE
+};
+
+enum class SweepType {
+    LINEAR,
+    EXPONENTIAL
+};
+
+// Band-limited oscillator driven by a double-precision phase accumulator (in cycles).
+// Samples are produced in fixed-size blocks: the block's phase and frequency are taken
+// from the accumulator, per-sample phases are laid out from precomputed offset tables,
+// and the waveform is shaped in flat loops the compiler can vectorize. The phase is
+// re-anchored every block, so there is no drift over long renders.
+// Square, sawtooth and triangle are band-limited with PolyBLEP / PolyBLAMP corrections.
+class Oscillator {
+public:
+    // phase is the starting phase in cycles [0, 1)
+    Oscillator(Waveform waveform, double frequency, double sampleRate, double phase = 0.0);
+
+    // Sweep from the starting frequency to endFrequency over the next `duration` samples,
+    // then hold endFrequency. Exponential sweeps keep a constant ratio per sample.
+    void setSweep(double endFrequency, std::int64_t duration, SweepType type);
+
+    // Write amplitude * waveform to out[0, count) and advance the oscillator
+    void render(float* out, size_t count, float amplitude = 1.0f);
+
+    double getPhase() const;
+    // Instantaneous frequency at the next sample
+    double getFrequency() const;
+
+private:
+    // Lay out phases and per-sample increments for `count` samples (count <= block size)
+    void fillBlock(size_t count, float* phases, float* increments);
+    double incrementAt(std::int64_t position) const;
+
+    Waveform waveform;
+    double sampleRate;
+    double startIncrement;
+    double endIncrement;
+    bool sweeping;
+    SweepType sweepType;
+    std::int64_t sweepLength;
+    // log of the per-sample increment ratio for exponential sweeps
+    double logRatio;
+    std::int64_t position;
+    double phase;
+    // Phase offsets of sample k within a block, relative to the block's increment
+    std::vector<double> offsetTable;
+    std::vector<double> ratioTable;
+};
+
+#endif // OSCILLATORS_H
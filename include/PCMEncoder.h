@@ -0,0 +1,36 @@
+#ifndef PCM_ENCODER_H
+#define PCM_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+enum class SampleFormat {
+    PCM16,
+    PCM24,
+    PCM32,
+    FLOAT32
+};
+
+// Block float -> little-endian integer PCM conversion. Samples are scaled to full
+// scale, optionally TPDF-dithered, rounded and saturated (so values beyond +/-1.0
+// clip instead of wrapping). The dither noise is a hash of the running sample index,
+// so the output does not depend on how the stream is split into blocks.
+// FLOAT32 passes samples through unchanged (IEEE float, no dither or clipping).
+class PCMEncoder {
+public:
+    explicit PCMEncoder(SampleFormat format, bool dither = false, std::uint32_t seed = 0);
+
+    static int bitsPerSample(SampleFormat format);
+    int bytesPerSample() const;
+
+    // Encode count samples into out, which must hold count * bytesPerSample() bytes
+    void encode(const float* in, size_t count, unsigned char* out);
+
+private:
+    SampleFormat format;
+    bool dither;
+    std::uint32_t seed;
+    std::uint64_t position;
+};
+
+#endif // PCM_ENCODER_H
@@ -0,0 +1,69 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+class Parallel {
+public:
+    // Resolve a requested thread count (0 = one per hardware thread)
+    static int resolveThreadCount(int requested);
+
+    // Split [begin, end) into contiguous chunks and run fn(chunkBegin, chunkEnd) on each.
+    // The calling thread takes the first chunk; exceptions from workers are rethrown here.
+    template<typename Fn>
+    static void forRange(size_t begin, size_t end, int numThreads, Fn&& fn) {
+        if (begin >= end) {
+            return;
+        }
+
+        size_t total = end - begin;
+        size_t threads = std::min(static_cast<size_t>(resolveThreadCount(numThreads)), total);
+        if (threads <= 1) {
+            fn(begin, end);
+            return;
+        }
+
+        size_t chunk = (total + threads - 1) / threads;
+        std::vector<std::thread> workers;
+        std::vector<std::exception_ptr> errors(threads);
+        workers.reserve(threads - 1);
+
+        for (size_t t = 1; t < threads; ++t) {
+            size_t chunkBegin = begin + t * chunk;
+            size_t chunkEnd = std::min(end, chunkBegin + chunk);
+            if (chunkBegin >= chunkEnd) {
+                break;
+            }
+            workers.emplace_back([&fn, &errors, t, chunkBegin, chunkEnd]() {
+                try {
+                    fn(chunkBegin, chunkEnd);
+                }
+                catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            });
+        }
+
+        try {
+            fn(begin, std::min(end, begin + chunk));
+        }
+        catch (...) {
+            errors[0] = std::current_exception();
+        }
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+};
+
+#endif // PARALLEL_H
@@ -2,6 +2,7 @@
 #define RANDOM_GENERATORS_H
 
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,11 @@ public:
     // Double random number generation
     static double getRandomDouble(double min, double max);
 
+    // Overloads drawing from a caller-owned generator, for per-thread RNG streams
+    static int getRandomInt(std::mt19937& rng, int min, int max);
+    static float getRandomFloat(std::mt19937& rng, float min, float max);
+    static double getRandomDouble(std::mt19937& rng, double min, double max);
+
     // Boolean random generation
     static bool getRandomBool(double trueProbability = 0.5);
 
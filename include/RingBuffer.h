@@ -0,0 +1,71 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// Single-producer / single-consumer lock-free ring buffer. One thread may call write()
+// and another read() concurrently without locks: each side owns one index, publishes
+// it with a release store and reads the other's with an acquire load. The indices run
+// freely and are masked into a power-of-two array, while at most capacity() items are
+// held at once, so the requested capacity is an exact bound on buffered data.
+template<typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity)
+        : limit(capacity), head(0), tail(0) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Ring buffer capacity must be positive");
+        }
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        items.resize(size);
+        mask = size - 1;
+    }
+
+    size_t capacity() const { return limit; }
+
+    // Items currently buffered; exact on the consumer side, a lower bound on the producer side
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    // Producer: copy up to count items in, returns how many fit
+    size_t write(const T* in, size_t count) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_acquire);
+        const size_t n = std::min(count, limit - (h - t));
+        const size_t first = std::min(n, items.size() - (h & mask));
+        std::copy(in, in + first, items.begin() + (h & mask));
+        std::copy(in + first, in + n, items.begin());
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: copy up to count items out, returns how many were available
+    size_t read(T* out, size_t count) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        const size_t h = head.load(std::memory_order_acquire);
+        const size_t n = std::min(count, h - t);
+        const size_t first = std::min(n, items.size() - (t & mask));
+        std::copy(items.begin() + (t & mask), items.begin() + (t & mask) + first, out);
+        std::copy(items.begin(), items.begin() + (n - first), out + first);
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask;
+    size_t limit;
+    // Each index sits on its own cache line so the two threads don't false-share
+    alignas(64) std::atomic<size_t> head;  // next slot to write, owned by the producer
+    alignas(64) std::atomic<size_t> tail;  // next slot to read, owned by the consumer
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,38 @@
+#ifndef STREAM_SINK_H
+#define STREAM_SINK_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+enum class StreamTarget {
+    STDOUT,
+    FIFO,         // named pipe, created if missing (POSIX only)
+    UNIX_SOCKET,  // connects to a listening SOCK_STREAM socket (POSIX only)
+    REGULAR_FILE  // created or truncated
+};
+
+// Blocking byte sink for streamed output. A closed socket is reported by write()
+// returning false without raising SIGPIPE. A broken FIFO or stdout pipe is reported the
+// same way only if the process ignores SIGPIPE, which is left to the application.
+class StreamSink {
+public:
+    StreamSink(StreamTarget target, const std::string& path);
+    ~StreamSink();
+
+    StreamSink(const StreamSink&) = delete;
+    StreamSink& operator=(const StreamSink&) = delete;
+
+    // Write all bytes; false once the reader has gone away
+    bool write(const unsigned char* data, size_t size);
+
+private:
+    StreamTarget target;
+    int fd;
+    bool ownsDescriptor;
+#ifdef _WIN32
+    std::FILE* file;
+#endif
+};
+
+#endif // STREAM_SINK_H
@@ -0,0 +1,79 @@
+#ifndef TEMPLATE_ENGINE_H
+#define TEMPLATE_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Vocabulary of one template placeholder. Weights are relative; empty means uniform.
+struct TemplateSlot {
+    std::vector<std::string> words;
+    std::vector<double> weights;
+};
+
+// Templates compiled once into literal/slot token lists. A placeholder is $NAME, where
+// NAME is a run of A-Z, 0-9 and _, or ${Name} to delimit it explicitly; $$ is a literal
+// dollar sign. All literal text and slot words live in one character pool and each slot
+// has an alias table, so rendering is a single append pass with one O(1) draw per slot.
+// Read-only after construction, so one instance can be shared by generating threads.
+class TemplateEngine {
+public:
+    // Throws std::invalid_argument for unknown or empty slots and malformed placeholders
+    TemplateEngine(const std::vector<std::string>& templates,
+        const std::unordered_map<std::string, TemplateSlot>& slots);
+
+    // The NOUN, VERB and ADJECTIVE vocabularies used by the default templates
+    static std::unordered_map<std::string, TemplateSlot> defaultSlots();
+
+    size_t numTemplates() const { return templateTokens.size() - 1; }
+    // Words in a rendered template, counting each slot as one word (at least 1)
+    int wordCount(size_t index) const { return templateWords[index]; }
+
+    size_t pickTemplate(std::mt19937& rng) const;
+    // Append template index with its slots filled to out, and optionally the IDs of the
+    // rendered tokens (into tokenVocabulary()) to tokenIds
+    void render(size_t index, std::mt19937& rng, std::string& out,
+        std::vector<std::uint32_t>* tokenIds = nullptr) const;
+
+    // Raw-buffer variant for hot loops: writes at most maxLength() bytes at out and
+    // returns the end of the rendered text
+    char* render(size_t index, std::mt19937& rng, char* out) const;
+    // Longest possible rendering of any template
+    size_t maxLength() const { return longestRendering; }
+
+    // Distinct tokens of all templates: literal text split into words and single
+    // punctuation characters, plus each slot word whole
+    const std::vector<std::string>& tokenVocabulary() const { return vocabulary; }
+
+private:
+    // A literal run of pool characters, or a slot to draw a word from
+    struct Token {
+        std::uint32_t slot;  // LITERAL or an index into slotWords
+        std::uint32_t offset;
+        std::uint32_t length;
+        std::uint32_t firstToken;  // literal: range of literalTokens
+        std::uint32_t tokenCount;
+    };
+    static const std::uint32_t LITERAL = 0xffffffffu;
+
+    std::string pool;
+    std::vector<Token> tokens;
+    std::vector<std::uint32_t> templateTokens;  // numTemplates() + 1 token offsets
+    std::vector<int> templateWords;
+    size_t longestRendering;
+    std::vector<std::string> vocabulary;
+    std::vector<std::uint32_t> literalTokens;
+
+    // Slot s owns words [slotWords[s], slotWords[s + 1]) of the arrays below
+    std::vector<std::uint32_t> slotWords;
+    std::vector<std::uint32_t> wordOffsets;
+    std::vector<std::uint32_t> wordLengths;
+    std::vector<float> wordProbability;
+    std::vector<std::uint32_t> wordAlias;  // slot-local indices
+    std::vector<std::uint32_t> wordTokens;
+};
+
+#endif // TEMPLATE_ENGINE_H
@@ -1,16 +1,39 @@
 #ifndef TEXT_DATA_H
 #define TEXT_DATA_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include<unordered_map>	
+#include <atomic>
+#include <memory>
+#include "MarkovModel.h"
+#include "TemplateEngine.h"
+#include "ZipfVocabulary.h"
+#include "LogGenerator.h"
 
 
 enum class TextType {
 	LOREM_IPSUM,
 	RANDOM_WORDS,
 	MARKOV_CHAIN,
-	TEMPLATE_BASED
+	TEMPLATE_BASED,
+	LOG_LINES	// syslog, JSON or Apache access-log lines, one per sample (see LogGenerator)
+};
+
+enum class TokenWidth {
+	AUTO,    // 16-bit when the vocabulary fits, else 32-bit
+	UINT16,
+	UINT32
+};
+
+struct TokenExportConfig {
+	TokenWidth width = TokenWidth::AUTO;
+	// Pack the token stream into rows of this many tokens (0 keeps one flat stream)
+	int sequenceLength = 0;
+	// Drop the final partial row instead of filling it with PAD_TOKEN
+	bool dropRemainder = false;
 };
 
 class TextData {
@@ -18,28 +41,102 @@ public:
 	TextData(int numSamples, int wordsPerSample);
 
 	void setTextType(TextType type);
+	// Templates use $NAME placeholders; samples chain templates up to wordsPerSample words
 	void setTemplates(const std::vector<std::string>& templates);
+	// Define or replace a placeholder vocabulary; empty weights mean uniform
+	void setTemplateSlot(const std::string& name, const std::vector<std::string>& words,
+		const std::vector<double>& weights = {});
+	// The compiled templates, built on first use
+	std::shared_ptr<const TemplateEngine> getTemplateEngine();
 	void setWordList(const std::vector<std::string>& wordList);
+	// Draw RANDOM_WORDS from a synthetic Zipf-distributed vocabulary of up to 2^32 - 1
+	// words instead of the word list (until the next setWordList)
+	void setZipfVocabulary(std::uint64_t size, double exponent = 1.0);
+	// Context length of MARKOV_CHAIN text (1 by default)
+	void setMarkovOrder(int order);
+	// Train the MARKOV_CHAIN model on text files at the current order, or map a saved one
+	void trainMarkovModel(const std::vector<std::string>& corpusFiles, int numThreads = 0);
+	void loadMarkovModel(const std::string& filename);
+	// Use a prebuilt model; it is read-only, so several TextData objects may share one
+	void setMarkovModel(std::shared_ptr<const MarkovModel> model);
+	// The model MARKOV_CHAIN samples from, built from the word list on first use
+	std::shared_ptr<const MarkovModel> getMarkovModel();
+	// Format, rates and vocabularies of LOG_LINES
+	void setLogConfig(const LogConfig& config);
+	std::shared_ptr<const LogGenerator> getLogGenerator();
+	// Write LOG_LINES straight to a sink (lines = 0: until stop is set or the reader
+	// closes) without keeping them in memory; returns the number of lines written
+	std::uint64_t streamLogLines(std::uint64_t lines, StreamTarget target, const std::string& path,
+		int numThreads = 0, const std::atomic<bool>* stop = nullptr);
 	void generate();
 	void exportToFile(const std::string& fileName) const;
+	size_t getSampleCount() const;
+	// View into the sample arena, valid until the next generate()
+	std::string_view getTextSample(size_t index) const;
+	// Copies of all samples; prefer getTextSample for large runs
 	std::vector<std::string> getTextSamples() const;
 
+	// Reserved IDs of the token vocabulary
+	static constexpr std::uint32_t EOS_TOKEN = 0;
+	static constexpr std::uint32_t PAD_TOKEN = 1;
+	// Record the token IDs of the words and punctuation each generator picks, so the
+	// samples can be exported pre-tokenized. Tokens are the generator's own words, before
+	// sentence capitalization; every sample ends with EOS_TOKEN.
+	void setRecordTokens(bool record);
+	size_t getTokenVocabularySize() const;
+	std::string getToken(std::uint32_t id) const;
+	// Write <prefix>.tokens.npy (the stream, or rows x sequenceLength when packed),
+	// <prefix>.docs.npy (uint64 start of each sample in the stream, plus the total) and
+	// <prefix>.vocab.txt (one token per line, line n is ID n). The .npy files can be
+	// memory-mapped directly, e.g. numpy.load(path, mmap_mode='r').
+	void exportTokens(const std::string& prefix, const TokenExportConfig& config = {}) const;
+
 private:
     int numSamples;
     int wordsPerSample;
     TextType textType;
     std::vector<std::string> templates;
     std::vector<std::string> wordList;
-    std::vector<std::string> textSamples;
+    // Every sample followed by the first separatorLength characters of SEPARATOR
+    // (one newline for log lines); sample i starts at sampleOffsets[i]
+    std::string textArena;
+    std::vector<size_t> sampleOffsets;
+    size_t separatorLength;
+    int markovOrder;
+    std::shared_ptr<const MarkovModel> markovModel;
+    std::unordered_map<std::string, TemplateSlot> templateSlots;
+    std::shared_ptr<const TemplateEngine> templateEngine;
+    std::shared_ptr<const ZipfVocabulary> zipfVocabulary;
+    LogConfig logConfig;
+    std::shared_ptr<const LogGenerator> logGenerator;
+
+    // Token recording: one stream for all samples, documentOffsets as for sampleOffsets
+    bool recordTokens;
+    std::vector<std::string> tokenVocabulary;
+    // Zipf words are not materialized: IDs from tokenVocabulary.size() on are their ranks
+    std::shared_ptr<const ZipfVocabulary> tokenZipf;
+    std::unordered_map<std::string, std::uint32_t> tokenLookup;
+    std::vector<std::uint32_t> sourceTokens;  // generator word index -> token ID
+    std::uint32_t periodToken, questionToken, exclamationToken;
+    std::vector<std::uint32_t> tokenStream;
+    std::vector<std::uint64_t> documentOffsets;
+
+    // Reset the stream and map the current generator's words to token IDs
+    void prepareTokens();
+    std::uint32_t addToken(const std::string& token);
 
-    std::string generateLoremIpsum();
-    std::string generateRandomWords();
-    std::string generateMarkovChain() ;
-    std::string generateTemplateBasedText();
+    // Each generator appends one sample to out
+    void appendLoremIpsum(std::string& out);
+    void appendRandomWords(std::string& out);
+    void appendMarkovChain(std::string& out);
+    void appendTemplateBasedText(std::string& out);
+    // Render numSamples log lines into the arena in parallel
+    void generateLogLines();
 
     static const std::vector<std::string> loremIpsumWords;
     static const std::vector<std::string> defaultWordList;
     static const std::vector<std::string> defaultTemplates;
+    static const char SEPARATOR[];
 
 };
 
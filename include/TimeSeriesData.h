@@ -4,13 +4,43 @@
 #include <vector>
 #include<string>
 #include <ctime>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <random>
+#include "CholeskyFactor.h"
+#include "DateTime.h"
 
 enum class TimeSeriesPattern {
 	RANDOM_WALK,
 	TREND,
 	SEASONAL,
 	CYCLICAL,
-	COMBINED
+	COMBINED,
+	AUTOREGRESSIVE,   // AR(p) around a mean
+	ARMA,             // ARMA(p, q) around a mean
+	GARCH,            // GARCH(1, 1) returns with clustered volatility
+	REGIME_SWITCHING  // mean and volatility set by a hidden Markov chain shared by all dimensions
+};
+
+// Parameters of the stochastic process patterns, applied to every dimension. Their
+// innovations are standard normal (correlated if a matrix is set).
+struct ProcessConfig {
+	double mean = 0.0;
+	// AR/ARMA: x_t - mean = sum phi_i (x_{t-i} - mean) + e_t + sum theta_j e_{t-j}, e ~ N(0, noiseStddev^2)
+	std::vector<double> arCoefficients = { 0.6, 0.2 };
+	std::vector<double> maCoefficients = { 0.3 };  // ARMA only
+	double noiseStddev = 1.0;
+	// GARCH: r_t = mean + e_t, e_t = sigma_t z_t, sigma^2_t = omega + alpha e^2_{t-1} + beta sigma^2_{t-1}
+	double garchOmega = 0.05;
+	double garchAlpha = 0.1;
+	double garchBeta = 0.85;
+	// Regime switching: x_t = regimeMeans[s_t] + regimeStddevs[s_t] z_t, with row s of the
+	// row-major transition matrix giving the probabilities of s_{t+1}
+	std::vector<double> regimeMeans = { 0.0, 3.0 };
+	std::vector<double> regimeStddevs = { 0.5, 1.5 };
+	std::vector<double> regimeTransitions = { 0.98, 0.02, 0.05, 0.95 };
 };
 
 struct TimePoint {
@@ -18,29 +48,148 @@ struct TimePoint {
 	std::vector<double> values;
 };
 
+// Consecutive points of a stream, values stored point by point
+struct TimeSeriesBlock {
+	std::uint64_t firstIndex = 0;
+	int dimensions = 0;
+	std::vector<std::time_t> timestamps;
+	std::vector<double> values;  // values[i * dimensions + d]
+
+	size_t size() const { return timestamps.size(); }
+	const double* point(size_t i) const { return values.data() + i * dimensions; }
+};
+
+class TimeSeriesData;
+
+// Pull-based generator producing a series block by block. Pattern state (walk
+// positions, oscillator phases) carries from one block to the next, so memory is
+// O(block x dimensions) however long the series runs, and the points do not depend
+// on the block size. With a correlation matrix the innovations of each point are
+// Gaussian, mixed across dimensions by its Cholesky factor one block at a time.
+class TimeSeriesStream {
+public:
+	static constexpr size_t DEFAULT_BLOCK_POINTS = 4096;
+
+	// numPoints = 0 streams without end
+	TimeSeriesStream(const TimeSeriesData& source, unsigned int seed, std::uint64_t numPoints = 0,
+		size_t blockPoints = DEFAULT_BLOCK_POINTS);
+
+	// Fill block with the next points; returns how many, 0 once the stream is finished
+	size_t nextBlock(TimeSeriesBlock& block);
+
+	std::uint64_t position() const { return nextIndex; }
+	bool finished() const { return numPoints != 0 && nextIndex >= numPoints; }
+
+	// Input iterator over the remaining blocks; every step refills the same block
+	class iterator {
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using value_type = TimeSeriesBlock;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const TimeSeriesBlock*;
+		using reference = const TimeSeriesBlock&;
+
+		explicit iterator(TimeSeriesStream* stream = nullptr) : stream(stream) {}
+		reference operator*() const { return stream->current; }
+		pointer operator->() const { return &stream->current; }
+		iterator& operator++();
+		bool operator==(const iterator& other) const { return stream == other.stream; }
+		bool operator!=(const iterator& other) const { return stream != other.stream; }
+
+	private:
+		TimeSeriesStream* stream;
+	};
+
+	iterator begin();
+	iterator end() { return iterator(); }
+
+private:
+	// Move every oscillator on to point index
+	void advanceOscillators(std::uint64_t index);
+	// Run the process recurrences over a block of innovation rows
+	void generateProcess(const double* innovations, size_t count, double* out);
+
+	TimeSeriesPattern pattern;
+	int dimensions;
+	std::time_t startTime;
+	int timeStepSeconds;
+	std::uint64_t numPoints;
+	size_t blockPoints;
+	std::uint64_t nextIndex;
+	std::mt19937 rng;
+	// Pattern state, one array per field so each point updates all dimensions in one
+	// contiguous loop
+	std::vector<double> level;      // random walk positions
+	std::vector<double> intercept;
+	std::vector<double> slope;
+	std::vector<double> amplitude;
+	std::vector<double> frequency;  // radians per point
+	std::vector<double> phase;      // oscillator phases at the last resync point, in [0, 2 pi)
+	std::vector<double> sinPhase;   // oscillators at nextIndex
+	std::vector<double> cosPhase;
+	std::vector<double> stepSin;    // rotation by one point
+	std::vector<double> stepCos;
+	// Process state: rings of the last p centred values and q innovations, one row of
+	// dimensions per lag; GARCH variance and residual; the shared regime, which moves on
+	// its own generator so the draws never depend on the block size
+	ProcessConfig process;
+	std::vector<double> history;
+	std::vector<double> shocks;
+	size_t historyNext;
+	size_t shocksNext;
+	std::vector<double> variance;
+	std::vector<double> residual;
+	std::vector<double> scratch;
+	int regime;
+	std::mt19937 regimeRng;
+
+	std::shared_ptr<const CholeskyFactor> correlation;
+	// Innovations of one block, one row of dimensions per point and component, with
+	// the variance of uniform [-1, 1) noise (unit variance for process patterns)
+	std::vector<double> noise;
+	std::vector<double> independent;  // unmixed draws when correlated
+	TimeSeriesBlock current;
+};
+
 class TimeSeriesData {
 public:
 	TimeSeriesData(int numPoints, int dimensions);
 	void setPattern(TimeSeriesPattern pattern);
 	void setStartTime(std::time_t startTime);
 	void setTimeStep(int timeStepSeconds);
+	// Timestamp column of exportToCSV; defaults to local "YYYY-MM-DD HH:MM:SS"
+	void setTimestampFormat(TimestampFormat format, TimeZone zone = TimeZone::LOCAL);
+	// Correlate the innovations of the dimensions: a dimensions x dimensions row-major
+	// correlation matrix, factored here; empty makes them independent again
+	void setCorrelation(const std::vector<double>& matrix);
+	// Parameters of AUTOREGRESSIVE, ARMA, GARCH and REGIME_SWITCHING; AR stationarity is
+	// not checked
+	void setProcessConfig(const ProcessConfig& config);
 	void generate();
 	void exportToCSV(const std::string& filename) const;
+	// Compressed, exact binary export; see TimeSeriesFile.h
+	void exportToBinary(const std::string& filename) const;
+
+	// Incremental generator over this configuration, seeded from the global generator;
+	// numPoints = 0 streams without end
+	TimeSeriesStream stream(std::uint64_t numPoints = 0,
+		size_t blockPoints = TimeSeriesStream::DEFAULT_BLOCK_POINTS) const;
 
 	std::vector<TimePoint> getTimeSeries() const;
 
 private:
+	friend class TimeSeriesStream;
+
 	int numPoints;
 	int dimensions;
 	TimeSeriesPattern pattern;
 	std::time_t startTime;
 	int timeStepSeconds;
+	TimestampFormat timestampFormat;
+	TimeZone timeZone;
+	std::shared_ptr<const CholeskyFactor> correlation;
+	ProcessConfig process;
 	std::vector<TimePoint> timeSeries;
-	std::vector<double> generateRandomWalk(int dimension);
-	std::vector<double> generateTrend(int dimension);
-	std::vector<double> generateSeasonal(int dimension);
-	std::vector<double> generateCyclical(int dimension);
-	std::vector<double> generateCombined(int dimension);
 };
 
 
@@ -0,0 +1,105 @@
+#ifndef TIME_SERIES_FILE_H
+#define TIME_SERIES_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "TimeSeriesData.h"
+
+// Compressed binary time-series files (.sdts). Points are stored in blocks of up to
+// blockPoints points; inside a block each column is its own bitstream: timestamps as
+// delta-of-delta codes, every dimension as Gorilla XOR codes of the raw IEEE-754 bits,
+// so values read back bit for bit. An index at the end of the file gives every
+// block's offset, first point and timestamp range for random access.
+//
+// Layout, in host byte order (checked by a byte order mark); bitstreams are MSB-first:
+//   header   magic "SDGTSBIN", version, byte order mark, dimensions, blockPoints,
+//            numPoints, numBlocks, indexOffset
+//   blocks   count, dimensions, firstTimestamp, byte size of each of the dimensions + 1
+//            columns, then the columns, each padded to whole bytes
+//   index    one entry per block
+
+struct TimeSeriesBlockInfo {
+    std::uint64_t offset;          // of the block header in the file
+    std::uint64_t firstIndex;      // point index of the block's first point
+    std::int64_t firstTimestamp;
+    std::int64_t lastTimestamp;
+    std::uint32_t count;
+    std::uint32_t bytes;           // header and columns
+};
+
+class TimeSeriesWriter {
+public:
+    static constexpr size_t DEFAULT_BLOCK_POINTS = 4096;
+
+    TimeSeriesWriter(const std::string& filename, int dimensions, size_t blockPoints = DEFAULT_BLOCK_POINTS);
+    // Closes the file if close() was not called; errors are then lost
+    ~TimeSeriesWriter();
+
+    TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+    TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+
+    // One point of dimensions values
+    void append(std::int64_t timestamp, const double* values);
+    void append(const TimeSeriesBlock& block);
+
+    // Write the last block, the index and the final header; throws std::runtime_error on
+    // a failed write
+    void close();
+
+    std::uint64_t pointsWritten() const { return numPoints; }
+
+private:
+    void flushBlock();
+
+    std::string filename;
+    std::ofstream file;
+    int dimensions;
+    size_t blockPoints;
+    std::uint64_t numPoints;
+    std::uint64_t offset;
+    bool closed;
+    // The pending block, values point by point
+    std::vector<std::int64_t> timestamps;
+    std::vector<double> values;
+    std::vector<TimeSeriesBlockInfo> index;
+    std::vector<unsigned char> encoded;
+};
+
+// Reads a .sdts file through a memory mapping; blocks decode independently, so any
+// subset can be read in any order or on several threads. Malformed files throw
+// std::runtime_error.
+class TimeSeriesReader {
+public:
+    explicit TimeSeriesReader(const std::string& filename);
+
+    int dimensions() const { return numDimensions; }
+    std::uint64_t numPoints() const { return totalPoints; }
+    size_t numBlocks() const { return index.size(); }
+    const TimeSeriesBlockInfo& blockInfo(size_t block) const { return index.at(block); }
+
+    // First block whose last timestamp is at or after timestamp, numBlocks() if none.
+    // Assumes timestamps never decrease, as generated series do.
+    size_t findBlock(std::int64_t timestamp) const;
+    // Block holding point pointIndex, numBlocks() if past the end
+    size_t blockOfPoint(std::uint64_t pointIndex) const;
+
+    // Decode a whole block, or one dimension of it
+    void readBlock(size_t block, TimeSeriesBlock& out) const;
+    void readColumn(size_t block, int dimension, std::vector<double>& out) const;
+
+private:
+    // Byte ranges of the block's columns: timestamps, then each dimension
+    void columns(size_t block, std::vector<const unsigned char*>& starts) const;
+
+    std::string filename;
+    MappedFile mapping;
+    int numDimensions;
+    std::uint64_t totalPoints;
+    std::vector<TimeSeriesBlockInfo> index;
+};
+
+#endif // TIME_SERIES_FILE_H
@@ -0,0 +1,42 @@
+#ifndef ZIPF_VOCABULARY_H
+#define ZIPF_VOCABULARY_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Synthetic vocabulary of `size` words whose ranks follow Zipf's law, P(k) ~ k^-exponent.
+// Ranks are drawn by rejection-inversion (Hoermann & Derflinger), which needs O(1) time
+// and memory regardless of size. The word of each rank is spelled out from the rank
+// itself (bijective base-100 over consonant-vowel syllables, scrambled within each
+// length), so the vocabulary is never materialized and frequent words are short.
+class ZipfVocabulary {
+public:
+    static constexpr std::uint64_t MAX_SIZE = 0xffffffffull;
+
+    ZipfVocabulary(std::uint64_t size, double exponent = 1.0);
+
+    std::uint64_t size() const { return numWords; }
+    double getExponent() const { return exponent; }
+
+    // A rank in [1, size()]
+    std::uint64_t sampleRank(std::mt19937& rng) const;
+
+    // Append the word of rank to out; distinct ranks give distinct words
+    void appendWord(std::uint64_t rank, std::string& out) const;
+    std::string word(std::uint64_t rank) const;
+
+private:
+    // Integral of x^-exponent shifted so that it is well defined at exponent 1, its inverse
+    double hIntegral(double x) const;
+    double hIntegralInverse(double x) const;
+    double h(double x) const;
+
+    std::uint64_t numWords;
+    double exponent;
+    double hIntegralX1;
+    double hIntegralN;
+    double squeeze;
+};
+
+#endif // ZIPF_VOCABULARY_H
@@ -1,19 +1,36 @@
 // Synthetic Data Generator.cpp : This file contains the 'main' function. Program execution begins and ends there.
 //
+#include <atomic>
+#include <csignal>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include "TabularData.h"
 #include "ImageData.h"
 #include "TextData.h"
 #include "TimeSeriesData.h"
+#include "TimeSeriesFile.h"
 #include "AudioData.h"
 
+// Set by Ctrl+C so an endless audio stream can stop cleanly and report its counters
+std::atomic<bool> stopStreaming(false);
+
+void handleInterrupt(int) {
+    stopStreaming.store(true);
+}
+
 void printUsage() {
     std::cout << "Synthetic Data Generator\n";
-    std::cout << "Usage: synthetic_data_generator [data_type] [num_samples] [output_path]\n";
-    std::cout << "  data_type: tabular, image, text, timeseries, audio\n";
-    std::cout << "  num_samples: Number of samples to generate\n";
+    std::cout << "Usage: synthetic_data_generator [data_type] [num_samples] [output_path] [pixel_format | speed | log_format]\n";
+    std::cout << "  data_type: tabular, image, text, timeseries, audio, audio_stream, logs\n";
+    std::cout << "  num_samples: Number of samples to generate (audio_stream: seconds, logs: lines; 0 = endless)\n";
     std::cout << "  output_path: Path to save the generated data\n";
+    std::cout << "               (timeseries: a .sdts path writes the compressed binary format, otherwise CSV)\n";
+    std::cout << "               (audio_stream: - for stdout, unix:<path> for a socket, otherwise a FIFO)\n";
+    std::cout << "               (logs: - for stdout, otherwise a file)\n";
+    std::cout << "  pixel_format: (image only) u8, u16 or f32, default u8\n";
+    std::cout << "  speed: (audio_stream only) 1 = real time, N = N x real time, 0 = unpaced\n";
+    std::cout << "  log_format: (logs only) json, syslog or apache, default json\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -26,6 +43,11 @@ int main(int argc, char* argv[]) {
     int numSamples = std::stoi(argv[2]);
     std::string outputPath = argv[3];
 
+#ifndef _WIN32
+    // A reader leaving a pipe must end the stream through EPIPE rather than kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
     try {
         if (dataType == "tabular") {
             TabularData tabular(numSamples, 5);  // 5 columns by default
@@ -35,9 +57,24 @@ int main(int argc, char* argv[]) {
         }
         else if (dataType == "image") {
             ImageData images(numSamples, 64, 64, 3);  // 64x64 RGB images by default
-            images.generate();
-            images.exportToDirectory(outputPath);
-            std::cout << "Generated " << numSamples << " synthetic images to " << outputPath << std::endl;
+            if (argc > 4) {
+                std::string format = argv[4];
+                if (format == "u16") {
+                    images.setPixelFormat(PixelFormat::UINT16);
+                } else if (format == "f32") {
+                    images.setPixelFormat(PixelFormat::FLOAT32);
+                } else if (format != "u8") {
+                    std::cerr << "Unknown pixel format: " << format << std::endl;
+                    printUsage();
+                    return 1;
+                }
+            }
+            // Stream straight to disk so large batches never sit in memory
+            ImageStreamSummary summary = images.generateToDirectory(outputPath);
+            std::cout << "Generated " << summary.written << " synthetic images to " << outputPath << std::endl;
+            if (summary.failed > 0) {
+                return 1;
+            }
         }
         else if (dataType == "text") {
             TextData text(numSamples, 100);  // 100 words per sample by default
@@ -47,8 +84,22 @@ int main(int argc, char* argv[]) {
         }
         else if (dataType == "timeseries") {
             TimeSeriesData timeSeries(numSamples, 5);  // 5 dimensions by default
-            timeSeries.generate();
-            timeSeries.exportToCSV(outputPath);
+            const std::string binaryExtension = ".sdts";
+            if (outputPath.size() >= binaryExtension.size()
+                && outputPath.compare(outputPath.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0) {
+                // Compressed binary: stream block by block, never holding the whole series.
+                // A stream of 0 points never ends, so no points means an empty file.
+                TimeSeriesWriter writer(outputPath, 5);
+                if (numSamples > 0) {
+                    for (const TimeSeriesBlock& block : timeSeries.stream(static_cast<std::uint64_t>(numSamples))) {
+                        writer.append(block);
+                    }
+                }
+                writer.close();
+            } else {
+                timeSeries.generate();
+                timeSeries.exportToCSV(outputPath);
+            }
             std::cout << "Generated time-series data with " << numSamples << " time points to " << outputPath << std::endl;
         }
         else if (dataType == "audio") {
@@ -57,6 +108,52 @@ int main(int argc, char* argv[]) {
             audio.exportToDirectory(outputPath);
             std::cout << "Generated " << numSamples << " audio samples to " << outputPath << std::endl;
         }
+        else if (dataType == "audio_stream") {
+            AudioData audio(1, 16000, 5);  // 16 kHz mono 16-bit PCM, 5 second clips back to back
+            StreamConfig config;
+            config.maxSeconds = numSamples;
+            config.speed = argc > 4 ? std::stod(argv[4]) : 1.0;
+            if (outputPath == "-") {
+                config.target = StreamTarget::STDOUT;
+            } else if (outputPath.rfind("unix:", 0) == 0) {
+                config.target = StreamTarget::UNIX_SOCKET;
+                config.path = outputPath.substr(5);
+            } else {
+                config.target = StreamTarget::FIFO;
+                config.path = outputPath;
+            }
+            std::signal(SIGINT, handleInterrupt);
+            StreamStats stats = audio.stream(config, &stopStreaming);
+            // stdout may carry the audio, so the report goes to stderr
+            std::cerr << "Streamed " << stats.framesWritten << " frames, " << stats.underruns << " underruns ("
+                << stats.silentFrames << " silent frames), " << stats.lateWrites << " late writes" << std::endl;
+        }
+        else if (dataType == "logs") {
+            // Only an explicit 0 streams without end
+            if (numSamples < 0) {
+                std::cerr << "Number of log lines must not be negative: " << numSamples << std::endl;
+                printUsage();
+                return 1;
+            }
+            LogConfig config;
+            std::string format = argc > 4 ? argv[4] : "json";
+            if (format == "syslog") {
+                config.format = LogFormat::SYSLOG;
+            } else if (format == "apache") {
+                config.format = LogFormat::APACHE_COMBINED;
+            } else if (format != "json") {
+                std::cerr << "Unknown log format: " << format << std::endl;
+                printUsage();
+                return 1;
+            }
+            TextData text(0, 0);
+            text.setLogConfig(config);
+            std::signal(SIGINT, handleInterrupt);
+            std::uint64_t written = text.streamLogLines(static_cast<std::uint64_t>(numSamples),
+                outputPath == "-" ? StreamTarget::STDOUT : StreamTarget::REGULAR_FILE, outputPath, 0, &stopStreaming);
+            // stdout may carry the log lines, so the report goes to stderr
+            std::cerr << "Generated " << written << " log lines to " << outputPath << std::endl;
+        }
         else {
             std::cerr << "Unknown data type: " << dataType << std::endl;
             printUsage();
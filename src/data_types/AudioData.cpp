@@ -1,19 +1,22 @@
 #include "AudioData.h"
 #include "RandomGenerators.h"
+#include "Parallel.h"
+#include "FileExport.h"
+#include "RingBuffer.h"
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <cmath>
 #include <algorithm>
-#include <cmath>
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+#include <chrono>
+#include <thread>
 namespace fs = std::filesystem;
 
 AudioData::AudioData(int numSamples, int sampleRate, int durationSeconds)
     : numSamples(numSamples), sampleRate(sampleRate), durationSeconds(durationSeconds),
-    numChannels(1), audioType(AudioType::SINE_WAVE) {
+    numChannels(1), audioType(AudioType::SINE_WAVE), sweepType(SweepType::LINEAR),
+    sampleFormat(SampleFormat::PCM16), ditherEnabled(false), wavContainer(WAVContainer::AUTO),
+    channelCorrelation(1.0), numThreads(0) {
 }
 
 void AudioData::setAudioType(AudioType type) {
@@ -21,152 +24,310 @@ void AudioData::setAudioType(AudioType type) {
 }
 
 void AudioData::setNumChannels(int channels) {
+    if (channels < 1) {
+        throw std::invalid_argument("Audio must have at least one channel");
+    }
     numChannels = channels;
 }
 
-void AudioData::generate() {
-    audioSamples.clear();
-
-    for (int i = 0; i < numSamples; ++i) {
-        AudioSample sample;
-        sample.sampleRate = sampleRate;
-        sample.numChannels = numChannels;
+void AudioData::setSweepType(SweepType type) {
+    sweepType = type;
+}
 
-        std::vector<float> channelData;
+void AudioData::setWAVContainer(WAVContainer container) {
+    wavContainer = container;
+}
 
-        switch (audioType) {
-        case AudioType::SINE_WAVE:
-            channelData = generateSineWave();
-            break;
-        case AudioType::WHITE_NOISE:
-            channelData = generateWhiteNoise();
-            break;
-        case AudioType::PINK_NOISE:
-            channelData = generatePinkNoise();
-            break;
-        case AudioType::CHIRP:
-            channelData = generateChirp();
-            break;
-        case AudioType::COMBINED:
-            channelData = generateCombined();
-            break;
-        }
+size_t AudioData::samplesPerChannel() const {
+    // 64-bit product: hours of high-rate audio overflow an int
+    return static_cast<size_t>(sampleRate) * static_cast<size_t>(durationSeconds);
+}
 
-        // Duplicate the channel data for multi-channel audio
-        sample.data.resize(channelData.size() * numChannels);
+void AudioData::setSampleFormat(SampleFormat format) {
+    sampleFormat = format;
+}
 
-        for (size_t j = 0; j < channelData.size(); ++j) {
-            for (int c = 0; c < numChannels; ++c) {
-                sample.data[j * numChannels + c] = channelData[j];
-            }
-        }
+void AudioData::setDither(bool enabled) {
+    ditherEnabled = enabled;
+}
 
-        audioSamples.push_back(sample);
+void AudioData::setChannelCorrelation(double correlation) {
+    if (correlation < 0.0 || correlation > 1.0) {
+        throw std::invalid_argument("Channel correlation must be between 0.0 and 1.0");
     }
+    channelCorrelation = correlation;
 }
 
-std::vector<float> AudioData::generateSineWave() {
-    int totalSamples = sampleRate * durationSeconds;
-    std::vector<float> data(totalSamples);
+void AudioData::setChannelDelays(const std::vector<double>& seconds) {
+    for (double delay : seconds) {
+        if (delay < 0.0) {
+            throw std::invalid_argument("Channel delays must not be negative");
+        }
+    }
+    channelDelays = seconds;
+}
 
-    // Generate sine wave parameters
-    float frequency = RandomGenerators::getRandomFloat(220.0f, 880.0f);  // Random frequency between A3 and A5
-    float amplitude = RandomGenerators::getRandomFloat(0.5f, 1.0f);
+void AudioData::setNumThreads(int threads) {
+    numThreads = threads;
+}
 
-    // Generate sine wave
-    for (int i = 0; i < totalSamples; ++i) {
-        float t = static_cast<float>(i) / sampleRate;
-        data[i] = amplitude * std::sin(2.0f * M_PI * frequency * t);
+void AudioData::setOutputRates(const std::vector<int>& rates) {
+    for (int rate : rates) {
+        if (rate <= 0) {
+            throw std::invalid_argument("Output sample rates must be positive");
+        }
     }
+    outputRates = rates;
+}
+
+void AudioData::setFeatures(const std::vector<AudioFeature>& features) {
+    this->features = features;
+}
 
-    return data;
+void AudioData::setFeatureConfig(const FeatureConfig& config) {
+    featureConfig = config;
 }
 
-std::vector<float> AudioData::generateWhiteNoise() {
-    int totalSamples = sampleRate * durationSeconds;
-    std::vector<float> data(totalSamples);
+void AudioData::generate() {
+    audioSamples.clear();
+    audioSamples.reserve(numSamples);
 
-    // Generate white noise parameters
-    float amplitude = RandomGenerators::getRandomFloat(0.1f, 0.5f);
+    // Every clip and channel draws from its own stream derived from one batch seed,
+    // so the result does not depend on how channels are spread over threads
+    const unsigned int batchSeed = RandomGenerators::getGenerator()();
 
-    // Generate white noise
-    for (int i = 0; i < totalSamples; ++i) {
-        data[i] = amplitude * (RandomGenerators::getRandomFloat(-1.0f, 1.0f));
+    std::vector<float> shared;
+    for (int i = 0; i < numSamples; ++i) {
+        AudioSample sample;
+        renderClip(i, batchSeed, sample, shared);
+        audioSamples.push_back(std::move(sample));
     }
-
-    return data;
 }
 
-std::vector<float> AudioData::generatePinkNoise() {
-    int totalSamples = sampleRate * durationSeconds;
-    std::vector<float> data(totalSamples);
-
-    // Generate pink noise parameters
-    float amplitude = RandomGenerators::getRandomFloat(0.1f, 0.5f);
+void AudioData::renderClip(int index, unsigned int batchSeed, AudioSample& sample, std::vector<float>& shared) const {
+    const size_t frames = samplesPerChannel();
 
-    // Simple approximation of pink noise using filtered white noise
-    float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, b3 = 0.0f, b4 = 0.0f, b5 = 0.0f, b6 = 0.0f;
+    // Shared-signal delays in whole samples. The shared signal is rendered maxDelay samples
+    // longer, and each channel reads a full-length window that ends earlier the later it is.
+    std::vector<size_t> delays(numChannels, 0);
+    for (int c = 0; c < numChannels && c < static_cast<int>(channelDelays.size()); ++c) {
+        delays[c] = static_cast<size_t>(std::llround(channelDelays[c] * sampleRate));
+    }
+    const size_t maxDelay = *std::max_element(delays.begin(), delays.end());
+
+    // Square-root weights make the correlation coefficient equal channelCorrelation
+    // when both parts carry the same power
+    const float sharedWeight = static_cast<float>(std::sqrt(channelCorrelation));
+    const float ownWeight = static_cast<float>(std::sqrt(1.0 - channelCorrelation));
+
+    sample.sampleRate = sampleRate;
+    sample.numChannels = numChannels;
+    sample.data.assign(frames * numChannels, 0.0f);
+
+    if (sharedWeight > 0.0f) {
+        std::seed_seq seed{ batchSeed, static_cast<unsigned int>(index), 0u };
+        std::mt19937 rng(seed);
+        shared.resize(frames + maxDelay);
+        generateSignal(rng, shared.data(), shared.size());
+    }
 
-    for (int i = 0; i < totalSamples; ++i) {
-        float white = RandomGenerators::getRandomFloat(-1.0f, 1.0f);
+    // Channels are synthesized independently, straight into their planar slices
+    Parallel::forRange(0, numChannels, numThreads, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            float* out = sample.channel(static_cast<int>(c));
+
+            if (ownWeight > 0.0f) {
+                std::seed_seq seed{ batchSeed, static_cast<unsigned int>(index), static_cast<unsigned int>(c + 1) };
+                std::mt19937 rng(seed);
+                generateSignal(rng, out, frames);
+                for (size_t n = 0; n < frames; ++n) {
+                    out[n] *= ownWeight;
+                }
+            }
 
-        // Filter white noise to approximate pink noise
-        b0 = 0.99886f * b0 + white * 0.0555179f;
-        b1 = 0.99332f * b1 + white * 0.0750759f;
-        b2 = 0.96900f * b2 + white * 0.1538520f;
-        b3 = 0.86650f * b3 + white * 0.3104856f;
-        b4 = 0.55000f * b4 + white * 0.5329522f;
-        b5 = -0.7616f * b5 - white * 0.0168980f;
+            if (sharedWeight > 0.0f) {
+                const float* src = shared.data() + (maxDelay - delays[c]);
+                for (size_t n = 0; n < frames; ++n) {
+                    out[n] += sharedWeight * src[n];
+                }
+            }
+        }
+    });
+}
 
-        data[i] = amplitude * (b0 + b1 + b2 + b3 + b4 + b5 + b6 + white * 0.5362f);
-        data[i] = std::clamp(data[i], -1.0f, 1.0f);
+void AudioData::generateSignal(std::mt19937& rng, float* out, size_t count) const {
+    switch (audioType) {
+    case AudioType::SINE_WAVE:
+        generateTone(Waveform::SINE, rng, out, count);
+        break;
+    case AudioType::WHITE_NOISE:
+        generateNoise(NoiseColor::WHITE, rng, out, count);
+        break;
+    case AudioType::PINK_NOISE:
+        generateNoise(NoiseColor::PINK, rng, out, count);
+        break;
+    case AudioType::BROWN_NOISE:
+        generateNoise(NoiseColor::BROWN, rng, out, count);
+        break;
+    case AudioType::BLUE_NOISE:
+        generateNoise(NoiseColor::BLUE, rng, out, count);
+        break;
+    case AudioType::VIOLET_NOISE:
+        generateNoise(NoiseColor::VIOLET, rng, out, count);
+        break;
+    case AudioType::CHIRP:
+        generateChirp(rng, out, count);
+        break;
+    case AudioType::COMBINED:
+        generateCombined(rng, out, count);
+        break;
+    case AudioType::SQUARE_WAVE:
+        generateTone(Waveform::SQUARE, rng, out, count);
+        break;
+    case AudioType::SAWTOOTH_WAVE:
+        generateTone(Waveform::SAWTOOTH, rng, out, count);
+        break;
+    case AudioType::TRIANGLE_WAVE:
+        generateTone(Waveform::TRIANGLE, rng, out, count);
+        break;
     }
-
-    return data;
 }
 
-std::vector<float> AudioData::generateChirp() {
-    int totalSamples = sampleRate * durationSeconds;
-    std::vector<float> data(totalSamples);
+void AudioData::generateTone(Waveform waveform, std::mt19937& rng, float* out, size_t count) const {
+    // Generate tone parameters
+    float frequency = RandomGenerators::getRandomFloat(rng, 220.0f, 880.0f);  // Random frequency between A3 and A5
+    float amplitude = RandomGenerators::getRandomFloat(rng, 0.5f, 1.0f);
 
-    // Generate chirp parameters
-    float startFrequency = RandomGenerators::getRandomFloat(100.0f, 500.0f);
-    float endFrequency = RandomGenerators::getRandomFloat(1000.0f, 5000.0f);
-    float amplitude = RandomGenerators::getRandomFloat(0.5f, 1.0f);
+    // Phase is accumulated in double precision, so long clips don't drift
+    Oscillator oscillator(waveform, frequency, sampleRate);
+    oscillator.render(out, count, amplitude);
+}
 
-    // Generate chirp signal (frequency sweep)
-    for (int i = 0; i < totalSamples; ++i) {
-        float t = static_cast<float>(i) / sampleRate;
-        float normalizedTime = t / durationSeconds;
-        float instantFrequency = startFrequency + (endFrequency - startFrequency) * normalizedTime;
+void AudioData::generateNoise(NoiseColor color, std::mt19937& rng, float* out, size_t count) const {
+    // Generate noise parameters
+    float amplitude = RandomGenerators::getRandomFloat(rng, 0.1f, 0.5f);
 
-        // Phase is the integral of frequency
-        float phase = 2.0f * M_PI * (startFrequency * t + 0.5f * (endFrequency - startFrequency) * normalizedTime * t);
+    // The noise engine runs its own counter-based white source, seeded from this stream
+    std::uint64_t seed = (static_cast<std::uint64_t>(rng()) << 32) | rng();
+    ColoredNoise noise(color, sampleRate, seed);
+    noise.render(out, count, amplitude);
+}
 
-        data[i] = amplitude * std::sin(phase);
+void AudioData::generateChirp(std::mt19937& rng, float* out, size_t count) const {
+    // Generate chirp parameters
+    float startFrequency = RandomGenerators::getRandomFloat(rng, 100.0f, 500.0f);
+    float endFrequency = RandomGenerators::getRandomFloat(rng, 1000.0f, 5000.0f);
+    float amplitude = RandomGenerators::getRandomFloat(rng, 0.5f, 1.0f);
+
+    // Generate chirp signal (frequency sweep over the whole clip)
+    if (count > 0) {
+        Oscillator chirp(Waveform::SINE, startFrequency, sampleRate);
+        chirp.setSweep(endFrequency, static_cast<std::int64_t>(count), sweepType);
+        chirp.render(out, count, amplitude);
     }
-
-    return data;
 }
 
-std::vector<float> AudioData::generateCombined() {
-    int totalSamples = sampleRate * durationSeconds;
+void AudioData::generateCombined(std::mt19937& rng, float* out, size_t count) const {
+    // Bed: a sine and white noise with complementary weights
+    float frequency = RandomGenerators::getRandomFloat(rng, 220.0f, 880.0f);
+    float amplitude = RandomGenerators::getRandomFloat(rng, 0.5f, 1.0f);
+    float noiseAmplitude = RandomGenerators::getRandomFloat(rng, 0.1f, 0.5f);
+    std::uint64_t noiseSeed = (static_cast<std::uint64_t>(rng()) << 32) | rng();
+    float sineWeight = RandomGenerators::getRandomFloat(rng, 0.3f, 0.7f);
+    float noiseWeight = 1.0f - sineWeight;
 
-    // Generate individual components
-    std::vector<float> sineWave = generateSineWave();
-    std::vector<float> noise = generateWhiteNoise();
+    const float fade = 0.01f;  // avoid clicks at the clip edges
+    const std::int64_t length = static_cast<std::int64_t>(count);
+    AudioMixer mixer(sampleRate);
+
+    MixerTrack sine;
+    sine.source = [oscillator = Oscillator(Waveform::SINE, frequency, sampleRate), amplitude](float* o, size_t n) mutable {
+        oscillator.render(o, n, amplitude);
+    };
+    sine.gain = sineWeight;
+    sine.length = length;
+    sine.fadeIn = sine.fadeOut = fade;
+    mixer.addTrack(sine);
+
+    MixerTrack noise;
+    noise.source = [generator = ColoredNoise(NoiseColor::WHITE, sampleRate, noiseSeed), noiseAmplitude](float* o, size_t n) mutable {
+        generator.render(o, n, noiseAmplitude);
+    };
+    noise.gain = noiseWeight;
+    noise.length = length;
+    noise.fadeIn = noise.fadeOut = fade;
+    mixer.addTrack(noise);
+
+    // One to three enveloped notes at random positions on top
+    static const Waveform shapes[] = { Waveform::SINE, Waveform::SQUARE, Waveform::SAWTOOTH, Waveform::TRIANGLE };
+    int notes = RandomGenerators::getRandomInt(rng, 1, 3);
+    for (int i = 0; i < notes && length > 0; ++i) {
+        Waveform shape = shapes[RandomGenerators::getRandomInt(rng, 0, 3)];
+        float noteFrequency = RandomGenerators::getRandomFloat(rng, 220.0f, 880.0f);
+        MixerTrack note;
+        note.source = [oscillator = Oscillator(shape, noteFrequency, sampleRate)](float* o, size_t n) mutable {
+            oscillator.render(o, n);
+        };
+        note.gain = RandomGenerators::getRandomFloat(rng, 0.1f, 0.3f);
+        note.start = static_cast<std::int64_t>(RandomGenerators::getRandomDouble(rng, 0.0, 0.8) * length);
+        note.length = std::min<std::int64_t>(length - note.start,
+            static_cast<std::int64_t>(RandomGenerators::getRandomDouble(rng, 0.1, 0.5) * length));
+        note.envelope.attack = RandomGenerators::getRandomFloat(rng, 0.005f, 0.05f);
+        note.envelope.decay = RandomGenerators::getRandomFloat(rng, 0.05f, 0.2f);
+        note.envelope.sustain = RandomGenerators::getRandomFloat(rng, 0.5f, 0.9f);
+        note.envelope.release = RandomGenerators::getRandomFloat(rng, 0.05f, 0.3f);
+        mixer.addTrack(note);
+    }
 
-    // Mix components
-    std::vector<float> combined(totalSamples);
-    float sineWeight = RandomGenerators::getRandomFloat(0.3f, 0.7f);
-    float noiseWeight = 1.0f - sineWeight;
+    mixer.render(out, count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = std::clamp(out[i], -1.0f, 1.0f);
+    }
+}
 
-    for (int i = 0; i < totalSamples; ++i) {
-        combined[i] = sineWeight * sineWave[i] + noiseWeight * noise[i];
-        combined[i] = std::clamp(combined[i], -1.0f, 1.0f);
+std::vector<AudioSample> AudioData::resample(const AudioSample& master, const std::vector<int>& rates, int numThreads) {
+    const size_t frames = master.numFrames();
+    std::vector<AudioSample> results(rates.size());
+    for (size_t r = 0; r < rates.size(); ++r) {
+        results[r].sampleRate = rates[r];
+        results[r].numChannels = master.numChannels;
+        const size_t outFrames = static_cast<size_t>((static_cast<std::uint64_t>(frames) * rates[r] + master.sampleRate - 1) / master.sampleRate);
+        results[r].data.resize(outFrames * master.numChannels);
     }
 
-    return combined;
+    // Each channel is read once, block by block, and every target rate consumes the
+    // block while it is still in cache
+    const size_t blockFrames = 4096;
+    Parallel::forRange(0, master.numChannels, numThreads, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; ++c) {
+            const float* src = master.channel(static_cast<int>(c));
+            std::vector<Resampler> resamplers;
+            std::vector<std::vector<float>> outputs(rates.size());
+            for (size_t r = 0; r < rates.size(); ++r) {
+                resamplers.emplace_back(master.sampleRate, rates[r]);
+            }
+
+            for (size_t offset = 0; offset < frames; offset += blockFrames) {
+                size_t count = std::min(blockFrames, frames - offset);
+                for (size_t r = 0; r < rates.size(); ++r) {
+                    if (rates[r] != master.sampleRate) {
+                        resamplers[r].process(src + offset, count, outputs[r]);
+                    }
+                }
+            }
+
+            for (size_t r = 0; r < rates.size(); ++r) {
+                float* dst = results[r].channel(static_cast<int>(c));
+                if (rates[r] == master.sampleRate) {
+                    std::copy(src, src + frames, dst);
+                    continue;
+                }
+                resamplers[r].finish(outputs[r]);
+                std::copy(outputs[r].begin(), outputs[r].end(), dst);
+            }
+        }
+    });
+    return results;
 }
 
 void AudioData::exportToDirectory(const std::string& directory) const {
@@ -178,54 +339,317 @@ void AudioData::exportToDirectory(const std::string& directory) const {
     // Export audio samples
     for (size_t i = 0; i < audioSamples.size(); ++i) {
         std::string filename = directory + "/audio_" + std::to_string(i + 1) + ".wav";
-        writeWAVFile(filename, audioSamples[i]);
+        writeWAVFile(filename, audioSamples[i], static_cast<std::uint32_t>(i + 1));
+
+        if (!outputRates.empty()) {
+            std::vector<AudioSample> delivered = resample(audioSamples[i], outputRates, numThreads);
+            for (const AudioSample& sample : delivered) {
+                std::string rateName = directory + "/audio_" + std::to_string(i + 1) + "_" + std::to_string(sample.sampleRate) + ".wav";
+                writeWAVFile(rateName, sample, static_cast<std::uint32_t>(i + 1));
+            }
+        }
+
+        if (!features.empty()) {
+            writeFeatureFiles(directory + "/audio_" + std::to_string(i + 1), audioSamples[i]);
+        }
+    }
+}
+
+void AudioData::writeFeatureFiles(const std::string& prefix, const AudioSample& sample) const {
+    static const char* const names[] = { "spectrogram", "mel", "mfcc" };
+
+    // Features come straight from the float master; frames are spread over the threads
+    AudioFeatures extractor(sample.sampleRate, featureConfig);
+    const size_t frames = extractor.numFrames(sample.numFrames());
+    std::vector<std::vector<float>> stacked(features.size());
+    std::vector<std::vector<float>> channelFeatures;
+    for (int c = 0; c < sample.numChannels; ++c) {
+        extractor.compute(sample.channel(c), sample.numFrames(), features, channelFeatures, numThreads);
+        for (size_t f = 0; f < features.size(); ++f) {
+            stacked[f].insert(stacked[f].end(), channelFeatures[f].begin(), channelFeatures[f].end());
+        }
+    }
+
+    for (size_t f = 0; f < features.size(); ++f) {
+        std::vector<size_t> shape = { static_cast<size_t>(sample.numChannels), frames, extractor.featureSize(features[f]) };
+        FileExport::exportToNPY(prefix + "_" + names[static_cast<int>(features[f])] + ".npy", shape, stacked[f].data());
+    }
+}
+
+namespace {
+    // Append a little-endian integer of the given width to a byte buffer
+    void appendLE(std::vector<unsigned char>& buffer, std::uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    }
+
+    void appendTag(std::vector<unsigned char>& buffer, const char* tag) {
+        buffer.insert(buffer.end(), tag, tag + 4);
+    }
+
+    // KSDATAFORMAT_SUBTYPE_PCM / _IEEE_FLOAT share everything but the first field
+    void appendSubFormat(std::vector<unsigned char>& buffer, unsigned int formatTag) {
+        static const unsigned char tail[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+            0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        appendLE(buffer, formatTag, 2);
+        buffer.insert(buffer.end(), tail, tail + 14);
+    }
+
+    const std::uint64_t RIFF_LIMIT = 0xFFFFFFFFull;
+
+    // Planar -> interleaved for frames [offset, offset + count). Mono and stereo get their
+    // own loops so the compiler emits a straight copy / unpack shuffle.
+    void interleave(const AudioSample& sample, size_t offset, size_t count, float* out) {
+        const int channels = sample.numChannels;
+        if (channels == 1) {
+            std::copy(sample.channel(0) + offset, sample.channel(0) + offset + count, out);
+        } else if (channels == 2) {
+            const float* left = sample.channel(0) + offset;
+            const float* right = sample.channel(1) + offset;
+            for (size_t i = 0; i < count; ++i) {
+                out[2 * i] = left[i];
+                out[2 * i + 1] = right[i];
+            }
+        } else {
+            for (int c = 0; c < channels; ++c) {
+                const float* src = sample.channel(c) + offset;
+                for (size_t i = 0; i < count; ++i) {
+                    out[i * channels + c] = src[i];
+                }
+            }
+        }
     }
 }
 
-void AudioData::writeWAVFile(const std::string& filename, const AudioSample& sample) const {
+void AudioData::writeWAVFile(const std::string& filename, const AudioSample& sample, std::uint32_t ditherSeed) const {
     std::ofstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open file for writing: " + filename);
     }
 
-    // WAV file header
-    const int dataSize = sample.data.size() * sizeof(short);
-    const int fileSize = 36 + dataSize;
+    PCMEncoder encoder(sampleFormat, ditherEnabled, ditherSeed);
+    const int bytesPerSample = encoder.bytesPerSample();
+    const int bitsPerSample = PCMEncoder::bitsPerSample(sampleFormat);
+    const bool isFloat = sampleFormat == SampleFormat::FLOAT32;
+    const unsigned int formatTag = isFloat ? 3 : 1;  // IEEE float : PCM
+
+    // All sizes are 64-bit; chunks are padded to an even length
+    const std::uint64_t frameCount = sample.numFrames();
+    const std::uint64_t dataSize = static_cast<std::uint64_t>(sample.data.size()) * bytesPerSample;
+    const std::uint64_t padding = dataSize & 1;
+
+    // WAVE_FORMAT_EXTENSIBLE for more than two channels or integer PCM wider than 16 bits
+    const bool extensible = sample.numChannels > 2 || (!isFloat && bitsPerSample > 16);
+    const unsigned int fmtSize = extensible ? 40 : (isFloat ? 18 : 16);
+    const bool hasFact = isFloat;
+
+    const std::uint64_t ds64Size = 28;
+    std::uint64_t riffSize = 4 + (8 + fmtSize) + (hasFact ? 12 : 0) + 8 + dataSize + padding;
+
+    // RF64/BW64 move the 64-bit sizes into a ds64 chunk and set the 32-bit fields to -1
+    bool large = wavContainer == WAVContainer::RF64 || wavContainer == WAVContainer::BW64 ||
+        (wavContainer == WAVContainer::AUTO && riffSize + 8 + ds64Size > RIFF_LIMIT);
+    if (wavContainer == WAVContainer::RIFF && riffSize > RIFF_LIMIT) {
+        throw std::runtime_error("Audio data too large for a RIFF WAV file: " + filename);
+    }
+    if (large) {
+        riffSize += 8 + ds64Size;
+    }
+
+    std::vector<unsigned char> header;
+    header.reserve(128);
 
     // RIFF header
-    file.write("RIFF", 4);
-    file.write(reinterpret_cast<const char*>(&fileSize), 4);
-    file.write("WAVE", 4);
+    appendTag(header, !large ? "RIFF" : (wavContainer == WAVContainer::BW64 ? "BW64" : "RF64"));
+    appendLE(header, large ? RIFF_LIMIT : riffSize, 4);
+    appendTag(header, "WAVE");
+
+    if (large) {
+        appendTag(header, "ds64");
+        appendLE(header, ds64Size, 4);
+        appendLE(header, riffSize, 8);
+        appendLE(header, dataSize, 8);
+        appendLE(header, frameCount, 8);
+        appendLE(header, 0, 4);  // no extra size table entries
+    }
 
     // Format chunk
-    file.write("fmt ", 4);
-    int fmtSize = 16;
-    file.write(reinterpret_cast<const char*>(&fmtSize), 4);
-    short audioFormat = 1;  // PCM
-    file.write(reinterpret_cast<const char*>(&audioFormat), 2);
-    short numChannels = sample.numChannels;
-    file.write(reinterpret_cast<const char*>(&numChannels), 2);
-    int sampleRate = sample.sampleRate;
-    file.write(reinterpret_cast<const char*>(&sampleRate), 4);
-    int byteRate = sampleRate * numChannels * sizeof(short);
-    file.write(reinterpret_cast<const char*>(&byteRate), 4);
-    short blockAlign = numChannels * sizeof(short);
-    file.write(reinterpret_cast<const char*>(&blockAlign), 2);
-    short bitsPerSample = 16;
-    file.write(reinterpret_cast<const char*>(&bitsPerSample), 2);
+    appendTag(header, "fmt ");
+    appendLE(header, fmtSize, 4);
+    appendLE(header, extensible ? 0xFFFE : formatTag, 2);
+    appendLE(header, sample.numChannels, 2);
+    appendLE(header, sample.sampleRate, 4);
+    appendLE(header, static_cast<std::uint64_t>(sample.sampleRate) * sample.numChannels * bytesPerSample, 4);  // byte rate
+    appendLE(header, sample.numChannels * bytesPerSample, 2);  // block align
+    appendLE(header, bitsPerSample, 2);
+    if (extensible) {
+        appendLE(header, 22, 2);
+        appendLE(header, bitsPerSample, 2);  // valid bits
+        appendLE(header, 0, 4);  // no speaker assignment
+        appendSubFormat(header, formatTag);
+    } else if (isFloat) {
+        appendLE(header, 0, 2);
+    }
 
-    // Data chunk
-    file.write("data", 4);
-    file.write(reinterpret_cast<const char*>(&dataSize), 4);
+    // Non-PCM data carries its frame count in a fact chunk
+    if (hasFact) {
+        appendTag(header, "fact");
+        appendLE(header, 4, 4);
+        appendLE(header, large ? RIFF_LIMIT : frameCount, 4);
+    }
 
-    // Write audio data
-    for (float sample : sample.data) {
-        // Convert float [-1.0, 1.0] to short [-32768, 32767]
-        short pcmSample = static_cast<short>(sample * 32767.0f);
-        file.write(reinterpret_cast<const char*>(&pcmSample), sizeof(short));
+    // Data chunk
+    appendTag(header, "data");
+    appendLE(header, large ? RIFF_LIMIT : dataSize, 4);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    // Interleave, convert and write the audio data in large blocks through reused buffers
+    const size_t frames = sample.numFrames();
+    const size_t channels = static_cast<size_t>(sample.numChannels);
+    const size_t chunkFrames = std::max<size_t>(1, (1 << 16) / channels);
+    std::vector<float> interleaved(std::min(chunkFrames, frames) * channels);
+    std::vector<unsigned char> buffer(interleaved.size() * bytesPerSample);
+    for (size_t offset = 0; offset < frames; offset += chunkFrames) {
+        size_t count = std::min(chunkFrames, frames - offset);
+        interleave(sample, offset, count, interleaved.data());
+        encoder.encode(interleaved.data(), count * channels, buffer.data());
+        file.write(reinterpret_cast<const char*>(buffer.data()), count * channels * bytesPerSample);
+    }
+    if (padding) {
+        file.put(0);
     }
 
     file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+StreamStats AudioData::stream(const StreamConfig& config, const std::atomic<bool>* stop) const {
+    if (config.speed < 0.0 || config.latency <= 0.0 || config.period <= 0.0 || config.maxSeconds < 0.0) {
+        throw std::invalid_argument("Stream speed and length must not be negative; latency and period must be positive");
+    }
+    if (sampleRate <= 0 || durationSeconds <= 0) {
+        throw std::invalid_argument("Streaming needs clips of at least one frame");
+    }
+    const size_t channels = static_cast<size_t>(numChannels);
+    const size_t periodFrames = std::max<size_t>(1, static_cast<size_t>(std::llround(config.period * sampleRate)));
+    const size_t capacityFrames = std::max(periodFrames, static_cast<size_t>(std::llround(config.latency * sampleRate)));
+    const std::uint64_t totalFrames = static_cast<std::uint64_t>(std::llround(config.maxSeconds * sampleRate));
+
+    StreamSink sink(config.target, config.path);
+    RingBuffer<float> ring(capacityFrames * channels);
+    std::atomic<bool> done(false);
+    std::atomic<bool> produced(false);  // the producer has pushed its last frame
+    std::exception_ptr producerError;
+
+    // Producer: render clips back to back and push whole interleaved frames into the
+    // ring, sleeping briefly whenever it is full
+    const unsigned int batchSeed = RandomGenerators::getGenerator()();
+    std::thread producer([&]() {
+        try {
+            AudioSample clip;
+            std::vector<float> shared;
+            std::vector<float> interleaved(periodFrames * channels);
+            for (int index = 0; !done.load(std::memory_order_relaxed); ++index) {
+                renderClip(index, batchSeed, clip, shared);
+                const size_t frames = clip.numFrames();
+                for (size_t offset = 0; offset < frames && !done.load(std::memory_order_relaxed);) {
+                    size_t count = std::min(periodFrames, frames - offset);
+                    interleave(clip, offset, count, interleaved.data());
+                    size_t pushed = 0;
+                    while (pushed < count * channels && !done.load(std::memory_order_relaxed)) {
+                        pushed += ring.write(interleaved.data() + pushed, count * channels - pushed);
+                        if (pushed < count * channels) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(500));
+                        }
+                    }
+                    offset += count;
+                }
+                if (frames == 0) {
+                    break;
+                }
+            }
+        }
+        catch (...) {
+            producerError = std::current_exception();
+            done.store(true);
+        }
+        produced.store(true);
+    });
+
+    StreamStats stats;
+    PCMEncoder encoder(sampleFormat, ditherEnabled, 1);
+    std::vector<float> block(periodFrames * channels);
+    std::vector<unsigned char> bytes(block.size() * encoder.bytesPerSample());
+    auto stopRequested = [&]() {
+        return (stop && stop->load()) || done.load();
+    };
+
+    // Let the producer fill half the ring before the clock starts
+    while (ring.size() < ring.capacity() / 2 && !stopRequested() && !produced.load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    // Writer: each period is due at start + frames / (rate * speed); a period the
+    // producer hasn't filled by then is counted and padded with silence
+    const auto start = std::chrono::steady_clock::now();
+    const double framesPerSecond = sampleRate * config.speed;
+    const auto periodLength = std::chrono::duration<double>(static_cast<double>(periodFrames) / std::max(framesPerSecond, 1.0));
+    while (!stopRequested() && (totalFrames == 0 || stats.framesWritten < totalFrames)) {
+        size_t count = periodFrames;
+        if (totalFrames > 0) {
+            count = static_cast<size_t>(std::min<std::uint64_t>(count, totalFrames - stats.framesWritten));
+        }
+        const size_t wanted = count * channels;
+        size_t got = 0;
+
+        if (config.speed > 0.0) {
+            const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(stats.framesWritten) / framesPerSecond));
+            std::this_thread::sleep_until(deadline);
+            if (std::chrono::steady_clock::now() - deadline > periodLength) {
+                ++stats.lateWrites;
+            }
+            got = ring.read(block.data(), wanted);
+            if (got < wanted) {
+                ++stats.underruns;
+                stats.silentFrames += (wanted - got) / channels;
+                std::fill(block.begin() + got, block.begin() + wanted, 0.0f);
+            }
+        } else {
+            // Unpaced: wait for the producer instead of inserting silence
+            while (got < wanted && !stopRequested()) {
+                // Checked before reading, so everything the producer pushed is seen
+                const bool exhausted = produced.load();
+                got += ring.read(block.data() + got, wanted - got);
+                if (got < wanted) {
+                    if (exhausted) {
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            if (got < wanted) {
+                break;
+            }
+        }
+
+        encoder.encode(block.data(), wanted, bytes.data());
+        if (!sink.write(bytes.data(), wanted * encoder.bytesPerSample())) {
+            stats.readerClosed = true;
+            break;
+        }
+        stats.framesWritten += count;
+    }
+
+    done.store(true);
+    producer.join();
+    if (producerError) {
+        std::rethrow_exception(producerError);
+    }
+    return stats;
 }
 
 std::vector<AudioSample> AudioData::getAudioSamples() const {
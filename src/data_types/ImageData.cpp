@@ -4,235 +4,701 @@
 #include <random>
 #include <ctime>
 #include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <mutex>
 #include "RandomGenerators.h"
+#include "Parallel.h"
+
+namespace {
+    // Vertical extent [top, bottom] of a shape in one column; top > bottom means empty
+    struct ColumnSpan {
+        int top;
+        int bottom;
+    };
+
+    // Column spans of one shape exactly as the rasterizer fills it
+    struct ShapeFootprint {
+        ShapeKind kind;
+        RGBPixel color;
+        int firstColumn;
+        std::vector<ColumnSpan> columns;
+    };
+
+    int integerSqrt(int value) {
+        int root = static_cast<int>(std::sqrt(static_cast<double>(value)));
+        while (root > 0 && root * root > value) {
+            root--;
+        }
+        while ((root + 1) * (root + 1) <= value) {
+            root++;
+        }
+        return root;
+    }
+
+    // Turn footprints into visible-region labels. Later shapes occlude earlier ones, so
+    // each column's span is cut by the spans drawn after it; this is interval arithmetic
+    // on a handful of spans per column, never a pass over the pixels.
+    void buildAnnotations(const std::vector<ShapeFootprint>& shapes, int width, int height, ImageAnnotation& annotation) {
+        annotation.width = width;
+        annotation.height = height;
+        annotation.shapes.clear();
+
+        std::vector<ColumnSpan> visible;
+        std::vector<ColumnSpan> remaining;
+
+        for (size_t i = 0; i < shapes.size(); i++) {
+            const ShapeFootprint& shape = shapes[i];
+            ShapeAnnotation label;
+            label.kind = shape.kind;
+            label.color = shape.color;
+            label.area = 0;
+
+            int minX = width, maxX = -1, minY = height, maxY = -1;
+            long long last = 0;  // column-major index just past the previous 1-run
+
+            for (size_t c = 0; c < shape.columns.size(); c++) {
+                int x = shape.firstColumn + static_cast<int>(c);
+                visible.clear();
+                if (shape.columns[c].top <= shape.columns[c].bottom) {
+                    visible.push_back(shape.columns[c]);
+                }
+
+                for (size_t j = i + 1; j < shapes.size() && !visible.empty(); j++) {
+                    const ShapeFootprint& above = shapes[j];
+                    int local = x - above.firstColumn;
+                    if (local < 0 || local >= static_cast<int>(above.columns.size())) {
+                        continue;
+                    }
+                    ColumnSpan cut = above.columns[local];
+                    if (cut.top > cut.bottom) {
+                        continue;
+                    }
+                    remaining.clear();
+                    for (const ColumnSpan& span : visible) {
+                        if (cut.bottom < span.top || cut.top > span.bottom) {
+                            remaining.push_back(span);
+                            continue;
+                        }
+                        if (span.top < cut.top) {
+                            remaining.push_back({ span.top, cut.top - 1 });
+                        }
+                        if (cut.bottom < span.bottom) {
+                            remaining.push_back({ cut.bottom + 1, span.bottom });
+                        }
+                    }
+                    visible.swap(remaining);
+                }
+
+                for (const ColumnSpan& span : visible) {
+                    long long start = static_cast<long long>(x) * height + span.top;
+                    long long end = static_cast<long long>(x) * height + span.bottom + 1;
+                    if (start == last && !label.rleCounts.empty()) {
+                        // Continues the previous run across a column boundary
+                        label.rleCounts.back() += static_cast<int>(end - start);
+                    } else {
+                        label.rleCounts.push_back(static_cast<int>(start - last));
+                        label.rleCounts.push_back(static_cast<int>(end - start));
+                    }
+                    last = end;
+
+                    label.area += span.bottom - span.top + 1;
+                    minX = std::min(minX, x);
+                    maxX = std::max(maxX, x);
+                    minY = std::min(minY, span.top);
+                    maxY = std::max(maxY, span.bottom);
+                }
+            }
+
+            if (label.area == 0) {
+                continue;  // fully covered by later shapes
+            }
+            long long total = static_cast<long long>(width) * height;
+            if (last < total) {
+                label.rleCounts.push_back(static_cast<int>(total - last));
+            }
+            label.bboxX = minX;
+            label.bboxY = minY;
+            label.bboxWidth = maxX - minX + 1;
+            label.bboxHeight = maxY - minY + 1;
+            annotation.shapes.push_back(std::move(label));
+        }
+    }
+}
 
 ImageData::ImageData(int numImages, int width, int height, int channels)
-    : numImages(numImages), width(width), height(height), channels(channels), imageType(ImageType::RANDOM_NOISE) {
+    : numImages(numImages), width(width), height(height), channels(channels), imageType(ImageType::RANDOM_NOISE),
+    pixelFormat(PixelFormat::UINT8), noiseFrequency(8.0f), numThreads(0), annotationsEnabled(false) {
 }
 
 void ImageData::setImageType(ImageType type) {
     imageType = type;
 }
 
+void ImageData::setPixelFormat(PixelFormat format) {
+    pixelFormat = format;
+}
+
+void ImageData::setNoiseParameters(float frequency, int octaves, float lacunarity, float gain) {
+    if (frequency <= 0.0f || octaves < 1) {
+        throw std::invalid_argument("Noise frequency must be positive and octaves at least 1");
+    }
+    // A zero or negative gain can cancel the octave amplitudes to a zero sum
+    if (!(lacunarity > 0.0f) || !(gain > 0.0f)) {
+        throw std::invalid_argument("Noise lacunarity and gain must be positive");
+    }
+    noiseFrequency = frequency;
+    fractalParameters.octaves = octaves;
+    fractalParameters.lacunarity = lacunarity;
+    fractalParameters.gain = gain;
+}
+
+void ImageData::setNumThreads(int threads) {
+    numThreads = threads;
+}
+
+void ImageData::setAugmenter(const ImageAugmenter& augmenter) {
+    this->augmenter = augmenter;
+}
+
+void ImageData::setAnnotationsEnabled(bool enabled) {
+    annotationsEnabled = enabled;
+}
+
+void ImageData::checkAnnotationSupport() const {
+    if (annotationsEnabled && augmenter && augmenter->changesGeometry()) {
+        throw std::invalid_argument("Shape annotations cannot be combined with crop, flip or rotation augmentation");
+    }
+}
+
 void ImageData::generate() {
+    checkAnnotationSupport();
     images.clear();
+    images.resize(numImages, Image(width, height, channels, pixelFormat));
+    annotations.clear();
+    if (annotationsEnabled) {
+        annotations.resize(numImages);
+    }
+
+    // Every image draws from its own stream seeded off the batch seed, so the
+    // result is the same whatever the thread split
+    unsigned int batchSeed = RandomGenerators::getGenerator()();
+    int threads = Parallel::resolveThreadCount(numThreads);
+    int imageThreads = std::max(1, std::min(threads, numImages));
+    int rowThreads = std::max(1, threads / imageThreads);
+
+    Parallel::forRange(0, numImages, imageThreads, [&](size_t begin, size_t end) {
+        Image augmented(1, 1, channels, pixelFormat);
+        for (size_t i = begin; i < end; i++) {
+            ImageAnnotation* annotation = annotationsEnabled ? &annotations[i] : nullptr;
+            Image& result = renderImage(static_cast<int>(i), batchSeed, rowThreads, images[i], augmented, annotation);
+            if (&result != &images[i]) {
+                std::swap(images[i], result);
+            }
+        }
+    });
     
-    for (int i = 0; i < numImages; i++) {
-        Image img(width, height, channels);
-        
+    std::cout << "Generated " << numImages << " synthetic images" << std::endl;
+}
+
+Image& ImageData::renderImage(int index, unsigned int batchSeed, int rowThreads, Image& canvas, Image& augmented,
+    ImageAnnotation* annotation) const {
+    std::seed_seq seed{ batchSeed, static_cast<unsigned int>(index) };
+    std::mt19937 rng(seed);
+
+    if (canvas.width != width || canvas.height != height || canvas.channels != channels || canvas.format != pixelFormat) {
+        canvas = Image(width, height, channels, pixelFormat);
+    }
+
+    if (annotation) {
+        // Only shape images carry labels; other types get an empty entry
+        annotation->width = width;
+        annotation->height = height;
+        annotation->shapes.clear();
+    }
+
+    // Single runtime dispatch on format and channel count; everything below is typed
+    visitImage(canvas, [&](auto view) {
         switch (imageType) {
             case ImageType::RANDOM_NOISE:
-                img = generateRandomNoise();
+                generateRandomNoise(view, rng);
                 break;
             case ImageType::GEOMETRIC_SHAPES:
-                img = generateGeometricShapes();
+                generateGeometricShapes(view, rng, annotation);
                 break;
             case ImageType::GRADIENT:
-                img = generateGradientImage();
+                generateGradientImage(view, rng);
                 break;
             case ImageType::PATTERN:
-                img = generatePatternImage();
+                generatePatternImage(view, rng);
+                break;
+            case ImageType::PERLIN_NOISE: {
+                // Fresh permutation/gradient tables per image, drawn from the image's RNG stream
+                GradientNoise noise(rng);
+                generateNoiseTexture(view, noise, rng, rowThreads);
+                break;
+            }
+            case ImageType::WORLEY_NOISE: {
+                CellularNoise noise(rng);
+                generateNoiseTexture(view, noise, rng, rowThreads);
                 break;
+            }
         }
-        
-        images.push_back(img);
+    });
+
+    if (!augmenter) {
+        return canvas;
     }
-    
-    std::cout << "Generated " << numImages << " synthetic images" << std::endl;
+
+    AugmentationParams params = augmenter->sample(rng, canvas.width, canvas.height);
+    augmenter->apply(canvas, params, augmented, rowThreads);
+    return augmented;
 }
 
-Image ImageData::generateRandomNoise() {
-    Image img(width, height, channels);
-    
+namespace {
+    // A color converted once to the image's sample type, all C samples filled in
+    template<typename T, int C>
+    struct TypedColor {
+        T samples[C];
+    };
+
+    template<typename T, int C>
+    TypedColor<T, C> toTyped(const RGBPixel& color) {
+        TypedColor<T, C> typed{};
+        T r = PixelTraits<T>::fromLevel(color.r);
+        T g = PixelTraits<T>::fromLevel(color.g);
+        T b = PixelTraits<T>::fromLevel(color.b);
+        if constexpr (C < 3) {
+            typed.samples[0] = PixelTraits<T>::average(r, g, b);
+        } else {
+            typed.samples[0] = r;
+            typed.samples[1] = g;
+            typed.samples[2] = b;
+        }
+        return typed;
+    }
+
+    template<typename T, int C>
+    void fillSpan(T* row, int x1, int x2, const TypedColor<T, C>& color) {
+        for (int x = x1; x <= x2; x++) {
+            for (int c = 0; c < C; c++) {
+                row[x * C + c] = color.samples[c];
+            }
+        }
+    }
+
+    RGBPixel randomColor(std::mt19937& rng) {
+        RGBPixel color;
+        color.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(rng, 0, 255));
+        color.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(rng, 0, 255));
+        color.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(rng, 0, 255));
+        return color;
+    }
+}
+
+template<typename T, int C>
+void ImageData::generateRandomNoise(ImageView<T, C> img, std::mt19937& rng) const {
     for (int y = 0; y < height; y++) {
+        T* row = img.row(y);
         for (int x = 0; x < width; x++) {
-            RGBPixel pixel;
-            pixel.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-            pixel.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-            pixel.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-            img.setPixel(y, x, pixel);
+            T r = PixelTraits<T>::random(rng);
+            T g = PixelTraits<T>::random(rng);
+            T b = PixelTraits<T>::random(rng);
+            if constexpr (C < 3) {
+                row[x * C] = PixelTraits<T>::average(r, g, b);
+            } else {
+                row[x * C] = r;
+                row[x * C + 1] = g;
+                row[x * C + 2] = b;
+            }
         }
     }
-    
-    return img;
 }
 
-Image ImageData::generateGeometricShapes() {
-    Image img(width, height, channels);
-    
+template<typename T, int C>
+void ImageData::generateGeometricShapes(ImageView<T, C> img, std::mt19937& rng, ImageAnnotation* annotation) const {
     // Fill with white background
+    TypedColor<T, C> white = toTyped<T, C>({ 255, 255, 255 });
     for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            RGBPixel pixel = {255, 255, 255};
-            img.setPixel(y, x, pixel);
-        }
+        fillSpan(img.row(y), 0, width - 1, white);
     }
     
     // Draw random shapes
-    int numShapes = RandomGenerators::getRandomInt(1, 5);
+    int numShapes = RandomGenerators::getRandomInt(rng, 1, 5);
+    std::vector<ShapeFootprint> footprints;
     
     for (int i = 0; i < numShapes; i++) {
         // Random shape type (0: rectangle, 1: circle)
-        int shapeType = RandomGenerators::getRandomInt(0, 1);
+        int shapeType = RandomGenerators::getRandomInt(rng, 0, 1);
         
         // Random color
-        RGBPixel color;
-        color.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-        color.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-        color.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
+        RGBPixel color = randomColor(rng);
+        TypedColor<T, C> typedColor = toTyped<T, C>(color);
         
         if (shapeType == 0) {
             // Rectangle
-            int x1 = RandomGenerators::getRandomInt(0, width - 1);
-            int y1 = RandomGenerators::getRandomInt(0, height - 1);
-            int x2 = RandomGenerators::getRandomInt(x1, width - 1);
-            int y2 = RandomGenerators::getRandomInt(y1, height - 1);
+            int x1 = RandomGenerators::getRandomInt(rng, 0, width - 1);
+            int y1 = RandomGenerators::getRandomInt(rng, 0, height - 1);
+            int x2 = RandomGenerators::getRandomInt(rng, x1, width - 1);
+            int y2 = RandomGenerators::getRandomInt(rng, y1, height - 1);
             
             for (int y = y1; y <= y2; y++) {
-                for (int x = x1; x <= x2; x++) {
-                    img.setPixel(y, x, color);
-                }
+                fillSpan(img.row(y), x1, x2, typedColor);
+            }
+
+            if (annotation) {
+                footprints.push_back({ ShapeKind::RECTANGLE, color, x1,
+                    std::vector<ColumnSpan>(x2 - x1 + 1, ColumnSpan{ y1, y2 }) });
             }
         } else {
             // Circle
-            int centerX = RandomGenerators::getRandomInt(0, width - 1);
-            int centerY = RandomGenerators::getRandomInt(0, height - 1);
-            int radius = RandomGenerators::getRandomInt(5, std::min(width, height) / 4);
+            int centerX = RandomGenerators::getRandomInt(rng, 0, width - 1);
+            int centerY = RandomGenerators::getRandomInt(rng, 0, height - 1);
+            int radius = RandomGenerators::getRandomInt(rng, 5, std::min(width, height) / 4);
+            int firstX = std::max(0, centerX - radius);
+            int lastX = std::min(width, centerX + radius) - 1;
+            int minY = std::max(0, centerY - radius);
+            int maxY = std::min(height, centerY + radius) - 1;
             
-            for (int y = std::max(0, centerY - radius); y < std::min(height, centerY + radius); y++) {
-                for (int x = std::max(0, centerX - radius); x < std::min(width, centerX + radius); x++) {
+            // Each row of the disc is one span: |dx| <= sqrt(r^2 - dy^2)
+            for (int y = minY; y <= maxY; y++) {
+                int dy = y - centerY;
+                int halfWidth = integerSqrt(radius * radius - dy * dy);
+                fillSpan(img.row(y), std::max(firstX, centerX - halfWidth), std::min(lastX, centerX + halfWidth), typedColor);
+            }
+
+            if (annotation) {
+                // Same pixel set solved per column: |dy| <= sqrt(r^2 - dx^2)
+                ShapeFootprint footprint{ ShapeKind::CIRCLE, color, firstX, {} };
+                for (int x = firstX; x <= lastX; x++) {
                     int dx = x - centerX;
-                    int dy = y - centerY;
-                    if (dx*dx + dy*dy <= radius*radius) {
-                        img.setPixel(y, x, color);
-                    }
+                    int halfHeight = integerSqrt(radius * radius - dx * dx);
+                    footprint.columns.push_back({ std::max(minY, centerY - halfHeight), std::min(maxY, centerY + halfHeight) });
                 }
+                footprints.push_back(std::move(footprint));
             }
         }
     }
-    
-    return img;
+
+    if (annotation) {
+        buildAnnotations(footprints, width, height, *annotation);
+    }
 }
 
-Image ImageData::generateGradientImage() {
-    Image img(width, height, channels);
-    
+template<typename T, int C>
+void ImageData::generateGradientImage(ImageView<T, C> img, std::mt19937& rng) const {
     // Choose gradient direction (0: horizontal, 1: vertical, 2: diagonal)
-    int direction = RandomGenerators::getRandomInt(0, 2);
+    int direction = RandomGenerators::getRandomInt(rng, 0, 2);
     
     // Choose start and end colors
-    RGBPixel startColor, endColor;
-    startColor.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    startColor.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    startColor.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    
-    endColor.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    endColor.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    endColor.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
+    RGBPixel startColor = randomColor(rng);
+    RGBPixel endColor = randomColor(rng);
+
+    // factor = (dirX * x + dirY * y) / denominator covers all three directions without a branch per pixel
+    int dirX = direction == 1 ? 0 : 1;
+    int dirY = direction == 0 ? 0 : 1;
+    int denominator = direction == 0 ? width : (direction == 1 ? height : width + height);
     
     for (int y = 0; y < height; y++) {
+        T* row = img.row(y);
         for (int x = 0; x < width; x++) {
-            float factor = 0.0f;
-            
-            switch (direction) {
-                case 0: // Horizontal
-                    factor = static_cast<float>(x) / width;
-                    break;
-                case 1: // Vertical
-                    factor = static_cast<float>(y) / height;
-                    break;
-                case 2: // Diagonal
-                    factor = static_cast<float>(x + y) / (width + height);
-                    break;
+            float factor = static_cast<float>(dirX * x + dirY * y) / denominator;
+            T r = PixelTraits<T>::fromLevel(startColor.r * (1 - factor) + endColor.r * factor);
+            T g = PixelTraits<T>::fromLevel(startColor.g * (1 - factor) + endColor.g * factor);
+            T b = PixelTraits<T>::fromLevel(startColor.b * (1 - factor) + endColor.b * factor);
+            if constexpr (C < 3) {
+                row[x * C] = PixelTraits<T>::average(r, g, b);
+            } else {
+                row[x * C] = r;
+                row[x * C + 1] = g;
+                row[x * C + 2] = b;
             }
-            
-            RGBPixel pixel;
-            pixel.r = static_cast<unsigned char>(startColor.r * (1 - factor) + endColor.r * factor);
-            pixel.g = static_cast<unsigned char>(startColor.g * (1 - factor) + endColor.g * factor);
-            pixel.b = static_cast<unsigned char>(startColor.b * (1 - factor) + endColor.b * factor);
-            
-            img.setPixel(y, x, pixel);
         }
     }
-    
-    return img;
 }
 
-Image ImageData::generatePatternImage() {
-    Image img(width, height, channels);
-    
+template<typename T, int C>
+void ImageData::generatePatternImage(ImageView<T, C> img, std::mt19937& rng) const {
     // Choose pattern type (0: checkerboard, 1: stripes)
-    int patternType = RandomGenerators::getRandomInt(0, 1);
+    int patternType = RandomGenerators::getRandomInt(rng, 0, 1);
     
     // Choose colors
-    RGBPixel color1, color2;
-    color1.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    color1.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    color1.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    
-    color2.r = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    color2.g = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
-    color2.b = static_cast<unsigned char>(RandomGenerators::getRandomInt(0, 255));
+    TypedColor<T, C> colors[2] = { toTyped<T, C>(randomColor(rng)), toTyped<T, C>(randomColor(rng)) };
     
     // Choose pattern size
-    int patternSize = RandomGenerators::getRandomInt(5, 30);
+    int patternSize = RandomGenerators::getRandomInt(rng, 5, 30);
     
     for (int y = 0; y < height; y++) {
+        // Stripes ignore the row; the checkerboard flips parity every patternSize rows
+        int rowParity = patternType == 0 ? (y / patternSize) % 2 : 0;
+        T* row = img.row(y);
         for (int x = 0; x < width; x++) {
-            bool useColor1 = false;
-            
-            if (patternType == 0) {
-                // Checkerboard
-                int cellX = x / patternSize;
-                int cellY = y / patternSize;
-                useColor1 = (cellX + cellY) % 2 == 0;
-            } else {
-                // Stripes
-                int cell = x / patternSize;
-                useColor1 = cell % 2 == 0;
+            const TypedColor<T, C>& color = colors[(x / patternSize + rowParity) % 2];
+            for (int c = 0; c < C; c++) {
+                row[x * C + c] = color.samples[c];
             }
-            
-            img.setPixel(y, x, useColor1 ? color1 : color2);
         }
     }
-    
-    return img;
+}
+
+template<typename T, int C, typename Noise>
+void ImageData::generateNoiseTexture(ImageView<T, C> img, const Noise& noise, std::mt19937& rng, int rowThreads) const {
+    // Noise values are mapped onto a ramp between two random colors
+    RGBPixel lowColor = randomColor(rng);
+    RGBPixel highColor = randomColor(rng);
+
+    float low[3] = { static_cast<float>(lowColor.r), static_cast<float>(lowColor.g), static_cast<float>(lowColor.b) };
+    float high[3] = { static_cast<float>(highColor.r), static_cast<float>(highColor.g), static_cast<float>(highColor.b) };
+    if constexpr (C < 3) {
+        low[0] = (lowColor.r + lowColor.g + lowColor.b) / 3.0f;
+        high[0] = (highColor.r + highColor.g + highColor.b) / 3.0f;
+    }
+    constexpr int colorChannels = C < 3 ? 1 : 3;
+
+    // Sample at pixel centers in lattice units
+    float step = noiseFrequency / width;
+    FractalParameters params = fractalParameters;
+
+    // Rows are independent once the tables exist, so bands of rows render in parallel
+    Parallel::forRange(0, height, rowThreads, [&](size_t rowBegin, size_t rowEnd) {
+        std::vector<float> values(width);
+
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            noise.fractalRow((y + 0.5f) * step, 0.5f * step, step, width, params, values.data());
+
+            T* row = img.row(static_cast<int>(y));
+            for (int x = 0; x < width; ++x) {
+                float t = std::clamp(0.5f + 0.5f * values[x], 0.0f, 1.0f);
+                for (int c = 0; c < colorChannels; ++c) {
+                    row[x * C + c] = PixelTraits<T>::fromLevel(low[c] + (high[c] - low[c]) * t);
+                }
+            }
+        }
+    });
+}
+
+std::string ImageData::imageFileName(const std::string& directory, size_t index) const {
+    // Float images go out as PFM; 8- and 16-bit as PPM
+    const char* extension = pixelFormat == PixelFormat::FLOAT32 ? ".pfm" : ".ppm";
+    return directory + "/image_" + std::to_string(index + 1) + extension;
+}
+
+void ImageData::writeImageFile(const std::string& filename, const Image& img, std::vector<unsigned char>& buffer) {
+    // Encode the whole file into one buffer so it goes out in a single write.
+    // All formats are written as RGB: gray is replicated, extra channels are dropped.
+    std::string header;
+    if (img.format == PixelFormat::FLOAT32) {
+        // PFM: a negative scale marks little-endian samples; rows run bottom to top
+        const std::uint16_t probe = 1;
+        bool littleEndian = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+        header = "PF\n" + std::to_string(img.width) + " " + std::to_string(img.height) + (littleEndian ? "\n-1.0\n" : "\n1.0\n");
+    } else {
+        header = "P6\n" + std::to_string(img.width) + " " + std::to_string(img.height) +
+            (img.format == PixelFormat::UINT16 ? "\n65535\n" : "\n255\n");
+    }
+
+    size_t rowBytes = static_cast<size_t>(img.width) * 3 * bytesPerSample(img.format);
+    buffer.resize(header.size() + rowBytes * img.height);
+    std::copy(header.begin(), header.end(), buffer.begin());
+
+    visitImage(img, [&](auto view) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(view.data)>>;
+        constexpr int C = decltype(view)::channels;
+
+        for (int y = 0; y < img.height; y++) {
+            int outRow = std::is_same_v<T, float> ? img.height - 1 - y : y;
+            unsigned char* out = buffer.data() + header.size() + outRow * rowBytes;
+            const T* in = view.row(y);
+
+            for (int x = 0; x < img.width; x++) {
+                for (int c = 0; c < 3; c++) {
+                    T sample = in[x * C + (C < 3 ? 0 : c)];
+                    if constexpr (std::is_same_v<T, std::uint16_t>) {
+                        // PPM samples wider than a byte are big-endian
+                        out[(x * 3 + c) * 2] = static_cast<unsigned char>(sample >> 8);
+                        out[(x * 3 + c) * 2 + 1] = static_cast<unsigned char>(sample & 0xFF);
+                    } else if constexpr (std::is_same_v<T, float>) {
+                        std::memcpy(out + (x * 3 + c) * sizeof(float), &sample, sizeof(float));
+                    } else {
+                        out[x * 3 + c] = sample;
+                    }
+                }
+            }
+        }
+    });
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+    }
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
 }
 
 void ImageData::exportToDirectory(const std::string& directory) const {
     std::filesystem::create_directories(directory);
-    
+
+    std::vector<unsigned char> buffer;
+    int failed = 0;
     for (size_t i = 0; i < images.size(); i++) {
-        // Create a simple PPM (Portable Pixmap) file
-        std::string filename = directory + "/image_" + std::to_string(i + 1) + ".ppm";
-        std::ofstream file(filename, std::ios::binary);
-        
-        if (!file.is_open()) {
-            std::cerr << "Failed to open file: " << filename << std::endl;
+        // Create a simple PPM (Portable Pixmap) file, or PFM for float images
+        std::string filename = imageFileName(directory, i);
+        try {
+            writeImageFile(filename, images[i], buffer);
+        }
+        catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            failed++;
+        }
+    }
+    
+    std::cout << "Exported " << images.size() - failed << " images to " << directory;
+    if (failed > 0) {
+        std::cout << " (" << failed << " failed)";
+    }
+    std::cout << std::endl;
+}
+
+ImageStreamSummary ImageData::generateToDirectory(const std::string& directory, const ImageProgressCallback& onProgress) {
+    checkAnnotationSupport();
+    std::filesystem::create_directories(directory);
+
+    // Labels are tiny next to pixels, so they are kept for the one JSON file at the end
+    std::vector<ImageAnnotation> streamAnnotations(annotationsEnabled ? numImages : 0);
+    // Only images on disk go into the JSON; each worker marks its own indices
+    std::vector<unsigned char> written(annotationsEnabled ? numImages : 0, 0);
+
+    unsigned int batchSeed = RandomGenerators::getGenerator()();
+    ImageStreamSummary summary;
+    std::mutex reportMutex;
+
+    // One canvas, one augmentation target and one encode buffer per worker, reused for every image
+    Parallel::forRange(0, numImages, numThreads, [&](size_t begin, size_t end) {
+        Image canvas(width, height, channels, pixelFormat);
+        Image augmented(1, 1, channels, pixelFormat);
+        std::vector<unsigned char> encoded;
+
+        for (size_t i = begin; i < end; i++) {
+            ImageWriteResult result;
+            result.index = static_cast<int>(i);
+            result.filename = imageFileName(directory, i);
+            result.success = true;
+
+            try {
+                ImageAnnotation* annotation = annotationsEnabled ? &streamAnnotations[i] : nullptr;
+                const Image& img = renderImage(static_cast<int>(i), batchSeed, 1, canvas, augmented, annotation);
+                writeImageFile(result.filename, img, encoded);
+            }
+            catch (const std::exception& e) {
+                result.success = false;
+                result.error = e.what();
+            }
+
+            if (annotationsEnabled) {
+                written[i] = result.success ? 1 : 0;
+            }
+
+            std::lock_guard<std::mutex> lock(reportMutex);
+            if (result.success) {
+                summary.written++;
+            } else {
+                summary.failed++;
+                summary.failures.push_back(result);
+            }
+            if (onProgress) {
+                onProgress(result);
+            } else if (!result.success) {
+                std::cerr << result.error << std::endl;
+            }
+        }
+    });
+
+    if (annotationsEnabled) {
+        writeAnnotations(directory + "/annotations.json", streamAnnotations, &written);
+    }
+
+    std::cout << "Streamed " << summary.written << " images to " << directory;
+    if (summary.failed > 0) {
+        std::cout << " (" << summary.failed << " failed)";
+    }
+    std::cout << std::endl;
+    return summary;
+}
+
+void ImageData::exportAnnotations(const std::string& filename) const {
+    if (!annotationsEnabled) {
+        throw std::runtime_error("Annotations were not enabled for this batch");
+    }
+    writeAnnotations(filename, annotations);
+}
+
+void ImageData::writeAnnotations(const std::string& filename, const std::vector<ImageAnnotation>& annotations,
+    const std::vector<unsigned char>* written) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+    }
+
+    // Image ids stay index + 1 so they match the file names when some are skipped
+    auto included = [&](size_t i) {
+        return written == nullptr || (*written)[i] != 0;
+    };
+    file << "{\n  \"images\": [";
+    bool first = true;
+    for (size_t i = 0; i < annotations.size(); i++) {
+        if (!included(i)) {
             continue;
         }
-        
-        const Image& img = images[i];
-        
-        // PPM header
-        file << "P6\n" << img.width << " " << img.height << "\n255\n";
-        
-        // Write pixel data
-        for (int y = 0; y < img.height; y++) {
-            for (int x = 0; x < img.width; x++) {
-                RGBPixel pixel = img.getPixel(y, x);
-                file.write(reinterpret_cast<char*>(&pixel.r), 1);
-                file.write(reinterpret_cast<char*>(&pixel.g), 1);
-                file.write(reinterpret_cast<char*>(&pixel.b), 1);
+        std::string imageFile = imageFileName("", i).substr(1);
+        file << (first ? "\n" : ",\n");
+        file << "    {\"id\": " << i + 1 << ", \"file_name\": \"" << imageFile << "\", \"width\": "
+            << annotations[i].width << ", \"height\": " << annotations[i].height << "}";
+        first = false;
+    }
+    file << "\n  ],\n  \"annotations\": [";
+
+    int annotationId = 1;
+    for (size_t i = 0; i < annotations.size(); i++) {
+        if (!included(i)) {
+            continue;
+        }
+        const ImageAnnotation& image = annotations[i];
+        for (const ShapeAnnotation& shape : image.shapes) {
+            file << (annotationId > 1 ? ",\n" : "\n");
+            file << "    {\"id\": " << annotationId++ << ", \"image_id\": " << i + 1
+                << ", \"category_id\": " << (shape.kind == ShapeKind::RECTANGLE ? 1 : 2)
+                << ", \"bbox\": [" << shape.bboxX << ", " << shape.bboxY << ", " << shape.bboxWidth << ", " << shape.bboxHeight << "]"
+                << ", \"area\": " << shape.area << ", \"iscrowd\": 0"
+                << ", \"color\": [" << static_cast<int>(shape.color.r) << ", " << static_cast<int>(shape.color.g) << ", "
+                << static_cast<int>(shape.color.b) << "]"
+                << ", \"segmentation\": {\"size\": [" << image.height << ", " << image.width << "], \"counts\": [";
+            for (size_t k = 0; k < shape.rleCounts.size(); k++) {
+                file << (k > 0 ? "," : "") << shape.rleCounts[k];
             }
+            file << "]}}";
         }
-        
-        file.close();
     }
-    
-    std::cout << "Exported " << images.size() << " images to " << directory << std::endl;
+    file << "\n  ],\n  \"categories\": [\n";
+    file << "    {\"id\": 1, \"name\": \"rectangle\"},\n";
+    file << "    {\"id\": 2, \"name\": \"circle\"}\n";
+    file << "  ]\n}\n";
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
 }
 
 std::vector<Image> ImageData::getImages() const {
     return images;
+}
+
+std::vector<ImageAnnotation> ImageData::getAnnotations() const {
+    return annotations;
 }
\ No newline at end of file
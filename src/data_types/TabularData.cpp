@@ -2,6 +2,7 @@
 #include "RandomGenerators.h"
 #include "Distributions.h"
 #include "FileExport.h"
+#include "DateTime.h"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -148,24 +149,13 @@ std::string TabularData::generateDateValue(const ColumnDefinition& column) {
 		endDate = it->second;
 	}
 	
-	//convert dates to time_t
-	std::tm start = {};
-	std::istringstream(startDate) >> std::get_time(&start, "%Y-%m-%d");
-	std::time_t startTime = std::mktime(&start);
-
-	std::tm end = {};
-	std::istringstream(endDate) >> std::get_time(&end, "%Y-%m-%d");
-	std::time_t endTime = std::mktime(&end);
-
-	//Generate random time between start and end
-	std::time_t randomTime = startTime + RandomGenerators::getRandomInt(0, endTime - startTime);
-
-	//convert back to string
-	std::tm randomTm;
-	localtime_s(&randomTm, &randomTime);
-	char buffer[11];
-	std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &randomTm);
-	return std::string(buffer);
+	//pick a day in [start, end] with calendar arithmetic, free of the local time zone
+	const std::int64_t startDay = DateTime::parseDate(startDate);
+	const std::int64_t endDay = DateTime::parseDate(endDate);
+	const std::int64_t randomDay = startDay + RandomGenerators::getRandomInt(0, static_cast<int>(endDay - startDay));
+
+	char buffer[10];
+	return std::string(buffer, DateTime::writeDate(randomDay, buffer));
 }
 
 std::string TabularData::generateBooleanValue() {
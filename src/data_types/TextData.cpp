@@ -1,7 +1,8 @@
 #include "TextData.h"
 #include "RandomGenerators.h"
+#include "FileExport.h"
+#include "Parallel.h"
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
@@ -31,6 +32,8 @@ const std::vector<std::string> TextData::defaultWordList = {
     "even", "new", "want", "because", "any", "these", "give", "day", "most", "us"
 };
 
+const char TextData::SEPARATOR[] = "\n\n";
+
 const std::vector<std::string> TextData::defaultTemplates = {
     "The $ADJECTIVE $NOUN $VERB the $NOUN.",
     "$NOUN $VERB $ADJECTIVE $NOUN.",
@@ -40,9 +43,11 @@ const std::vector<std::string> TextData::defaultTemplates = {
 };
 
 TextData::TextData(int numSamples, int wordsPerSample)
-    : numSamples(numSamples), wordsPerSample(wordsPerSample), textType(TextType::LOREM_IPSUM) {
+    : numSamples(numSamples), wordsPerSample(wordsPerSample), textType(TextType::LOREM_IPSUM), separatorLength(2), markovOrder(1),
+    recordTokens(false), periodToken(0), questionToken(0), exclamationToken(0) {
     wordList = defaultWordList;
     templates = defaultTemplates;
+    templateSlots = TemplateEngine::defaultSlots();
 }
 
 void TextData::setTextType(TextType type) {
@@ -51,183 +56,340 @@ void TextData::setTextType(TextType type) {
 
 void TextData::setTemplates(const std::vector<std::string>& templates) {
 	this->templates = templates;
+	templateEngine.reset();
+}
+
+void TextData::setTemplateSlot(const std::string& name, const std::vector<std::string>& words,
+	const std::vector<double>& weights) {
+	templateSlots[name] = TemplateSlot{ words, weights };
+	templateEngine.reset();
+}
+
+std::shared_ptr<const TemplateEngine> TextData::getTemplateEngine() {
+	if (!templateEngine) {
+		templateEngine = std::make_shared<const TemplateEngine>(templates, templateSlots);
+	}
+	return templateEngine;
 }
 
 void TextData::setWordList(const std::vector<std::string>& words) {
 	wordList = words;
+	markovModel.reset();
+	zipfVocabulary.reset();
+}
+
+void TextData::setZipfVocabulary(std::uint64_t size, double exponent) {
+	zipfVocabulary = std::make_shared<const ZipfVocabulary>(size, exponent);
+}
+
+void TextData::setMarkovOrder(int order) {
+	if (order < 1) {
+		throw std::invalid_argument("Markov order must be at least 1");
+	}
+	markovOrder = order;
+	if (markovModel && markovModel->getOrder() != order) {
+		markovModel.reset();
+	}
+}
+
+void TextData::trainMarkovModel(const std::vector<std::string>& corpusFiles, int numThreads) {
+	markovModel = std::make_shared<const MarkovModel>(MarkovModel::trainFromFiles(corpusFiles, markovOrder, numThreads));
+}
+
+void TextData::loadMarkovModel(const std::string& filename) {
+	markovModel = std::make_shared<const MarkovModel>(MarkovModel::load(filename));
+	markovOrder = markovModel->getOrder();
+}
+
+void TextData::setMarkovModel(std::shared_ptr<const MarkovModel> model) {
+	markovModel = std::move(model);
+}
+
+std::shared_ptr<const MarkovModel> TextData::getMarkovModel() {
+	if (!markovModel) {
+		markovModel = std::make_shared<const MarkovModel>(wordList, markovOrder);
+	}
+	return markovModel;
 }
 
 void TextData::generate() {
-    textSamples.clear();
+    // All samples share one buffer, each followed by the export separator
+    textArena.clear();
+    sampleOffsets.clear();
+    sampleOffsets.reserve(static_cast<size_t>(numSamples) + 1);
+    sampleOffsets.push_back(0);
+    if (textType == TextType::LOG_LINES) {
+        //log lines end in their own newline and are not tokenized
+        if (recordTokens) {
+            throw std::invalid_argument("Token recording is not supported for LOG_LINES");
+        }
+        tokenStream.clear();
+        documentOffsets.clear();
+        separatorLength = 1;
+        generateLogLines();
+        return;
+    }
+    separatorLength = 2;
+    textArena.reserve(static_cast<size_t>(numSamples) * (static_cast<size_t>(wordsPerSample) * 7 + separatorLength));
+    if (recordTokens) {
+        prepareTokens();
+    }
+    else {
+        tokenStream.clear();
+        documentOffsets.clear();
+    }
     for (int i = 0;i < numSamples;++i) {
-        std::string sample;
         switch (textType) {
         case TextType::LOREM_IPSUM:
-            sample = generateLoremIpsum();
+            appendLoremIpsum(textArena);
             break;
         case TextType::RANDOM_WORDS:
-            sample = generateRandomWords();
+            appendRandomWords(textArena);
             break;
         case TextType::MARKOV_CHAIN:
-            sample = generateMarkovChain();
+            appendMarkovChain(textArena);
             break;
         case TextType::TEMPLATE_BASED:
-            sample = generateTemplateBasedText();
+            appendTemplateBasedText(textArena);
             break;
+        case TextType::LOG_LINES:
+            break;
+        }
+        textArena.append(SEPARATOR, separatorLength);
+        sampleOffsets.push_back(textArena.size());
+        if (recordTokens) {
+            tokenStream.push_back(EOS_TOKEN);
+            documentOffsets.push_back(tokenStream.size());
         }
-        textSamples.push_back(sample);
     }
 }
 
-std::string TextData::generateLoremIpsum() {
-    std::ostringstream oss;
+void TextData::appendLoremIpsum(std::string& out) {
+    const size_t start = out.size();
 
     for (int i = 0;i < wordsPerSample;++i) {
         int wordIndex = RandomGenerators::getRandomInt(0, loremIpsumWords.size() - 1);
-        oss << loremIpsumWords[wordIndex];
+        out += loremIpsumWords[wordIndex];
+        if (recordTokens) {
+            tokenStream.push_back(sourceTokens[wordIndex]);
+        }
 
         //add punctuation occasionally
         if (i > 0 && i % 10 == 0) {
-            oss << ".";
+            out += '.';
+            if (recordTokens) {
+                tokenStream.push_back(periodToken);
+            }
         }
         //add space if not last word
         if (i < wordsPerSample - 1) {
-            oss << " ";
+            out += ' ';
         }
     }
 
     //Ensure the text ends with a period
-    if (oss.str().back() != '.') {
-        oss << ".";
+    if (out.size() == start || out.back() != '.') {
+        out += '.';
+        if (recordTokens) {
+            tokenStream.push_back(periodToken);
+        }
     }
 
     //capitalize the first letter
-    std::string result = oss.str();
-    if (!result.empty()) {
-        result[0] = std::toupper(result[0]);
-    }
-    return result;
+    out[start] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[start])));
 }
 
-std::string TextData::generateRandomWords() {
-    std::ostringstream oss;
+void TextData::appendRandomWords(std::string& out) {
+    std::mt19937& rng = RandomGenerators::getGenerator();
+    const size_t start = out.size();
     for (int i = 0;i < wordsPerSample;++i) {
-        int wordIndex = RandomGenerators::getRandomInt(0, wordList.size() - 1);
-        oss << wordList[wordIndex];
+        if (zipfVocabulary) {
+            std::uint64_t rank = zipfVocabulary->sampleRank(rng);
+            zipfVocabulary->appendWord(rank, out);
+            if (recordTokens) {
+                tokenStream.push_back(static_cast<std::uint32_t>(tokenVocabulary.size() + rank - 1));
+            }
+        }
+        else {
+            int wordIndex = RandomGenerators::getRandomInt(0, wordList.size() - 1);
+            out += wordList[wordIndex];
+            if (recordTokens) {
+                tokenStream.push_back(sourceTokens[wordIndex]);
+            }
+        }
 
         //add punctutaion occasionally
-		if (i > 0 && i % 8 == 0) {
-			oss << ".";
-		}
+        if (i > 0 && i % 8 == 0) {
+            out += '.';
+            if (recordTokens) {
+                tokenStream.push_back(periodToken);
+            }
+        }
         else if (i > 0 && i % 15 == 0) {
-			oss << "?";
-		}
+            out += '?';
+            if (recordTokens) {
+                tokenStream.push_back(questionToken);
+            }
+        }
         else if (i > 0 && i % 20 == 0) {
-			oss << "!";
+            out += '!';
+            if (recordTokens) {
+                tokenStream.push_back(exclamationToken);
+            }
         }
 
         //add space if not last word
         if (i < wordsPerSample - 1) {
-			oss << " ";
+            out += ' ';
         }
-
     }
 
     //ensure the text ends with a period
-    if (oss.str().back() != '.' && oss.str().back() != '?' && oss.str().back() != '!') {
-        oss << ".";
+    if (out.size() == start || (out.back() != '.' && out.back() != '?' && out.back() != '!')) {
+        out += '.';
+        if (recordTokens) {
+            tokenStream.push_back(periodToken);
+        }
     }
 
-	//capitalize the first letter
-    std::string result = oss.str();
-    if (!result.empty()) {
-		result[0] = std::toupper(result[0]);
-    }
-    return result;
+    //capitalize the first letter
+    out[start] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[start])));
 }
 
-std::string TextData::generateMarkovChain() {
-    // Build a simple markov chain from the word list
-	std::unordered_map<std::string, std::vector<std::string>> transitions;
-
-    //build transition from the word list
-    for (size_t i = 0;i < wordList.size() - 1;++i) {
-		transitions[wordList[i]].push_back(wordList[i + 1]);
-    }
-
-    //generate text using the markov chain
-    std::ostringstream oss;
-
-    //start with a random word
-	std::string currentWord = wordList[RandomGenerators::getRandomInt(0, wordList.size() - 1)];
-    oss << currentWord;
-    for(int i=1;i<wordsPerSample;++i){
-        // If the current word has no transitions, pick a random word
-        if (transitions.find(currentWord) == transitions.end() || transitions[currentWord].empty()) {
-            currentWord = wordList[RandomGenerators::getRandomInt(0, wordList.size() - 1)];
+void TextData::appendMarkovChain(std::string& out) {
+    // The model is built once per TextData; a sample only walks it
+    const MarkovModel& model = *getMarkovModel();
+    std::mt19937& rng = RandomGenerators::getGenerator();
+    const int order = model.getOrder();
+    const size_t start = out.size();
+
+    //start from a random context, weighted by how often it occurs
+    std::vector<std::uint32_t> context(order);
+    model.sampleStart(rng, context.data());
+
+    bool capitalizeNext = true;
+    for (int i = 0; i < wordsPerSample; ++i) {
+        std::uint32_t token;
+        if (i < order) {
+            token = context[i];
         }
         else {
-            // Otherwise, pick a random transition
-            const auto& nextWords = transitions[currentWord];
-            currentWord = nextWords[RandomGenerators::getRandomInt(0, nextWords.size() - 1)];
+            token = model.sampleNext(context.data(), rng);
+            std::copy(context.begin() + 1, context.end(), context.begin());
+            context[order - 1] = token;
         }
 
         //add punctuation occasionally
         if (i > 0 && i % 8 == 0) {
-            oss << ".";
-			//capitalize the next letter
-            if (!currentWord.empty()) {
-				currentWord[0] = std::toupper(currentWord[0]);
+            out += '.';
+            capitalizeNext = true;
+            if (recordTokens) {
+                tokenStream.push_back(periodToken);
             }
         }
         else if (i > 0 && i % 15 == 0) {
-			oss << "?";
-			//capitalize the next word
-            if (!currentWord.empty()) {
-				currentWord[0] = std::toupper(currentWord[0]);
-			}
+            out += '?';
+            capitalizeNext = true;
+            if (recordTokens) {
+                tokenStream.push_back(questionToken);
+            }
         }
-		oss << " " << currentWord;
+        if (i > 0) {
+            out += ' ';
+        }
+
+        if (recordTokens) {
+            tokenStream.push_back(sourceTokens[token]);
+        }
+        std::string_view word = model.word(token);
+        size_t wordStart = out.size();
+        out.append(word.data(), word.size());
+        //capitalize the first word of each sentence
+        if (capitalizeNext && wordStart < out.size()) {
+            out[wordStart] = static_cast<char>(std::toupper(static_cast<unsigned char>(out[wordStart])));
+        }
+        capitalizeNext = false;
     }
-    //ensure the text ends with a period
-	if (oss.str().back() != '.' && oss.str().back() != '?' && oss.str().back() != '!') {
-		oss << ".";
-	}
 
-    //capitalize the first letter
-    std::string result = oss.str();
-    if (!result.empty()) {
-		result[0] = std::toupper(result[0]);
+    //ensure the text ends with a period
+    if (out.size() == start || (out.back() != '.' && out.back() != '?' && out.back() != '!')) {
+        out += '.';
+        if (recordTokens) {
+            tokenStream.push_back(periodToken);
+        }
     }
-    return result;
 }
 
-std::string TextData::generateTemplateBasedText() {
-    //select a random templates
-    std::string templateStr = templates[RandomGenerators::getRandomInt(0, templates.size() - 1)];
-
-    //define word categories
-    std::vector<std::string> nouns = { "time", "person", "year", "way", "day", "thing", "man", "world", "life", "hand", "part", "child", "eye", "woman", "place", "work", "week", "case", "point", "government" };
-    std::vector<std::string> verbs = { "is", "are", "was", "were", "has", "have", "had", "can", "could", "will", "would", "should", "may", "might", "must", "shall", "do", "does", "did", "make", "makes", "made" };
-    std::vector<std::string> adjectives = { "good", "new", "first", "last", "long", "great", "little", "own", "other", "old", "right", "big", "high", "different", "small", "large", "next", "early", "young", "important" };
+void TextData::appendTemplateBasedText(std::string& out) {
+    // Templates are parsed once; a sample only appends literals and drawn slot words
+    const TemplateEngine& engine = *getTemplateEngine();
+    std::mt19937& rng = RandomGenerators::getGenerator();
+
+    //chain random templates until the sample has wordsPerSample words
+    const size_t firstToken = tokenStream.size();
+    int words = 0;
+    do {
+        if (words > 0) {
+            out += ' ';
+        }
+        size_t index = engine.pickTemplate(rng);
+        engine.render(index, rng, out, recordTokens ? &tokenStream : nullptr);
+        words += engine.wordCount(index);
+    } while (words < wordsPerSample);
+
+    //the engine reports IDs into its own vocabulary
+    for (size_t t = firstToken; t < tokenStream.size(); ++t) {
+        tokenStream[t] = sourceTokens[tokenStream[t]];
+    }
+}
 
-    //replace placeholders in the template
-    size_t pos;
-    std::string result = templateStr;
+void TextData::generateLogLines() {
+    // Blocks render on all cores, each from its own stream off one batch seed
+    const LogGenerator& logs = *getLogGenerator();
+    const unsigned int batchSeed = RandomGenerators::getGenerator()();
+    const size_t lines = static_cast<size_t>(std::max(numSamples, 0));
+    const size_t blocks = (lines + LogGenerator::BLOCK_LINES - 1) / LogGenerator::BLOCK_LINES;
+    std::vector<std::string> buffers(blocks);
+    std::vector<std::vector<size_t>> lineEnds(blocks);
+    Parallel::forRange(0, blocks, 0, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+            const size_t count = std::min(LogGenerator::BLOCK_LINES, lines - b * LogGenerator::BLOCK_LINES);
+            lineEnds[b].reserve(count);
+            logs.renderBlock(b, count, batchSeed, buffers[b], &lineEnds[b]);
+        }
+    });
 
-    while ((pos = result.find("$NOUN")) != std::string::npos) {
-        result.replace(pos, 5, nouns[RandomGenerators::getRandomInt(0, nouns.size() - 1)]);
+    size_t total = 0;
+    for (const auto& buffer : buffers) {
+        total += buffer.size();
     }
-
-    while ((pos = result.find("$VERB")) != std::string::npos) {
-        result.replace(pos, 5, verbs[RandomGenerators::getRandomInt(0, verbs.size() - 1)]);
+    textArena.reserve(total);
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t base = textArena.size();
+        textArena += buffers[b];
+        for (size_t end : lineEnds[b]) {
+            sampleOffsets.push_back(base + end);
+        }
+        std::string().swap(buffers[b]);
     }
+}
 
-    while ((pos = result.find("$ADJECTIVE")) != std::string::npos) {
-        result.replace(pos, 10, adjectives[RandomGenerators::getRandomInt(0, adjectives.size() - 1)]);
-    }
+std::uint64_t TextData::streamLogLines(std::uint64_t lines, StreamTarget target, const std::string& path,
+    int numThreads, const std::atomic<bool>* stop) {
+    StreamSink sink(target, path);
+    return getLogGenerator()->write(sink, lines, RandomGenerators::getGenerator()(), numThreads, stop);
+}
 
-    return result;
+void TextData::setLogConfig(const LogConfig& config) {
+	logConfig = config;
+	logGenerator.reset();
+}
+
+std::shared_ptr<const LogGenerator> TextData::getLogGenerator() {
+	if (!logGenerator) {
+		logGenerator = std::make_shared<const LogGenerator>(logConfig);
+	}
+	return logGenerator;
 }
 
 void TextData::exportToFile(const std::string& filename) const {
@@ -236,13 +398,173 @@ void TextData::exportToFile(const std::string& filename) const {
         throw std::runtime_error("Failed to open file for writing: " + filename);
     }
 
-    for (const auto& sample : textSamples) {
-        file << sample << "\n\n";
+    // The arena already holds every sample with its separator
+    file.write(textArena.data(), static_cast<std::streamsize>(textArena.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+void TextData::setRecordTokens(bool record) {
+	recordTokens = record;
+}
+
+size_t TextData::getTokenVocabularySize() const {
+	return tokenVocabulary.size() + (tokenZipf ? static_cast<size_t>(tokenZipf->size()) : 0);
+}
+
+std::string TextData::getToken(std::uint32_t id) const {
+	if (id >= getTokenVocabularySize()) {
+		throw std::out_of_range("Token ID out of range");
+	}
+	if (id < tokenVocabulary.size()) {
+		return tokenVocabulary[id];
+	}
+	return tokenZipf->word(id - tokenVocabulary.size() + 1);
+}
+
+std::uint32_t TextData::addToken(const std::string& token) {
+    auto inserted = tokenLookup.emplace(token, static_cast<std::uint32_t>(tokenVocabulary.size()));
+    if (inserted.second) {
+        tokenVocabulary.push_back(token);
+    }
+    return inserted.first->second;
+}
+
+void TextData::prepareTokens() {
+    tokenVocabulary.clear();
+    tokenLookup.clear();
+    tokenStream.clear();
+    documentOffsets.assign(1, 0);
+    addToken("<eos>");
+    addToken("<pad>");
+    periodToken = addToken(".");
+    questionToken = addToken("?");
+    exclamationToken = addToken("!");
+
+    //duplicate words in a source list share one ID
+    sourceTokens.clear();
+    tokenZipf.reset();
+    switch (textType) {
+    case TextType::LOREM_IPSUM:
+        for (const auto& word : loremIpsumWords) {
+            sourceTokens.push_back(addToken(word));
+        }
+        break;
+    case TextType::RANDOM_WORDS:
+        if (zipfVocabulary) {
+            if (tokenVocabulary.size() + zipfVocabulary->size() > 0x100000000ull) {
+                throw std::invalid_argument("Zipf vocabulary is too large for 32-bit token IDs");
+            }
+            tokenZipf = zipfVocabulary;
+            break;
+        }
+        for (const auto& word : wordList) {
+            sourceTokens.push_back(addToken(word));
+        }
+        break;
+    case TextType::MARKOV_CHAIN: {
+        const MarkovModel& model = *getMarkovModel();
+        sourceTokens.reserve(model.vocabularySize());
+        for (size_t id = 0; id < model.vocabularySize(); ++id) {
+            sourceTokens.push_back(addToken(std::string(model.word(static_cast<std::uint32_t>(id)))));
+        }
+        break;
+    }
+    case TextType::TEMPLATE_BASED:
+        for (const auto& token : getTemplateEngine()->tokenVocabulary()) {
+            sourceTokens.push_back(addToken(token));
+        }
+        break;
+    case TextType::LOG_LINES:
+        break;
+    }
+}
+
+void TextData::exportTokens(const std::string& prefix, const TokenExportConfig& config) const {
+    if (!recordTokens || documentOffsets.empty()) {
+        throw std::runtime_error("No tokens recorded; call setRecordTokens(true) before generate()");
+    }
+    if (config.sequenceLength < 0) {
+        throw std::invalid_argument("Sequence length must not be negative");
+    }
+    const bool fits16 = getTokenVocabularySize() <= 65536;
+    if (config.width == TokenWidth::UINT16 && !fits16) {
+        throw std::invalid_argument("Token vocabulary is too large for 16-bit IDs");
+    }
+    const bool wide = config.width == TokenWidth::UINT32 || !fits16;
+
+    //packing cuts the stream into equal rows; the last row is padded or dropped
+    size_t count = tokenStream.size();
+    std::vector<size_t> shape = { count };
+    if (config.sequenceLength > 0) {
+        const size_t length = static_cast<size_t>(config.sequenceLength);
+        const size_t rows = config.dropRemainder ? count / length : (count + length - 1) / length;
+        count = rows * length;
+        shape = { rows, length };
+    }
+    const size_t copied = std::min(count, tokenStream.size());
+    const std::string tokensFile = prefix + ".tokens.npy";
+    if (wide && count == tokenStream.size()) {
+        FileExport::exportToNPY(tokensFile, shape, tokenStream.data());
+    }
+    else if (wide) {
+        std::vector<std::uint32_t> tokens(count, PAD_TOKEN);
+        std::copy(tokenStream.begin(), tokenStream.begin() + copied, tokens.begin());
+        FileExport::exportToNPY(tokensFile, shape, tokens.data());
+    }
+    else {
+        std::vector<std::uint16_t> tokens(count, static_cast<std::uint16_t>(PAD_TOKEN));
+        for (size_t i = 0; i < copied; ++i) {
+            tokens[i] = static_cast<std::uint16_t>(tokenStream[i]);
+        }
+        FileExport::exportToNPY(tokensFile, shape, tokens.data());
+    }
+    FileExport::exportToNPY(prefix + ".docs.npy", { documentOffsets.size() }, documentOffsets.data());
+
+    const std::string vocabularyFile = prefix + ".vocab.txt";
+    std::ofstream file(vocabularyFile, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + vocabularyFile);
+    }
+    //written in large blocks; a Zipf vocabulary is spelled out only here
+    std::string block;
+    const size_t vocabularySize = getTokenVocabularySize();
+    for (size_t id = 0; id < vocabularySize; ++id) {
+        if (id < tokenVocabulary.size()) {
+            block += tokenVocabulary[id];
+        }
+        else {
+            tokenZipf->appendWord(id - tokenVocabulary.size() + 1, block);
+        }
+        block += '\n';
+        if (block.size() >= (1 << 20) || id + 1 == vocabularySize) {
+            file.write(block.data(), static_cast<std::streamsize>(block.size()));
+            block.clear();
+        }
     }
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + vocabularyFile);
+    }
+}
 
-    file.close();
+size_t TextData::getSampleCount() const {
+    return sampleOffsets.empty() ? 0 : sampleOffsets.size() - 1;
+}
+
+std::string_view TextData::getTextSample(size_t index) const {
+    if (index >= getSampleCount()) {
+        throw std::out_of_range("Text sample index out of range");
+    }
+    return std::string_view(textArena.data() + sampleOffsets[index],
+        sampleOffsets[index + 1] - sampleOffsets[index] - separatorLength);
 }
 
 std::vector<std::string> TextData::getTextSamples() const {
-    return textSamples;
-}
\ No newline at end of file
+    std::vector<std::string> samples;
+    samples.reserve(getSampleCount());
+    for (size_t i = 0; i < getSampleCount(); ++i) {
+        samples.emplace_back(getTextSample(i));
+    }
+    return samples;
+}
@@ -1,6 +1,8 @@
 #include "TimeSeriesData.h"
 #include "RandomGenerators.h"
 #include "Distributions.h"
+#include "TimeSeriesFile.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -8,145 +10,359 @@
 #include <iomanip>
 
 
-constexpr double M_PI = 3.14159265358979323846;
-
-
-TimeSeriesData::TimeSeriesData(int numPoints, int dimensions)
-	: numPoints(numPoints), dimensions(dimensions), pattern(TimeSeriesPattern::RANDOM_WALK) {
-	//deafult to current time
-	startTime = std::time(nullptr);
-	timeStepSeconds = 3600; //1 hr default
+namespace {
+	constexpr double TWO_PI = 6.28318530717958647692;
+	constexpr std::uint64_t RESYNC_POINTS = 256;
+	// Standard deviation of uniform [-1, 1) noise, kept by correlated innovations
+	const double UNIFORM_STDDEV = 0.57735026918962576451;
 }
 
-void TimeSeriesData::setPattern(TimeSeriesPattern pattern) {
-	this->pattern = pattern;
-}
+TimeSeriesStream::TimeSeriesStream(const TimeSeriesData& source, unsigned int seed, std::uint64_t numPoints,
+	size_t blockPoints)
+	: pattern(source.pattern), dimensions(source.dimensions), startTime(source.startTime),
+	timeStepSeconds(source.timeStepSeconds), numPoints(numPoints), blockPoints(blockPoints), nextIndex(0), rng(seed),
+	process(source.process), historyNext(0), shocksNext(0), regime(0), correlation(source.correlation) {
+	if (dimensions < 1) {
+		throw std::invalid_argument("Time series needs at least one dimension");
+	}
+	if (blockPoints == 0) {
+		throw std::invalid_argument("Time series block size must be positive");
+	}
 
-void TimeSeriesData::setStartTime(std::time_t startTime) {
-	this->startTime = startTime;
-}
+	// Every dimension draws all its parameters so the streams of different patterns
+	// stay aligned for the same seed
+	const bool slow = pattern == TimeSeriesPattern::CYCLICAL;
+	for (std::vector<double>* field : { &level, &intercept, &slope, &amplitude, &frequency, &phase,
+		&sinPhase, &cosPhase, &stepSin, &stepCos }) {
+		field->resize(dimensions);
+	}
+	for (int d = 0; d < dimensions; ++d) {
+		level[d] = RandomGenerators::getRandomDouble(rng, -10.0, 10.0);
+		slope[d] = RandomGenerators::getRandomDouble(rng, -0.5, 0.5);
+		intercept[d] = RandomGenerators::getRandomDouble(rng, -10.0, 10.0);
+		amplitude[d] = RandomGenerators::getRandomDouble(rng, 1.0, 5.0);
+		frequency[d] = slow ? RandomGenerators::getRandomDouble(rng, 0.005, 0.02)
+			: RandomGenerators::getRandomDouble(rng, 0.01, 0.1);
+		phase[d] = RandomGenerators::getRandomDouble(rng, 0.0, TWO_PI);
+		sinPhase[d] = std::sin(phase[d]);
+		cosPhase[d] = std::cos(phase[d]);
+		stepSin[d] = std::sin(frequency[d]);
+		stepCos[d] = std::cos(frequency[d]);
+	}
 
-void TimeSeriesData::setTimeStep(int timeStepSeconds) {
-	this->timeStepSeconds = timeStepSeconds;
+	// Processes start at their mean with no past shocks; GARCH starts at its
+	// unconditional variance
+	history.assign(process.arCoefficients.size() * dimensions, 0.0);
+	shocks.assign(process.maCoefficients.size() * dimensions, 0.0);
+	variance.assign(dimensions, process.garchOmega / (1.0 - process.garchAlpha - process.garchBeta));
+	residual.assign(dimensions, 0.0);
+	scratch.resize(dimensions);
+	regimeRng.seed(rng());
 }
 
-void TimeSeriesData::generate() {
-	timeSeries.clear();
-	timeSeries.resize(numPoints);
+void TimeSeriesStream::advanceOscillators(std::uint64_t index) {
+	// Rotation instead of a sine per point, re-anchored to the exact phase every
+	// RESYNC_POINTS points so rounding never accumulates
+	if (index % RESYNC_POINTS == 0) {
+		for (int d = 0; d < dimensions; ++d) {
+			phase[d] = std::fmod(phase[d] + frequency[d] * RESYNC_POINTS, TWO_PI);
+			sinPhase[d] = std::sin(phase[d]);
+			cosPhase[d] = std::cos(phase[d]);
+		}
+		return;
+	}
+	for (int d = 0; d < dimensions; ++d) {
+		const double rotated = sinPhase[d] * stepCos[d] + cosPhase[d] * stepSin[d];
+		cosPhase[d] = cosPhase[d] * stepCos[d] - sinPhase[d] * stepSin[d];
+		sinPhase[d] = rotated;
+	}
+}
 
-	for (int i = 0;i < numPoints;++i) {
-		TimePoint point;
-		point.timestamp = startTime + i * timeStepSeconds;
-		point.values.resize(dimensions);
-
-		for (int d = 0;d < dimensions;++d) {
-			std::vector<double> dimensionValues;
-
-			switch (pattern) {
-			case TimeSeriesPattern::RANDOM_WALK:
-				dimensionValues = generateRandomWalk(d);
-				break;
-			case TimeSeriesPattern::TREND:
-				dimensionValues = generateTrend(d);
-				break;
-			case TimeSeriesPattern::SEASONAL:
-				dimensionValues = generateSeasonal(d);
-				break;
-			case TimeSeriesPattern::CYCLICAL:
-				dimensionValues = generateCyclical(d);
-				break;
-			case TimeSeriesPattern::COMBINED:
-				dimensionValues = generateCombined(d);
-				break;
+void TimeSeriesStream::generateProcess(const double* innovations, size_t count, double* out) {
+	const double mean = process.mean;
+	switch (pattern) {
+	case TimeSeriesPattern::AUTOREGRESSIVE:
+	case TimeSeriesPattern::ARMA: {
+		const size_t p = process.arCoefficients.size();
+		const size_t q = pattern == TimeSeriesPattern::ARMA ? process.maCoefficients.size() : 0;
+		const double sigma = process.noiseStddev;
+		for (size_t i = 0; i < count; ++i) {
+			const double* z = innovations + i * dimensions;
+			double* value = out + i * dimensions;
+			// Each lag adds one contiguous row, so the recurrence vectorizes across dimensions
+			for (int d = 0; d < dimensions; ++d) {
+				scratch[d] = sigma * z[d];
+			}
+			for (size_t lag = 1; lag <= p; ++lag) {
+				const double phi = process.arCoefficients[lag - 1];
+				const double* past = history.data() + ((historyNext + p - lag) % p) * dimensions;
+				for (int d = 0; d < dimensions; ++d) {
+					scratch[d] += phi * past[d];
+				}
+			}
+			for (size_t lag = 1; lag <= q; ++lag) {
+				const double theta = process.maCoefficients[lag - 1];
+				const double* past = shocks.data() + ((shocksNext + q - lag) % q) * dimensions;
+				for (int d = 0; d < dimensions; ++d) {
+					scratch[d] += theta * past[d];
+				}
+			}
+			if (q > 0) {
+				double* shock = shocks.data() + shocksNext * dimensions;
+				for (int d = 0; d < dimensions; ++d) {
+					shock[d] = sigma * z[d];
+				}
+				shocksNext = (shocksNext + 1) % q;
+			}
+			if (p > 0) {
+				std::copy(scratch.begin(), scratch.end(), history.begin() + historyNext * dimensions);
+				historyNext = (historyNext + 1) % p;
+			}
+			for (int d = 0; d < dimensions; ++d) {
+				value[d] = mean + scratch[d];
+			}
+		}
+		break;
+	}
+	case TimeSeriesPattern::GARCH: {
+		const double omega = process.garchOmega;
+		const double alpha = process.garchAlpha;
+		const double beta = process.garchBeta;
+		for (size_t i = 0; i < count; ++i) {
+			const double* z = innovations + i * dimensions;
+			double* value = out + i * dimensions;
+			for (int d = 0; d < dimensions; ++d) {
+				const double e = std::sqrt(variance[d]) * z[d];
+				value[d] = mean + e;
+				variance[d] = omega + alpha * e * e + beta * variance[d];
+			}
+		}
+		break;
+	}
+	case TimeSeriesPattern::REGIME_SWITCHING: {
+		const size_t regimes = process.regimeMeans.size();
+		for (size_t i = 0; i < count; ++i) {
+			const double* z = innovations + i * dimensions;
+			double* value = out + i * dimensions;
+			const double regimeMean = process.regimeMeans[regime];
+			const double regimeStddev = process.regimeStddevs[regime];
+			for (int d = 0; d < dimensions; ++d) {
+				value[d] = regimeMean + regimeStddev * z[d];
+			}
+			// Walk the transition row; the last regime absorbs rounding
+			const double u = (static_cast<double>(regimeRng()) + 0.5) * (1.0 / 4294967296.0);
+			const double* row = process.regimeTransitions.data() + regime * regimes;
+			double cumulative = 0.0;
+			size_t next = 0;
+			while (next + 1 < regimes && u >= (cumulative += row[next])) {
+				++next;
 			}
-			point.values[d] = dimensionValues[i];
+			regime = static_cast<int>(next);
 		}
-		timeSeries[i] = point;
+		break;
+	}
+	default:
+		break;
 	}
 }
 
-std::vector<double> TimeSeriesData::generateRandomWalk(int dimension) {
-	std::vector<double> values(numPoints);
+size_t TimeSeriesStream::nextBlock(TimeSeriesBlock& block) {
+	size_t count = blockPoints;
+	if (numPoints != 0) {
+		const std::uint64_t remaining = nextIndex < numPoints ? numPoints - nextIndex : 0;
+		if (remaining < count) {
+			count = static_cast<size_t>(remaining);
+		}
+	}
+	block.firstIndex = nextIndex;
+	block.dimensions = dimensions;
+	block.timestamps.resize(count);
+	block.values.resize(count * dimensions);
+	if (count == 0) {
+		return 0;
+	}
 
-	// Start with a random value
-	values[0] = RandomGenerators::getRandomDouble(-10.0, 10.0);
+	for (size_t i = 0; i < count; ++i) {
+		block.timestamps[i] = startTime + static_cast<std::time_t>(nextIndex + i) * timeStepSeconds;
+	}
 
-	// Generate random walk
-	for (int i = 1; i < numPoints; ++i) {
-		double step = RandomGenerators::getRandomDouble(-1.0, 1.0);
-		values[i] = values[i - 1] + step;
+	// Innovations are drawn point by point, so the series does not depend on the block size
+	const bool stochastic = pattern == TimeSeriesPattern::AUTOREGRESSIVE || pattern == TimeSeriesPattern::ARMA
+		|| pattern == TimeSeriesPattern::GARCH || pattern == TimeSeriesPattern::REGIME_SWITCHING;
+	const size_t components = pattern == TimeSeriesPattern::COMBINED ? 3 : 1;
+	const size_t stride = dimensions * components;
+	noise.resize(count * stride);
+	if (correlation) {
+		independent.resize(noise.size());
+		Distributions::fillNormal(rng, independent.data(), independent.size(), 0.0, stochastic ? 1.0 : UNIFORM_STDDEV);
+		correlation->apply(independent.data(), noise.data(), count * components);
+	} else if (stochastic) {
+		Distributions::fillNormal(rng, noise.data(), noise.size());
+	} else {
+		Distributions::fillUniform(rng, noise.data(), noise.size(), -1.0, 1.0);
 	}
 
-	return values;
-}
+	if (stochastic) {
+		generateProcess(noise.data(), count, block.values.data());
+		nextIndex += count;
+		return count;
+	}
 
-std::vector<double> TimeSeriesData::generateTrend(int dimension) {
-	std::vector<double> values(numPoints);
+	for (size_t i = 0; i < count; ++i) {
+		const std::uint64_t index = nextIndex + i;
+		const double t = static_cast<double>(index);
+		double* out = block.values.data() + i * dimensions;
+		const double* n = noise.data() + i * stride;
+
+		switch (pattern) {
+		case TimeSeriesPattern::RANDOM_WALK:
+			for (int d = 0; d < dimensions; ++d) {
+				out[d] = level[d];
+				level[d] += n[d];
+			}
+			break;
+		case TimeSeriesPattern::TREND:
+			for (int d = 0; d < dimensions; ++d) {
+				out[d] = intercept[d] + slope[d] * t + n[d];
+			}
+			break;
+		case TimeSeriesPattern::SEASONAL:
+		case TimeSeriesPattern::CYCLICAL: {
+			// Cyclical series also switch level every 50 points
+			const double offset = pattern == TimeSeriesPattern::CYCLICAL && index % 100 < 50 ? 2.0 : 0.0;
+			for (int d = 0; d < dimensions; ++d) {
+				out[d] = amplitude[d] * sinPhase[d] + 0.5 * n[d] + offset;
+			}
+			advanceOscillators(index + 1);
+			break;
+		}
+		case TimeSeriesPattern::COMBINED: {
+			const double* trendNoise = n + dimensions;
+			const double* seasonalNoise = n + 2 * dimensions;
+			for (int d = 0; d < dimensions; ++d) {
+				const double trend = intercept[d] + slope[d] * t + trendNoise[d];
+				const double seasonal = amplitude[d] * sinPhase[d] + 0.5 * seasonalNoise[d];
+				out[d] = 0.3 * level[d] + 0.3 * trend + 0.4 * seasonal;
+				level[d] += n[d];
+			}
+			advanceOscillators(index + 1);
+			break;
+		}
+		default:
+			break;
+		}
+	}
 
-	//generate trend parameters
-	double slope = RandomGenerators::getRandomDouble(-0.5, 0.5);
-	double intercept = RandomGenerators::getRandomDouble(-10.0, 10.0);
+	nextIndex += count;
+	return count;
+}
 
-	//generate trend with noise
-	for (int i = 0; i < numPoints; ++i) {
-		double noise = RandomGenerators::getRandomDouble(-1.0, 1.0);
-		values[i] = intercept + slope * i + noise;
+TimeSeriesStream::iterator& TimeSeriesStream::iterator::operator++() {
+	if (stream->nextBlock(stream->current) == 0) {
+		stream = nullptr;
 	}
-
-	return values;
+	return *this;
 }
 
-std::vector<double> TimeSeriesData::generateSeasonal(int dimension) {
-	std::vector<double> values(numPoints);
+TimeSeriesStream::iterator TimeSeriesStream::begin() {
+	if (nextBlock(current) == 0) {
+		return end();
+	}
+	return iterator(this);
+}
 
-	//generate seasonal parameters
-	double amplitude = RandomGenerators::getRandomDouble(1.0, 5.0);
-	double frequency = RandomGenerators::getRandomDouble(0.01, 0.1);
-	double phase = RandomGenerators::getRandomDouble(0.0, 2 * M_PI);
 
-	//generate seasonal pattern
-	for(int i=0;i<numPoints;++i){
-		double noise = RandomGenerators::getRandomDouble(-0.5, 0.5);
-		values[i] = amplitude * std::sin(frequency * i + phase) + noise;
-	}
-	return values;
+TimeSeriesData::TimeSeriesData(int numPoints, int dimensions)
+	: numPoints(numPoints), dimensions(dimensions), pattern(TimeSeriesPattern::RANDOM_WALK),
+	timestampFormat(TimestampFormat::DATE_TIME), timeZone(TimeZone::LOCAL) {
+	//deafult to current time
+	startTime = std::time(nullptr);
+	timeStepSeconds = 3600; //1 hr default
+}
 
+void TimeSeriesData::setPattern(TimeSeriesPattern pattern) {
+	this->pattern = pattern;
 }
 
-std::vector<double> TimeSeriesData::generateCyclical(int dimension) {
-	std::vector<double> values(numPoints);
+void TimeSeriesData::setStartTime(std::time_t startTime) {
+	this->startTime = startTime;
+}
 
-	// Generate cyclical parameters
-	double amplitude = RandomGenerators::getRandomDouble(1.0, 5.0);
-	double frequency = RandomGenerators::getRandomDouble(0.005, 0.02);
-	double phase = RandomGenerators::getRandomDouble(0.0, 2.0 * M_PI);
+void TimeSeriesData::setTimeStep(int timeStepSeconds) {
+	this->timeStepSeconds = timeStepSeconds;
+}
 
-	// Generate cyclical pattern with noise
-	for (int i = 0; i < numPoints; ++i) {
-		double noise = RandomGenerators::getRandomDouble(-0.5, 0.5);
-		values[i] = amplitude * std::sin(frequency * i + phase) + noise;
+void TimeSeriesData::setTimestampFormat(TimestampFormat format, TimeZone zone) {
+	timestampFormat = format;
+	timeZone = zone;
+}
 
-		// Add some non-linear behavior
-		if (i % 100 < 50) {
-			values[i] += 2.0;
+void TimeSeriesData::setCorrelation(const std::vector<double>& matrix) {
+	if (matrix.empty()) {
+		correlation.reset();
+		return;
+	}
+	if (dimensions < 1 || matrix.size() != static_cast<size_t>(dimensions) * dimensions) {
+		throw std::invalid_argument("Correlation matrix must be dimensions x dimensions");
+	}
+	for (int d = 0; d < dimensions; ++d) {
+		if (std::fabs(matrix[d * dimensions + d] - 1.0) > 1e-9) {
+			throw std::invalid_argument("Correlation matrix must have a unit diagonal");
 		}
 	}
-
-	return values;
+	correlation = std::make_shared<const CholeskyFactor>(matrix, static_cast<size_t>(dimensions));
 }
 
-std::vector<double> TimeSeriesData::generateCombined(int dimension) {
-	std::vector<double> randomWalk = generateRandomWalk(dimension);
-	std::vector<double> trend = generateTrend(dimension);
-	std::vector<double> seasonal = generateSeasonal(dimension);
+void TimeSeriesData::setProcessConfig(const ProcessConfig& config) {
+	if (!(config.noiseStddev >= 0.0)) {
+		throw std::invalid_argument("Process noise standard deviation must not be negative");
+	}
+	if (!(config.garchOmega > 0.0) || config.garchAlpha < 0.0 || config.garchBeta < 0.0
+		|| !(config.garchAlpha + config.garchBeta < 1.0)) {
+		throw std::invalid_argument("GARCH needs omega > 0, alpha and beta >= 0 and alpha + beta < 1");
+	}
+	const size_t regimes = config.regimeMeans.size();
+	if (regimes == 0 || config.regimeStddevs.size() != regimes || config.regimeTransitions.size() != regimes * regimes) {
+		throw std::invalid_argument("Regime switching needs a mean and standard deviation per regime and a square transition matrix");
+	}
+	for (size_t r = 0; r < regimes; ++r) {
+		if (config.regimeStddevs[r] < 0.0) {
+			throw std::invalid_argument("Regime standard deviations must not be negative");
+		}
+		double total = 0.0;
+		for (size_t c = 0; c < regimes; ++c) {
+			const double probability = config.regimeTransitions[r * regimes + c];
+			if (probability < 0.0) {
+				throw std::invalid_argument("Regime transition probabilities must not be negative");
+			}
+			total += probability;
+		}
+		if (std::fabs(total - 1.0) > 1e-6) {
+			throw std::invalid_argument("Each regime transition row must sum to 1");
+		}
+	}
+	process = config;
+}
 
-	std::vector<double> combined(numPoints);
+void TimeSeriesData::generate() {
+	timeSeries.clear();
+	if (numPoints <= 0) {
+		return;
+	}
+	timeSeries.resize(numPoints);
 
-	for (int i = 0; i < numPoints; ++i) {
-		combined[i] = 0.3 * randomWalk[i] + 0.3 * trend[i] + 0.4 * seasonal[i];
+	TimeSeriesStream points = stream(static_cast<std::uint64_t>(numPoints));
+	for (const TimeSeriesBlock& block : points) {
+		for (size_t i = 0; i < block.size(); ++i) {
+			TimePoint& point = timeSeries[block.firstIndex + i];
+			point.timestamp = block.timestamps[i];
+			point.values.assign(block.point(i), block.point(i) + dimensions);
+		}
 	}
+}
 
-	return combined;
+TimeSeriesStream TimeSeriesData::stream(std::uint64_t numPoints, size_t blockPoints) const {
+	return TimeSeriesStream(*this, RandomGenerators::getGenerator()(), numPoints, blockPoints);
 }
 
 void TimeSeriesData::exportToCSV(const std::string& filename) const {
@@ -163,14 +379,11 @@ void TimeSeriesData::exportToCSV(const std::string& filename) const {
 	file << "\n";
 
 	// Write data
+	TimestampFormatter formatter(timestampFormat, timeZone);
 	for (const auto& point : timeSeries) {
-		// Convert timestamp to string
-		std::tm tm;
-		localtime_s(&tm, &point.timestamp);
-		char buffer[20];
-		std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
-
-		file << buffer;
+		// Consecutive timestamps only re-render the fields that changed
+		const std::string_view timestamp = formatter.format(point.timestamp);
+		file.write(timestamp.data(), timestamp.size());
 
 		for (const auto& value : point.values) {
 			file << "," << value;
@@ -182,6 +395,14 @@ void TimeSeriesData::exportToCSV(const std::string& filename) const {
 	file.close();
 }
 
+void TimeSeriesData::exportToBinary(const std::string& filename) const {
+	TimeSeriesWriter writer(filename, dimensions);
+	for (const auto& point : timeSeries) {
+		writer.append(static_cast<std::int64_t>(point.timestamp), point.values.data());
+	}
+	writer.close();
+}
+
 std::vector<TimePoint> TimeSeriesData::getTimeSeries() const {
 	return timeSeries;
 }
\ No newline at end of file
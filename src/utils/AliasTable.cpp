@@ -0,0 +1,52 @@
+#include "AliasTable.h"
+#include <stdexcept>
+
+AliasTable::AliasTable(const std::vector<double>& weights)
+    : probability(weights.size()), alias(weights.size()) {
+    build(weights.data(), weights.size(), probability.data(), alias.data());
+}
+
+void AliasTable::build(const double* weights, size_t count, float* probability, std::uint32_t* alias) {
+    if (count == 0) {
+        throw std::invalid_argument("Alias table needs at least one weight");
+    }
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        if (weights[i] < 0.0) {
+            throw std::invalid_argument("Alias table weights must not be negative");
+        }
+        total += weights[i];
+    }
+    if (total <= 0.0) {
+        throw std::invalid_argument("Alias table weights must not all be zero");
+    }
+
+    // Vose: scale to mean 1, then pair each underfull slot with an overfull donor
+    std::vector<double> scaled(count);
+    std::vector<std::uint32_t> small, large;
+    for (size_t i = 0; i < count; ++i) {
+        scaled[i] = weights[i] * static_cast<double>(count) / total;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+    }
+    while (!small.empty() && !large.empty()) {
+        std::uint32_t under = small.back();
+        small.pop_back();
+        std::uint32_t over = large.back();
+        probability[under] = static_cast<float>(scaled[under]);
+        alias[under] = over;
+        scaled[over] -= 1.0 - scaled[under];
+        if (scaled[over] < 1.0) {
+            large.pop_back();
+            small.push_back(over);
+        }
+    }
+    // Leftovers are full up to rounding error
+    for (std::uint32_t i : large) {
+        probability[i] = 1.0f;
+        alias[i] = i;
+    }
+    for (std::uint32_t i : small) {
+        probability[i] = 1.0f;
+        alias[i] = i;
+    }
+}
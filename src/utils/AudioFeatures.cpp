@@ -0,0 +1,170 @@
+#include "AudioFeatures.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr double PI = 3.14159265358979323846;
+
+    // HTK mel scale
+    double hzToMel(double hz) {
+        return 2595.0 * std::log10(1.0 + hz / 700.0);
+    }
+
+    double melToHz(double mel) {
+        return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+    }
+
+    // Floor of the mel power before taking the log (-100 dB)
+    constexpr float LOG_FLOOR = 1e-10f;
+}
+
+AudioFeatures::AudioFeatures(int sampleRate, const FeatureConfig& config)
+    : config(config), fft(config.frameSize > 0 ? static_cast<size_t>(config.frameSize) : 0) {
+    if (sampleRate <= 0) {
+        throw std::invalid_argument("Sample rate must be positive");
+    }
+    if (config.hopSize < 1) {
+        throw std::invalid_argument("Hop size must be at least 1");
+    }
+    if (config.numMelBands < 1 || config.numCoefficients < 1 || config.numCoefficients > config.numMelBands) {
+        throw std::invalid_argument("Need at least one mel band and between 1 and numMelBands coefficients");
+    }
+    const double nyquist = sampleRate / 2.0;
+    const double maxFrequency = config.maxFrequency > 0.0f ? config.maxFrequency : nyquist;
+    if (config.minFrequency < 0.0f || config.minFrequency >= maxFrequency || maxFrequency > nyquist) {
+        throw std::invalid_argument("Mel frequency range must lie within [0, Nyquist]");
+    }
+
+    // Periodic Hann window
+    const size_t size = fft.size();
+    window.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * PI * static_cast<double>(i) / static_cast<double>(size)));
+    }
+
+    // Triangular filters between mel-spaced edges, in units of FFT bins
+    const int bands = config.numMelBands;
+    const int bins = static_cast<int>(fft.numBins());
+    const double melLow = hzToMel(config.minFrequency);
+    const double melHigh = hzToMel(maxFrequency);
+    std::vector<double> edges(bands + 2);
+    for (int m = 0; m < bands + 2; ++m) {
+        edges[m] = melToHz(melLow + (melHigh - melLow) * m / (bands + 1)) * static_cast<double>(size) / sampleRate;
+    }
+    melFirst.resize(bands);
+    melLength.resize(bands);
+    melOffset.resize(bands);
+    for (int m = 0; m < bands; ++m) {
+        const int first = std::max(0, static_cast<int>(std::ceil(edges[m])));
+        const int last = std::min(bins - 1, static_cast<int>(std::floor(edges[m + 2])));
+        melFirst[m] = first;
+        melLength[m] = std::max(0, last - first + 1);
+        melOffset[m] = melWeights.size();
+        for (int k = first; k <= last; ++k) {
+            const double up = (k - edges[m]) / (edges[m + 1] - edges[m]);
+            const double down = (edges[m + 2] - k) / (edges[m + 2] - edges[m + 1]);
+            melWeights.push_back(static_cast<float>(std::max(0.0, std::min(up, down))));
+        }
+    }
+
+    // Orthonormal DCT-II
+    const int coefficients = config.numCoefficients;
+    dct.resize(static_cast<size_t>(coefficients) * bands);
+    for (int c = 0; c < coefficients; ++c) {
+        const double scale = std::sqrt((c == 0 ? 1.0 : 2.0) / bands);
+        for (int m = 0; m < bands; ++m) {
+            dct[static_cast<size_t>(c) * bands + m] = static_cast<float>(scale * std::cos(PI * c * (m + 0.5) / bands));
+        }
+    }
+}
+
+size_t AudioFeatures::numFrames(size_t samples) const {
+    const size_t size = fft.size();
+    return samples <= size ? 1 : 1 + (samples - size) / static_cast<size_t>(config.hopSize);
+}
+
+size_t AudioFeatures::featureSize(AudioFeature feature) const {
+    switch (feature) {
+        case AudioFeature::SPECTROGRAM:
+            return fft.numBins();
+        case AudioFeature::MEL_SPECTROGRAM:
+            return static_cast<size_t>(config.numMelBands);
+        case AudioFeature::MFCC:
+            return static_cast<size_t>(config.numCoefficients);
+    }
+    throw std::invalid_argument("Unknown audio feature");
+}
+
+void AudioFeatures::compute(const float* samples, size_t count, const std::vector<AudioFeature>& features,
+    std::vector<std::vector<float>>& out, int numThreads) const {
+    const size_t frames = numFrames(count);
+    out.resize(features.size());
+    bool needMel = false;
+    for (size_t f = 0; f < features.size(); ++f) {
+        out[f].assign(frames * featureSize(features[f]), 0.0f);
+        needMel = needMel || features[f] != AudioFeature::SPECTROGRAM;
+    }
+
+    const size_t size = fft.size();
+    const size_t bins = fft.numBins();
+    const int bands = config.numMelBands;
+    const int coefficients = config.numCoefficients;
+
+    Parallel::forRange(0, frames, numThreads, [&](size_t firstFrame, size_t lastFrame) {
+        // Per-thread scratch, reused for every frame of the chunk
+        std::vector<float> frame(size), re(bins), im(bins), power(bins), mel(bands), logMel(bands);
+
+        for (size_t t = firstFrame; t < lastFrame; ++t) {
+            const size_t start = t * static_cast<size_t>(config.hopSize);
+            const size_t available = std::min(size, count - std::min(count, start));
+            for (size_t i = 0; i < available; ++i) {
+                frame[i] = samples[start + i] * window[i];
+            }
+            std::fill(frame.begin() + available, frame.end(), 0.0f);
+
+            fft.forwardReal(frame.data(), re.data(), im.data());
+            for (size_t k = 0; k < bins; ++k) {
+                power[k] = re[k] * re[k] + im[k] * im[k];
+            }
+
+            if (needMel) {
+                for (int m = 0; m < bands; ++m) {
+                    const float* weights = melWeights.data() + melOffset[m];
+                    const float* p = power.data() + melFirst[m];
+                    float sum = 0.0f;
+                    for (int k = 0; k < melLength[m]; ++k) {
+                        sum += weights[k] * p[k];
+                    }
+                    mel[m] = sum;
+                    logMel[m] = 10.0f * std::log10(std::max(sum, LOG_FLOOR));
+                }
+            }
+
+            for (size_t f = 0; f < features.size(); ++f) {
+                float* row = out[f].data() + t * featureSize(features[f]);
+                switch (features[f]) {
+                    case AudioFeature::SPECTROGRAM:
+                        for (size_t k = 0; k < bins; ++k) {
+                            row[k] = std::sqrt(power[k]);
+                        }
+                        break;
+                    case AudioFeature::MEL_SPECTROGRAM:
+                        std::copy(mel.begin(), mel.end(), row);
+                        break;
+                    case AudioFeature::MFCC:
+                        for (int c = 0; c < coefficients; ++c) {
+                            const float* basis = dct.data() + static_cast<size_t>(c) * bands;
+                            float sum = 0.0f;
+                            for (int m = 0; m < bands; ++m) {
+                                sum += basis[m] * logMel[m];
+                            }
+                            row[c] = sum;
+                        }
+                        break;
+                }
+            }
+        }
+    });
+}
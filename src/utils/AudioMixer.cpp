@@ -0,0 +1,214 @@
+#include "AudioMixer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 256;
+    constexpr double PI = 3.14159265358979323846;
+
+    // Reciprocal of a duration; zero-length stages get a huge slope so they end at once
+    inline float inverseDuration(float seconds) {
+        return seconds > 0.0f ? 1.0f / seconds : 1e30f;
+    }
+
+    // Zeroth-order modified Bessel function of the first kind (series)
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 50; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12) {
+                break;
+            }
+        }
+        return sum;
+    }
+}
+
+AudioMixer::AudioMixer(double sampleRate)
+    : sampleRate(sampleRate), position(0) {
+    if (sampleRate <= 0.0) {
+        throw std::invalid_argument("Sample rate must be positive");
+    }
+}
+
+void AudioMixer::addTrack(const MixerTrack& track) {
+    if (!track.source) {
+        throw std::invalid_argument("Mixer track has no source");
+    }
+    if (track.start < 0) {
+        throw std::invalid_argument("Mixer track start must not be negative");
+    }
+    tracks.push_back(track);
+}
+
+void AudioMixer::render(float* out, size_t count) {
+    float scratch[BLOCK_SIZE];
+    const float dt = static_cast<float>(1.0 / sampleRate);
+
+    for (size_t done = 0; done < count; done += BLOCK_SIZE) {
+        const size_t block = std::min(BLOCK_SIZE, count - done);
+        float* dst = out + done;
+        std::fill(dst, dst + block, 0.0f);
+
+        const std::int64_t blockBegin = position;
+        const std::int64_t blockEnd = position + static_cast<std::int64_t>(block);
+        for (MixerTrack& track : tracks) {
+            const std::int64_t trackEnd = track.length < 0 ? std::numeric_limits<std::int64_t>::max() : track.start + track.length;
+            const std::int64_t first = std::max(blockBegin, track.start);
+            const std::int64_t last = std::min(blockEnd, trackEnd);
+            if (first >= last) {
+                continue;
+            }
+            const int span = static_cast<int>(last - first);
+            track.source(scratch, static_cast<size_t>(span));
+
+            // Gain curve in seconds since the track started; an open-ended track never
+            // reaches its release or fade-out
+            const Envelope& env = track.envelope;
+            const float t0 = static_cast<float>((first - track.start) / sampleRate);
+            const float trackSeconds = track.length < 0 ? 1e30f : static_cast<float>(track.length / sampleRate);
+            const float attack = env.attack;
+            const float invAttack = env.attack > 0.0f ? 1.0f / env.attack : 0.0f;
+            const float invDecay = inverseDuration(env.decay);
+            const float invRelease = inverseDuration(env.release);
+            const float invFadeIn = inverseDuration(track.fadeIn);
+            const float invFadeOut = inverseDuration(track.fadeOut);
+            const float sustainDrop = 1.0f - env.sustain;
+            const float gain = track.gain;
+
+            float* mix = dst + (first - blockBegin);
+            for (int k = 0; k < span; ++k) {
+                const float t = t0 + static_cast<float>(k) * dt;
+                const float remaining = trackSeconds - t;
+                const float decay = std::min(std::max((t - attack) * invDecay, 0.0f), 1.0f);
+                float level = t < attack ? t * invAttack : 1.0f - sustainDrop * decay;
+                level *= std::min(remaining * invRelease, 1.0f);
+                level *= std::min((t + dt) * invFadeIn, 1.0f);
+                level *= std::min(remaining * invFadeOut, 1.0f);
+                mix[k] += scratch[k] * (gain * level);
+            }
+        }
+
+        position = blockEnd;
+    }
+}
+
+Resampler::Resampler(int inputRate, int outputRate, int tapsPerPhase)
+    : outputRate(outputRate), bufferStart(0), inputCount(0), outputCount(0) {
+    if (inputRate <= 0 || outputRate <= 0) {
+        throw std::invalid_argument("Sample rates must be positive");
+    }
+    if (tapsPerPhase < 2) {
+        throw std::invalid_argument("Resampler needs at least two taps per phase");
+    }
+    const std::int64_t divisor = std::gcd(inputRate, outputRate);
+    up = outputRate / divisor;
+    down = inputRate / divisor;
+
+    // Downsampling lowers the cutoff below the output Nyquist and widens the kernel by
+    // the same ratio; taps are a multiple of 8 for the unrolled dot product
+    const double ratio = std::min(1.0, static_cast<double>(up) / static_cast<double>(down));
+    taps = static_cast<int>(std::ceil(tapsPerPhase / ratio));
+    taps = (taps + 7) / 8 * 8;
+    const int half = taps / 2;
+    const double cutoff = 0.5 * ratio * 0.92;  // cycles per input sample, leaving a transition band
+    const double beta = 8.0;
+    const double windowScale = 1.0 / besselI0(beta);
+
+    // Phase p interpolates at center + p / up; tap k sits (p / up + half - 1 - k) samples away
+    coefficients.resize(static_cast<size_t>(up) * taps);
+    for (std::int64_t p = 0; p < up; ++p) {
+        float* row = coefficients.data() + p * taps;
+        double sum = 0.0;
+        for (int k = 0; k < taps; ++k) {
+            const double t = static_cast<double>(p) / up + half - 1 - k;
+            const double x = t / half;
+            const double window = x * x < 1.0 ? besselI0(beta * std::sqrt(1.0 - x * x)) * windowScale : 0.0;
+            const double arg = 2.0 * cutoff * t;
+            const double sinc = arg == 0.0 ? 1.0 : std::sin(PI * arg) / (PI * arg);
+            const double value = 2.0 * cutoff * sinc * window;
+            row[k] = static_cast<float>(value);
+            sum += value;
+        }
+        // Unity DC gain in every phase, so a constant input has no phase-dependent ripple
+        for (int k = 0; k < taps; ++k) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+
+    // Zero history before the first input sample
+    buffer.assign(half, 0.0f);
+    bufferStart = -half;
+}
+
+int Resampler::getOutputRate() const {
+    return outputRate;
+}
+
+void Resampler::emit(std::vector<float>& out, std::int64_t available, std::int64_t limit) {
+    const int half = taps / 2;
+
+    // Output n needs input up to floor(n * down / up) + half, so everything below
+    // end can be produced from what is buffered
+    const std::int64_t end = std::min(limit, ((available - half) * up + down - 1) / down);
+    if (end > outputCount) {
+        const size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(end - outputCount));
+        float* dst = out.data() + offset;
+
+        // Walk the center and phase incrementally instead of dividing per sample
+        const std::int64_t centerStep = down / up;
+        const std::int64_t phaseStep = down % up;
+        std::int64_t center = (outputCount * down) / up;
+        std::int64_t phase = (outputCount * down) % up;
+        const float* x = buffer.data() + (center - half + 1 - bufferStart);
+        for (std::int64_t n = outputCount; n < end; ++n) {
+            const float* c = coefficients.data() + phase * taps;
+
+            // Eight independent partial sums so the multiply-adds vectorize without
+            // reassociating one float accumulator
+            float acc[8] = {};
+            for (int k = 0; k < taps; k += 8) {
+                for (int l = 0; l < 8; ++l) {
+                    acc[l] += c[k + l] * x[k + l];
+                }
+            }
+            *dst++ = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+
+            phase += phaseStep;
+            std::int64_t step = centerStep;
+            if (phase >= up) {
+                phase -= up;
+                ++step;
+            }
+            x += step;
+        }
+        outputCount = end;
+    }
+
+    // Drop input no later output will read
+    const std::int64_t keep = (outputCount * down) / up - half + 1;
+    const std::int64_t drop = std::min<std::int64_t>(keep - bufferStart, static_cast<std::int64_t>(buffer.size()));
+    if (drop > 0) {
+        buffer.erase(buffer.begin(), buffer.begin() + drop);
+        bufferStart += drop;
+    }
+}
+
+void Resampler::process(const float* in, size_t count, std::vector<float>& out) {
+    buffer.insert(buffer.end(), in, in + count);
+    inputCount += static_cast<std::int64_t>(count);
+    emit(out, bufferStart + static_cast<std::int64_t>(buffer.size()), std::numeric_limits<std::int64_t>::max());
+}
+
+void Resampler::finish(std::vector<float>& out) {
+    // Zero-pad past the end so the last outputs see a complete window
+    buffer.insert(buffer.end(), static_cast<size_t>(taps), 0.0f);
+    const std::int64_t total = (inputCount * up + down - 1) / down;
+    emit(out, bufferStart + static_cast<std::int64_t>(buffer.size()), total);
+}
@@ -0,0 +1,112 @@
+#include "CholeskyFactor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr double SYMMETRY_TOLERANCE = 1e-9;
+    // Pivots this small are treated as an exactly dependent row
+    constexpr double PIVOT_TOLERANCE = 1e-12;
+    constexpr double RESIDUAL_TOLERANCE = 1e-8;
+
+    // Rows of the input kept in cache while the panels of L stream past them
+    constexpr size_t ROW_TILE = 64;
+
+    // ROWS x LANES block of outputs accumulated in registers over the panel depth:
+    // every panel load feeds ROWS multiply-adds and every input value LANES
+    template<size_t ROWS>
+    void mixTile(const double* in, size_t n, const double* panel, size_t depth, double* out, size_t columns) {
+        constexpr size_t LANES = CholeskyFactor::LANES;
+        double acc[ROWS][LANES] = {};
+        for (size_t j = 0; j < depth; ++j) {
+            const double* lane = panel + j * LANES;
+            for (size_t r = 0; r < ROWS; ++r) {
+                const double x = in[r * n + j];
+                for (size_t c = 0; c < LANES; ++c) {
+                    acc[r][c] += x * lane[c];
+                }
+            }
+        }
+        for (size_t r = 0; r < ROWS; ++r) {
+            for (size_t c = 0; c < columns; ++c) {
+                out[r * n + c] = acc[r][c];
+            }
+        }
+    }
+}
+
+CholeskyFactor::CholeskyFactor(const std::vector<double>& matrix, size_t size)
+    : n(size) {
+    if (size == 0 || matrix.size() != size * size) {
+        throw std::invalid_argument("Cholesky factorization needs a non-empty square matrix");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            if (std::fabs(matrix[i * n + j] - matrix[j * n + i]) > SYMMETRY_TOLERANCE) {
+                throw std::invalid_argument("Matrix is not symmetric");
+            }
+        }
+    }
+
+    // Row by row (Cholesky-Banachiewicz) into a row-major L, so every update is a
+    // contiguous dot product of two earlier rows
+    std::vector<double> lower(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        double* rowI = lower.data() + i * n;
+        for (size_t j = 0; j <= i; ++j) {
+            const double* rowJ = lower.data() + j * n;
+            double sum = matrix[i * n + j];
+            for (size_t k = 0; k < j; ++k) {
+                sum -= rowI[k] * rowJ[k];
+            }
+            if (j < i) {
+                if (rowJ[j] > 0.0) {
+                    rowI[j] = sum / rowJ[j];
+                } else if (std::fabs(sum) > RESIDUAL_TOLERANCE) {
+                    throw std::invalid_argument("Matrix is not positive semi-definite");
+                }
+            } else if (sum < -PIVOT_TOLERANCE) {
+                throw std::invalid_argument("Matrix is not positive semi-definite");
+            } else {
+                rowI[i] = sum > PIVOT_TOLERANCE ? std::sqrt(sum) : 0.0;
+            }
+        }
+    }
+
+    // Pack L into panels of LANES rows stored column by column
+    const size_t numPanels = (n + LANES - 1) / LANES;
+    panels.assign(numPanels * n * LANES, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        double* panel = panels.data() + (i / LANES) * n * LANES;
+        for (size_t j = 0; j <= i; ++j) {
+            panel[j * LANES + i % LANES] = lower[i * n + j];
+        }
+    }
+}
+
+double CholeskyFactor::at(size_t i, size_t j) const {
+    if (i >= n || j > i) {
+        return 0.0;
+    }
+    return panels[(i / LANES) * n * LANES + j * LANES + i % LANES];
+}
+
+void CholeskyFactor::apply(const double* in, double* out, size_t rows) const {
+    // out[r][i] is the dot product of in[r] with row i of L, which is zero past column i,
+    // so a panel needs only the first (its last row + 1) input columns
+    for (size_t r0 = 0; r0 < rows; r0 += ROW_TILE) {
+        const size_t r1 = std::min(rows, r0 + ROW_TILE);
+        for (size_t i0 = 0; i0 < n; i0 += LANES) {
+            const double* panel = panels.data() + (i0 / LANES) * n * LANES;
+            const size_t depth = std::min(n, i0 + LANES);
+            const size_t columns = std::min(LANES, n - i0);
+            size_t r = r0;
+            for (; r + 4 <= r1; r += 4) {
+                mixTile<4>(in + r * n, n, panel, depth, out + r * n + i0, columns);
+            }
+            for (; r < r1; ++r) {
+                mixTile<1>(in + r * n, n, panel, depth, out + r * n + i0, columns);
+            }
+        }
+    }
+}
@@ -0,0 +1,142 @@
+#include "ColoredNoise.h"
+#include <algorithm>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 256;
+    constexpr double TWO_PI = 6.28318530717958647692;
+
+    // RMS of uniform [-1, 1) white noise
+    constexpr float WHITE_RMS = 0.57735027f;
+    constexpr float TARGET_RMS = 1.0f / 3.0f;
+
+    // Independent white streams drawn at the same counter positions
+    constexpr std::uint32_t SAMPLE_STREAM = 0;
+    constexpr std::uint32_t ROW_STREAM = 0x68e31da4u;
+    constexpr std::uint32_t INITIAL_STREAM = 0xb5297a4du;
+
+    inline std::uint32_t hash32(std::uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    inline int trailingZeros(std::uint32_t x) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, x);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(x);
+#endif
+    }
+}
+
+ColoredNoise::ColoredNoise(NoiseColor color, double sampleRate, std::uint64_t seed)
+    : color(color), key(hash32(static_cast<std::uint32_t>(seed) ^ hash32(static_cast<std::uint32_t>(seed >> 32)))),
+    counter(0), rowSum(0.0f), pinkCounter(0), brownState(0.0f), previous(0.0f) {
+    // Brown noise leaks below ~20 Hz so it stays bounded; the scale undoes the integrator's gain
+    double leak = std::exp(-TWO_PI * 20.0 / sampleRate);
+    brownLeak = static_cast<float>(leak);
+    brownScale = static_cast<float>(std::sqrt(1.0 - leak * leak)) * TARGET_RMS / WHITE_RMS;
+
+    // Start the pink rows filled so the output is stationary from the first sample
+    fillWhite(rows.data(), rows.size(), INITIAL_STREAM);
+    for (float row : rows) {
+        rowSum += row;
+    }
+}
+
+void ColoredNoise::fillWhite(float* out, size_t count, std::uint32_t stream) const {
+    // The high counter bits fold into the key once per call; the loop itself only
+    // hashes 32-bit lanes, which vectorizes
+    std::uint32_t blockKey = (key ^ stream) + hash32(static_cast<std::uint32_t>(counter >> 32));
+    std::uint32_t base = static_cast<std::uint32_t>(counter);
+    for (size_t i = 0; i < count; ++i) {
+        std::uint32_t h = hash32(blockKey + base + static_cast<std::uint32_t>(i));
+        out[i] = static_cast<float>(static_cast<std::int32_t>(h >> 8)) * (1.0f / 8388608.0f) - 1.0f;
+    }
+}
+
+void ColoredNoise::renderPink(const float* white, const float* rowWhite, float* out, size_t count) {
+    // Voss-McCartney: each sample redraws the row given by the counter's trailing zeros,
+    // so rows update at halving rates and the running sum has a 1/f spectrum
+    const float scale = TARGET_RMS / (WHITE_RMS * std::sqrt(static_cast<float>(PINK_ROWS + 1)));
+    for (size_t i = 0; i < count; ++i) {
+        ++pinkCounter;
+        int row = pinkCounter != 0 ? trailingZeros(pinkCounter) : PINK_ROWS;
+        if (row < PINK_ROWS) {
+            rowSum += rowWhite[i] - rows[row];
+            rows[row] = rowWhite[i];
+        }
+        out[i] = (rowSum + white[i]) * scale;
+    }
+}
+
+void ColoredNoise::render(float* out, size_t count, float amplitude) {
+    float white[BLOCK_SIZE];
+    float rowWhite[BLOCK_SIZE];
+    float shaped[BLOCK_SIZE];
+
+    for (size_t done = 0; done < count; done += BLOCK_SIZE) {
+        const size_t block = std::min(BLOCK_SIZE, count - done);
+        float* dst = out + done;
+        fillWhite(white, block, SAMPLE_STREAM);
+
+        switch (color) {
+            case NoiseColor::WHITE: {
+                const float scale = amplitude * TARGET_RMS / WHITE_RMS;
+                for (size_t i = 0; i < block; ++i) {
+                    dst[i] = white[i] * scale;
+                }
+                break;
+            }
+            case NoiseColor::PINK:
+                fillWhite(rowWhite, block, ROW_STREAM);
+                renderPink(white, rowWhite, shaped, block);
+                for (size_t i = 0; i < block; ++i) {
+                    dst[i] = shaped[i] * amplitude;
+                }
+                break;
+            case NoiseColor::BROWN: {
+                // A first-order recursion; one multiply-add per sample
+                float state = brownState;
+                const float scale = amplitude * brownScale;
+                for (size_t i = 0; i < block; ++i) {
+                    state = brownLeak * state + white[i];
+                    dst[i] = state * scale;
+                }
+                brownState = state;
+                break;
+            }
+            case NoiseColor::BLUE:
+            case NoiseColor::VIOLET: {
+                // Differencing tilts the spectrum up by 6 dB/octave; it doubles white power
+                // and scales pink power by about 0.24, hence the different gains
+                if (color == NoiseColor::BLUE) {
+                    fillWhite(rowWhite, block, ROW_STREAM);
+                    renderPink(white, rowWhite, shaped, block);
+                } else {
+                    for (size_t i = 0; i < block; ++i) {
+                        shaped[i] = white[i] * (TARGET_RMS / WHITE_RMS);
+                    }
+                }
+                const float gain = amplitude * (color == NoiseColor::BLUE ? 2.06f : 0.70710678f);
+                dst[0] = (shaped[0] - previous) * gain;
+                for (size_t i = 1; i < block; ++i) {
+                    dst[i] = (shaped[i] - shaped[i - 1]) * gain;
+                }
+                previous = shaped[block - 1];
+                break;
+            }
+        }
+
+        counter += block;
+    }
+}
@@ -0,0 +1,204 @@
+#include "DateTime.h"
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    inline bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Read 1..maxDigits digits at text[pos]
+    bool readNumber(std::string_view text, size_t& pos, size_t maxDigits, unsigned& value) {
+        const size_t start = pos;
+        value = 0;
+        while (pos < text.size() && pos - start < maxDigits && isDigit(text[pos])) {
+            value = value * 10 + static_cast<unsigned>(text[pos] - '0');
+            ++pos;
+        }
+        return pos > start;
+    }
+}
+
+std::int64_t DateTime::daysFromCivil(std::int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2 ? 1 : 0;
+    const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<std::int64_t>(dayOfEra) - 719468;
+}
+
+void DateTime::civilFromDays(std::int64_t days, std::int64_t& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = static_cast<std::int64_t>(yearOfEra) + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+std::int64_t DateTime::parseDate(std::string_view text) {
+    // Lenient about leading zeros; a time part after 'T' or ' ' is ignored
+    size_t pos = 0;
+    unsigned year, month, day;
+    bool valid = readNumber(text, pos, 4, year) && pos < text.size() && text[pos++] == '-'
+        && readNumber(text, pos, 2, month) && pos < text.size() && text[pos++] == '-'
+        && readNumber(text, pos, 2, day)
+        && (pos == text.size() || text[pos] == 'T' || text[pos] == ' ');
+    if (valid && month >= 1 && month <= 12 && day >= 1) {
+        const std::int64_t first = daysFromCivil(year, month, 1);
+        const std::int64_t next = month == 12 ? daysFromCivil(year + 1, 1, 1) : daysFromCivil(year, month + 1, 1);
+        if (day <= next - first) {
+            return first + day - 1;
+        }
+    }
+    throw std::invalid_argument("Invalid date (expected YYYY-MM-DD): " + std::string(text));
+}
+
+int DateTime::localOffset(std::int64_t epochSeconds) {
+    const std::time_t instant = static_cast<std::time_t>(epochSeconds);
+    std::tm local;
+#ifdef _WIN32
+    if (localtime_s(&local, &instant) != 0) {
+        return 0;
+    }
+#else
+    if (localtime_r(&instant, &local) == nullptr) {
+        return 0;
+    }
+#endif
+    // Read the local wall clock back as if it were UTC
+    const std::int64_t wall = daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * SECONDS_PER_DAY
+        + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    return static_cast<int>(wall - epochSeconds);
+}
+
+char* DateTime::writeDate(std::int64_t days, char* out) {
+    std::int64_t year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+    write4(out, static_cast<unsigned>(year < 0 ? 0 : year > 9999 ? 9999 : year));
+    out[4] = '-';
+    write2(out + 5, month);
+    out[7] = '-';
+    write2(out + 8, day);
+    return out + 10;
+}
+
+char* DateTime::writeTime(unsigned secondOfDay, char* out) {
+    write2(out, secondOfDay / 3600);
+    out[2] = ':';
+    write2(out + 3, secondOfDay / 60 % 60);
+    out[5] = ':';
+    write2(out + 6, secondOfDay % 60);
+    return out + 8;
+}
+
+char* DateTime::writeInteger(std::int64_t value, char* out) {
+    std::uint64_t magnitude = static_cast<std::uint64_t>(value);
+    if (value < 0) {
+        *out++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    char digits[20];
+    char* start = digits + sizeof(digits);
+    do {
+        *--start = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (start != digits + sizeof(digits)) {
+        *out++ = *start++;
+    }
+    return out;
+}
+
+TimestampFormatter::TimestampFormatter(TimestampFormat format, TimeZone zone)
+    : timestampFormat(format), zone(zone), length(0),
+    renderedDay(std::numeric_limits<std::int64_t>::min()), renderedHour(-1), renderedMinute(-1),
+    renderedOffset(std::numeric_limits<int>::min()), offset(0), offsetFrom(0), offsetUntil(0) {
+}
+
+int TimestampFormatter::offsetAt(std::int64_t epochSeconds) {
+    if (epochSeconds >= offsetFrom && epochSeconds < offsetUntil) {
+        return offset;
+    }
+    // Zones never change their offset twice within a day, so an offset that is the same
+    // a day later holds throughout; otherwise bisect for the change
+    offset = DateTime::localOffset(epochSeconds);
+    offsetFrom = epochSeconds;
+    std::int64_t low = epochSeconds;
+    std::int64_t high = epochSeconds + DateTime::SECONDS_PER_DAY;
+    if (DateTime::localOffset(high) != offset) {
+        while (high - low > 1) {
+            const std::int64_t middle = low + (high - low) / 2;
+            if (DateTime::localOffset(middle) == offset) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+    }
+    offsetUntil = high;
+    return offset;
+}
+
+std::string_view TimestampFormatter::format(std::int64_t epochSeconds) {
+    switch (timestampFormat) {
+    case TimestampFormat::EPOCH_SECONDS:
+        length = DateTime::writeInteger(epochSeconds, text) - text;
+        return std::string_view(text, length);
+    case TimestampFormat::EPOCH_MILLIS:
+        length = DateTime::writeInteger(epochSeconds * 1000, text) - text;
+        return std::string_view(text, length);
+    default:
+        break;
+    }
+
+    const int utcOffset = zone == TimeZone::UTC ? 0 : offsetAt(epochSeconds);
+    const std::int64_t wall = epochSeconds + utcOffset;
+    const std::int64_t day = DateTime::floorDiv(wall, DateTime::SECONDS_PER_DAY);
+    const unsigned secondOfDay = static_cast<unsigned>(wall - day * DateTime::SECONDS_PER_DAY);
+    const int hour = static_cast<int>(secondOfDay / 3600);
+    const int minute = static_cast<int>(secondOfDay / 60 % 60);
+
+    // Rewrite only the fields that differ from the previous timestamp
+    if (day != renderedDay) {
+        DateTime::writeDate(day, text);
+        text[10] = timestampFormat == TimestampFormat::ISO_8601 ? 'T' : ' ';
+        DateTime::writeTime(secondOfDay, text + 11);
+        renderedDay = day;
+    } else {
+        if (hour != renderedHour) {
+            DateTime::write2(text + 11, static_cast<unsigned>(hour));
+        }
+        if (minute != renderedMinute) {
+            DateTime::write2(text + 14, static_cast<unsigned>(minute));
+        }
+        DateTime::write2(text + 17, secondOfDay % 60);
+    }
+    renderedHour = hour;
+    renderedMinute = minute;
+    length = 19;
+
+    if (timestampFormat == TimestampFormat::ISO_8601) {
+        if (zone == TimeZone::UTC) {
+            text[19] = 'Z';
+            length = 20;
+        } else {
+            if (utcOffset != renderedOffset) {
+                const unsigned magnitude = static_cast<unsigned>(utcOffset < 0 ? -utcOffset : utcOffset) / 60;
+                text[19] = utcOffset < 0 ? '-' : '+';
+                DateTime::write2(text + 20, magnitude / 60);
+                text[22] = ':';
+                DateTime::write2(text + 23, magnitude % 60);
+                renderedOffset = utcOffset;
+            }
+            length = 25;
+        }
+    }
+    return std::string_view(text, length);
+}
@@ -4,6 +4,80 @@
 #include <numeric>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    constexpr double INV_2_32 = 1.0 / 4294967296.0;
+
+    // Marsaglia-Tsang ziggurat for the standard normal with 128 layers. A draw uses 7 bits
+    // for the layer, one for the sign and 24 for the position in the layer; about 99% of
+    // draws are accepted by a single table comparison.
+    constexpr double ZIGGURAT_R = 3.442619855899;
+    constexpr double ZIGGURAT_AREA = 9.91256303526217e-3;
+    constexpr double POSITION_SCALE = 16777216.0;  // 2^24
+
+    struct Ziggurat {
+        std::uint32_t k[128];
+        double w[128];
+        double f[128];
+
+        Ziggurat() {
+            double dn = ZIGGURAT_R;
+            double tn = dn;
+            const double q = ZIGGURAT_AREA / std::exp(-0.5 * dn * dn);
+            k[0] = static_cast<std::uint32_t>((dn / q) * POSITION_SCALE);
+            k[1] = 0;
+            w[0] = q / POSITION_SCALE;
+            w[127] = dn / POSITION_SCALE;
+            f[0] = 1.0;
+            f[127] = std::exp(-0.5 * dn * dn);
+            for (int i = 126; i >= 1; --i) {
+                dn = std::sqrt(-2.0 * std::log(ZIGGURAT_AREA / dn + std::exp(-0.5 * dn * dn)));
+                k[i + 1] = static_cast<std::uint32_t>((dn / tn) * POSITION_SCALE);
+                tn = dn;
+                f[i] = std::exp(-0.5 * dn * dn);
+                w[i] = dn / POSITION_SCALE;
+            }
+        }
+    };
+
+    const Ziggurat& ziggurat() {
+        static const Ziggurat table;
+        return table;
+    }
+
+    inline double uniformOpen(std::mt19937& rng) {
+        return (static_cast<double>(rng()) + 0.5) * INV_2_32;
+    }
+
+    // Draws that miss the rectangle of their layer: the tail beyond R, or the wedge
+    // under the density, retrying with fresh bits on rejection
+    double zigguratSlow(std::mt19937& rng, std::uint32_t bits, const Ziggurat& table) {
+        while (true) {
+            const std::uint32_t layer = bits & 127;
+            const double sign = (bits & 128) ? -1.0 : 1.0;
+            const std::uint32_t position = bits >> 8;
+            const double x = position * table.w[layer];
+            if (position < table.k[layer]) {
+                return sign * x;
+            }
+            if (layer == 0) {
+                double tail;
+                double y;
+                do {
+                    tail = -std::log(uniformOpen(rng)) / ZIGGURAT_R;
+                    y = -std::log(uniformOpen(rng));
+                } while (y + y < tail * tail);
+                return sign * (ZIGGURAT_R + tail);
+            }
+            if (table.f[layer] + uniformOpen(rng) * (table.f[layer - 1] - table.f[layer]) < std::exp(-0.5 * x * x)) {
+                return sign * x;
+            }
+            bits = static_cast<std::uint32_t>(rng());
+        }
+    }
+}
 
 double Distributions::getNormal(double mean, double stddev) {
     std::normal_distribution<double> distribution(mean, stddev);
@@ -125,6 +199,39 @@ std::vector<double> Distributions::getMixture(const std::vector<double>& weights
     return samples;
 }
 
+void Distributions::fillUniform(std::mt19937& rng, double* out, size_t count, double min, double max) {
+    if (min > max) {
+        throw std::invalid_argument("Min value must be less than or equal to max value");
+    }
+    const double scale = (max - min) * INV_2_32;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = min + static_cast<double>(rng()) * scale;
+    }
+}
+
+void Distributions::fillNormal(std::mt19937& rng, double* out, size_t count, double mean, double stddev) {
+    if (stddev < 0.0) {
+        throw std::invalid_argument("Standard deviation must not be negative");
+    }
+    // Draws stay in sequence, slow path included, so a stream split into batches of any
+    // size yields the same values
+    const Ziggurat& table = ziggurat();
+    for (size_t i = 0; i < count; ++i) {
+        const std::uint32_t bits = static_cast<std::uint32_t>(rng());
+        const std::uint32_t layer = bits & 127;
+        const std::uint32_t position = bits >> 8;
+        double x;
+        if (position < table.k[layer]) {
+            // Positions fit 24 bits, so the signed conversion is exact and cheaper
+            x = static_cast<std::int32_t>(position) * table.w[layer];
+            x = (bits & 128) ? -x : x;
+        } else {
+            x = zigguratSlow(rng, bits, table);
+        }
+        out[i] = mean + stddev * x;
+    }
+}
+
 std::mt19937& Distributions::getGenerator() {
     static bool initialized = false;
     static std::mt19937 generator;
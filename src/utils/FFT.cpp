@@ -0,0 +1,111 @@
+#include "FFT.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr double TWO_PI = 6.28318530717958647692;
+
+    // One group of radix-2 butterflies. The halves never overlap; saying so lets the
+    // compiler vectorize without runtime alias checks on an unknown stride.
+    void butterflyGroup(float* __restrict ar, float* __restrict ai, float* __restrict br, float* __restrict bi,
+        const float* __restrict wr, const float* __restrict wi, size_t count) {
+        for (size_t j = 0; j < count; ++j) {
+            const float tr = br[j] * wr[j] - bi[j] * wi[j];
+            const float ti = br[j] * wi[j] + bi[j] * wr[j];
+            br[j] = ar[j] - tr;
+            bi[j] = ai[j] - ti;
+            ar[j] += tr;
+            ai[j] += ti;
+        }
+    }
+}
+
+FFT::FFT(size_t size)
+    : n(size), half(size / 2) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument("FFT size must be a power of two of at least 2");
+    }
+
+    int bits = 0;
+    while ((static_cast<size_t>(1) << bits) < half) {
+        ++bits;
+    }
+    bitReverse.resize(half);
+    for (size_t i = 0; i < half; ++i) {
+        std::uint32_t reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= static_cast<std::uint32_t>((i >> b) & 1) << (bits - 1 - b);
+        }
+        bitReverse[i] = reversed;
+    }
+
+    stageCos.resize(half > 1 ? half - 1 : 0);
+    stageSin.resize(stageCos.size());
+    for (size_t span = 2; span <= half; span *= 2) {
+        const size_t h = span / 2;
+        for (size_t j = 0; j < h; ++j) {
+            const double angle = -TWO_PI * static_cast<double>(j) / static_cast<double>(span);
+            stageCos[h - 1 + j] = static_cast<float>(std::cos(angle));
+            stageSin[h - 1 + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    unpackCos.resize(half + 1);
+    unpackSin.resize(half + 1);
+    for (size_t k = 0; k <= half; ++k) {
+        const double angle = -TWO_PI * static_cast<double>(k) / static_cast<double>(n);
+        unpackCos[k] = static_cast<float>(std::cos(angle));
+        unpackSin[k] = static_cast<float>(std::sin(angle));
+    }
+}
+
+size_t FFT::size() const {
+    return n;
+}
+
+size_t FFT::numBins() const {
+    return half + 1;
+}
+
+void FFT::butterflies(float* re, float* im) const {
+    const size_t points = half;
+    for (size_t h = 1; h < points; h *= 2) {
+        const float* wr = stageCos.data() + (h - 1);
+        const float* wi = stageSin.data() + (h - 1);
+        for (size_t base = 0; base < points; base += 2 * h) {
+            butterflyGroup(re + base, im + base, re + base + h, im + base + h, wr, wi, h);
+        }
+    }
+}
+
+void FFT::forwardReal(const float* in, float* re, float* im) const {
+    // Pack z[j] = x[2j] + i x[2j + 1], scattered straight into bit-reversed order
+    for (size_t j = 0; j < half; ++j) {
+        re[bitReverse[j]] = in[2 * j];
+        im[bitReverse[j]] = in[2 * j + 1];
+    }
+    butterflies(re, im);
+
+    // Unpack: with E = (Z[k] + conj(Z[M-k])) / 2 and O = (Z[k] - conj(Z[M-k])) / 2i,
+    // X[k] = E + W^k O and X[M-k] = conj(E - W^k O), so each pair is done in one step
+    const float r0 = re[0];
+    const float i0 = im[0];
+    re[0] = r0 + i0;
+    im[0] = 0.0f;
+    re[half] = r0 - i0;
+    im[half] = 0.0f;
+    for (size_t k = 1; k <= half / 2; ++k) {
+        const size_t m = half - k;
+        const float a = re[k], b = im[k], c = re[m], d = im[m];
+        const float er = 0.5f * (a + c);
+        const float ei = 0.5f * (b - d);
+        const float orr = 0.5f * (b + d);
+        const float oi = -0.5f * (a - c);
+        const float tr = unpackCos[k] * orr - unpackSin[k] * oi;
+        const float ti = unpackCos[k] * oi + unpackSin[k] * orr;
+        re[k] = er + tr;
+        im[k] = ei + ti;
+        re[m] = er - tr;
+        im[m] = -(ei - ti);
+    }
+}
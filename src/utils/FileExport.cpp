@@ -1,4 +1,7 @@
 #include "FileExport.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -241,4 +244,84 @@ void FileExport::exportToINI(const std::string& filename,
     }
 
     file.close();
-}
\ No newline at end of file
+}
+
+namespace {
+    // Write an .npy file of count elements of size bytes each, little-endian; bits(i)
+    // returns element i as an unsigned integer of that size
+    template<typename Bits, typename GetBits>
+    void writeNPY(const std::string& filename, const std::vector<size_t>& shape, const char* descr, GetBits bits) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file for writing: " + filename);
+        }
+
+        // Header dict, space-padded so the data starts on a 64-byte boundary
+        size_t count = 1;
+        std::string header = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': (";
+        for (size_t i = 0; i < shape.size(); ++i) {
+            header += (i > 0 ? ", " : "") + std::to_string(shape[i]);
+            count *= shape[i];
+        }
+        if (shape.size() == 1) {
+            header += ",";  // a one-element tuple needs its trailing comma
+        }
+        header += "), }";
+        const size_t preamble = 10;  // magic, version and header length
+        header.append(63 - (preamble + header.size()) % 64, ' ');
+        header += '\n';
+
+        const unsigned char magic[8] = { 0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+        file.write(reinterpret_cast<const char*>(magic), sizeof(magic));
+        file.put(static_cast<char>(header.size() & 0xff));
+        file.put(static_cast<char>(header.size() >> 8));
+        file << header;
+
+        // Data in large little-endian blocks regardless of the host byte order
+        const size_t width = sizeof(Bits);
+        std::vector<unsigned char> buffer(std::min<size_t>(count, 1 << 16) * width);
+        for (size_t offset = 0; offset < count; offset += buffer.size() / width) {
+            const size_t block = std::min(buffer.size() / width, count - offset);
+            for (size_t i = 0; i < block; ++i) {
+                const Bits value = bits(offset + i);
+                for (size_t b = 0; b < width; ++b) {
+                    buffer[width * i + b] = static_cast<unsigned char>(value >> (8 * b));
+                }
+            }
+            file.write(reinterpret_cast<const char*>(buffer.data()), block * width);
+        }
+
+        file.close();
+        if (!file) {
+            throw std::runtime_error("Failed to write file: " + filename);
+        }
+    }
+}
+
+void FileExport::exportToNPY(const std::string& filename,
+    const std::vector<size_t>& shape,
+    const float* data) {
+    writeNPY<std::uint32_t>(filename, shape, "<f4", [data](size_t i) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &data[i], sizeof(bits));
+        return bits;
+    });
+}
+
+void FileExport::exportToNPY(const std::string& filename,
+    const std::vector<size_t>& shape,
+    const std::uint16_t* data) {
+    writeNPY<std::uint16_t>(filename, shape, "<u2", [data](size_t i) { return data[i]; });
+}
+
+void FileExport::exportToNPY(const std::string& filename,
+    const std::vector<size_t>& shape,
+    const std::uint32_t* data) {
+    writeNPY<std::uint32_t>(filename, shape, "<u4", [data](size_t i) { return data[i]; });
+}
+
+void FileExport::exportToNPY(const std::string& filename,
+    const std::vector<size_t>& shape,
+    const std::uint64_t* data) {
+    writeNPY<std::uint64_t>(filename, shape, "<u8", [data](size_t i) { return data[i]; });
+}
@@ -0,0 +1,370 @@
+#include "ImageAugmentation.h"
+#include "ImageData.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr float PI = 3.14159265358979323846f;
+
+    // HSV jitter expressed as one linear RGB transform: hue is a rotation about the
+    // gray axis, saturation a blend towards luma, value a uniform gain
+    struct ColorMatrix {
+        float m[9];
+        bool identity;
+    };
+
+    ColorMatrix buildColorMatrix(const AugmentationParams& params) {
+        ColorMatrix color;
+        color.identity = params.hueShiftDegrees == 0.0f && params.saturationScale == 1.0f && params.valueScale == 1.0f;
+
+        float angle = params.hueShiftDegrees * PI / 180.0f;
+        float c = std::cos(angle);
+        float k = (1.0f - c) / 3.0f;
+        float q = std::sin(angle) / std::sqrt(3.0f);
+        float hue[9] = {
+            c + k, k - q, k + q,
+            k + q, c + k, k - q,
+            k - q, k + q, c + k
+        };
+
+        const float luma[3] = { 0.299f, 0.587f, 0.114f };
+        float s = params.saturationScale;
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                float sum = 0.0f;
+                for (int i = 0; i < 3; ++i) {
+                    float saturation = (row == i ? s : 0.0f) + (1.0f - s) * luma[i];
+                    sum += saturation * hue[i * 3 + col];
+                }
+                color.m[row * 3 + col] = params.valueScale * sum;
+            }
+        }
+        return color;
+    }
+
+    std::vector<float> gaussianKernel(float sigma) {
+        if (sigma <= 0.0f) {
+            return { 1.0f };
+        }
+        int radius = static_cast<int>(std::ceil(3.0f * sigma));
+        std::vector<float> weights(2 * radius + 1);
+        float sum = 0.0f;
+        for (int i = -radius; i <= radius; ++i) {
+            weights[i + radius] = std::exp(-(i * i) / (2.0f * sigma * sigma));
+            sum += weights[i + radius];
+        }
+        for (float& w : weights) {
+            w /= sum;
+        }
+        return weights;
+    }
+
+    // Sample one output row of the composed crop/flip/rotate map into out (width * channels floats)
+    template<typename T>
+    void warpRow(const Image& src, const AugmentationParams& params, int outWidth, int outHeight, int v, float* out) {
+        const int channels = src.channels;
+        const T* pixels = reinterpret_cast<const T*>(src.data.data());
+
+        // Flips act in output space, before rotation about the crop center
+        float flippedV = params.flipVertical ? static_cast<float>(outHeight - 1 - v) : static_cast<float>(v);
+
+        if (params.rotationDegrees == 0.0f) {
+            // Pure crop/flip: integer source coordinates, a straight row copy
+            int sy = params.cropY + static_cast<int>(flippedV);
+            const T* srcRow = pixels + (static_cast<size_t>(sy) * src.width + params.cropX) * channels;
+            if (!params.flipHorizontal) {
+                for (int i = 0; i < outWidth * channels; ++i) {
+                    out[i] = srcRow[i];
+                }
+            } else {
+                for (int u = 0; u < outWidth; ++u) {
+                    const T* p = srcRow + (outWidth - 1 - u) * channels;
+                    for (int c = 0; c < channels; ++c) {
+                        out[u * channels + c] = p[c];
+                    }
+                }
+            }
+            return;
+        }
+
+        float angle = params.rotationDegrees * PI / 180.0f;
+        float cosA = std::cos(angle);
+        float sinA = std::sin(angle);
+        float cx = (outWidth - 1) * 0.5f;
+        float cy = (outHeight - 1) * 0.5f;
+        float flipSign = params.flipHorizontal ? -1.0f : 1.0f;
+        float flipOffset = params.flipHorizontal ? static_cast<float>(outWidth - 1) : 0.0f;
+
+        // Source position is affine in u, so step it incrementally along the row
+        float ry = flippedV - cy;
+        float sx = cosA * (flipOffset - cx) - sinA * ry + cx + params.cropX;
+        float sy = sinA * (flipOffset - cx) + cosA * ry + cy + params.cropY;
+        float stepX = cosA * flipSign;
+        float stepY = sinA * flipSign;
+        float maxX = static_cast<float>(src.width - 1);
+        float maxY = static_cast<float>(src.height - 1);
+
+        for (int u = 0; u < outWidth; ++u) {
+            float x = std::clamp(sx + u * stepX, 0.0f, maxX);
+            float y = std::clamp(sy + u * stepY, 0.0f, maxY);
+            int x0 = static_cast<int>(x);
+            int y0 = static_cast<int>(y);
+            int x1 = std::min(x0 + 1, src.width - 1);
+            int y1 = std::min(y0 + 1, src.height - 1);
+            float fx = x - x0;
+            float fy = y - y0;
+
+            const T* p00 = pixels + (static_cast<size_t>(y0) * src.width + x0) * channels;
+            const T* p10 = pixels + (static_cast<size_t>(y0) * src.width + x1) * channels;
+            const T* p01 = pixels + (static_cast<size_t>(y1) * src.width + x0) * channels;
+            const T* p11 = pixels + (static_cast<size_t>(y1) * src.width + x1) * channels;
+            for (int c = 0; c < channels; ++c) {
+                float top = p00[c] + fx * (p10[c] - p00[c]);
+                float bottom = p01[c] + fx * (p11[c] - p01[c]);
+                out[u * channels + c] = top + fy * (bottom - top);
+            }
+        }
+    }
+
+    void applyColor(const ColorMatrix& color, int width, int channels, float* row) {
+        if (color.identity) {
+            return;
+        }
+        if (channels < 3) {
+            // Gray images only take the value gain (a gray pixel is a fixed point of hue/saturation)
+            float gain = color.m[0] + color.m[1] + color.m[2];
+            for (int x = 0; x < width; ++x) {
+                row[x * channels] *= gain;
+            }
+            return;
+        }
+        const float* m = color.m;
+        for (int x = 0; x < width; ++x) {
+            float* p = row + x * channels;
+            float r = p[0], g = p[1], b = p[2];
+            p[0] = m[0] * r + m[1] * g + m[2] * b;
+            p[1] = m[3] * r + m[4] * g + m[5] * b;
+            p[2] = m[6] * r + m[7] * g + m[8] * b;
+        }
+    }
+
+    void blurRowHorizontal(const std::vector<float>& weights, int width, int channels, const float* in, float* out) {
+        int radius = static_cast<int>(weights.size()) / 2;
+        if (radius == 0) {
+            std::copy(in, in + width * channels, out);
+            return;
+        }
+
+        // Edge pixels clamp their taps; the interior is a flat, branch-free loop
+        auto edgePixel = [&](int x) {
+            for (int c = 0; c < channels; ++c) {
+                float sum = 0.0f;
+                for (int k = -radius; k <= radius; ++k) {
+                    int xs = std::clamp(x + k, 0, width - 1);
+                    sum += weights[k + radius] * in[xs * channels + c];
+                }
+                out[x * channels + c] = sum;
+            }
+        };
+
+        int interiorBegin = std::min(radius, width);
+        int interiorEnd = std::max(interiorBegin, width - radius);
+        for (int x = 0; x < interiorBegin; ++x) {
+            edgePixel(x);
+        }
+        for (int i = interiorBegin * channels; i < interiorEnd * channels; ++i) {
+            out[i] = 0.0f;
+        }
+        for (int k = -radius; k <= radius; ++k) {
+            float w = weights[k + radius];
+            const float* shifted = in + k * channels;
+            for (int i = interiorBegin * channels; i < interiorEnd * channels; ++i) {
+                out[i] += w * shifted[i];
+            }
+        }
+        for (int x = interiorEnd; x < width; ++x) {
+            edgePixel(x);
+        }
+    }
+}
+
+ImageAugmenter::ImageAugmenter()
+    : cropWidth(0), cropHeight(0), horizontalFlipProbability(0.0), verticalFlipProbability(0.0),
+    maxRotationDegrees(0.0f), minBlurSigma(0.0f), maxBlurSigma(0.0f),
+    hueJitter(0.0f), saturationJitter(0.0f), valueJitter(0.0f) {
+}
+
+void ImageAugmenter::setCrop(int width, int height) {
+    if (width < 0 || height < 0) {
+        throw std::invalid_argument("Crop size must not be negative");
+    }
+    cropWidth = width;
+    cropHeight = height;
+}
+
+void ImageAugmenter::setFlipProbability(double horizontal, double vertical) {
+    if (horizontal < 0.0 || horizontal > 1.0 || vertical < 0.0 || vertical > 1.0) {
+        throw std::invalid_argument("Probability must be between 0.0 and 1.0");
+    }
+    horizontalFlipProbability = horizontal;
+    verticalFlipProbability = vertical;
+}
+
+void ImageAugmenter::setRotationRange(float maxDegrees) {
+    maxRotationDegrees = std::abs(maxDegrees);
+}
+
+void ImageAugmenter::setBlurSigmaRange(float minSigma, float maxSigma) {
+    if (minSigma < 0.0f || minSigma > maxSigma) {
+        throw std::invalid_argument("Blur sigma range must satisfy 0 <= min <= max");
+    }
+    minBlurSigma = minSigma;
+    maxBlurSigma = maxSigma;
+}
+
+void ImageAugmenter::setHSVJitter(float hueDegrees, float saturation, float value) {
+    hueJitter = std::abs(hueDegrees);
+    saturationJitter = std::abs(saturation);
+    valueJitter = std::abs(value);
+}
+
+bool ImageAugmenter::changesGeometry() const {
+    return cropWidth > 0 || cropHeight > 0 || horizontalFlipProbability > 0.0 ||
+        verticalFlipProbability > 0.0 || maxRotationDegrees > 0.0f;
+}
+
+AugmentationParams ImageAugmenter::sample(std::mt19937& rng, int width, int height) const {
+    AugmentationParams params;
+
+    params.cropWidth = cropWidth > 0 ? std::min(cropWidth, width) : width;
+    params.cropHeight = cropHeight > 0 ? std::min(cropHeight, height) : height;
+    params.cropX = std::uniform_int_distribution<int>(0, width - params.cropWidth)(rng);
+    params.cropY = std::uniform_int_distribution<int>(0, height - params.cropHeight)(rng);
+
+    params.flipHorizontal = std::bernoulli_distribution(horizontalFlipProbability)(rng);
+    params.flipVertical = std::bernoulli_distribution(verticalFlipProbability)(rng);
+
+    if (maxRotationDegrees > 0.0f) {
+        params.rotationDegrees = std::uniform_real_distribution<float>(-maxRotationDegrees, maxRotationDegrees)(rng);
+    }
+    if (maxBlurSigma > 0.0f) {
+        params.blurSigma = std::uniform_real_distribution<float>(minBlurSigma, maxBlurSigma)(rng);
+    }
+    if (hueJitter > 0.0f) {
+        params.hueShiftDegrees = std::uniform_real_distribution<float>(-hueJitter, hueJitter)(rng);
+    }
+    if (saturationJitter > 0.0f) {
+        params.saturationScale = 1.0f + std::uniform_real_distribution<float>(-saturationJitter, saturationJitter)(rng);
+    }
+    if (valueJitter > 0.0f) {
+        params.valueScale = 1.0f + std::uniform_real_distribution<float>(-valueJitter, valueJitter)(rng);
+    }
+
+    return params;
+}
+
+Image ImageAugmenter::apply(const Image& input, const AugmentationParams& params, int numThreads) const {
+    Image output(params.cropWidth, params.cropHeight, input.channels, input.format);
+    apply(input, params, output, numThreads);
+    return output;
+}
+
+void ImageAugmenter::apply(const Image& input, const AugmentationParams& params, Image& output, int numThreads) const {
+    if (&input == &output) {
+        throw std::invalid_argument("Augmentation output must not alias its input");
+    }
+    if (params.cropX < 0 || params.cropY < 0 || params.cropWidth <= 0 || params.cropHeight <= 0 ||
+        params.cropX + params.cropWidth > input.width || params.cropY + params.cropHeight > input.height) {
+        throw std::invalid_argument("Crop rectangle must lie inside the image");
+    }
+
+    const int outWidth = params.cropWidth;
+    const int outHeight = params.cropHeight;
+    const int channels = input.channels;
+    const size_t rowSize = static_cast<size_t>(outWidth) * channels;
+    output.width = outWidth;
+    output.height = outHeight;
+    output.channels = channels;
+    output.format = input.format;
+    output.data.resize(rowSize * outHeight * bytesPerSample(input.format));
+
+    ColorMatrix color = buildColorMatrix(params);
+    std::vector<float> weights = gaussianKernel(params.blurSigma);
+    const int radius = static_cast<int>(weights.size()) / 2;
+    const int ringSize = 2 * radius + 1;
+
+    // Work in float rows whatever the sample type; only the final store is type-specific
+    auto run = [&](auto sampleTag) {
+        using T = decltype(sampleTag);
+        Parallel::forRange(0, outHeight, numThreads, [&](size_t bandBegin, size_t bandEnd) {
+            // Horizontally blurred rows wait in a ring until the vertical taps are complete,
+            // so each source row is warped, color-adjusted and blurred while it is hot in cache
+            std::vector<float> warped(rowSize);
+            std::vector<float> ring(rowSize * ringSize);
+            std::vector<float> accumulator(rowSize);
+            std::vector<const float*> taps(ringSize);
+
+            const int first = std::max(0, static_cast<int>(bandBegin) - radius);
+            const int last = std::min(outHeight - 1, static_cast<int>(bandEnd) - 1 + radius);
+            int nextOutput = static_cast<int>(bandBegin);
+
+            for (int row = first; row <= last; ++row) {
+                warpRow<T>(input, params, outWidth, outHeight, row, warped.data());
+                applyColor(color, outWidth, channels, warped.data());
+                blurRowHorizontal(weights, outWidth, channels, warped.data(), &ring[(row % ringSize) * rowSize]);
+
+                while (nextOutput < static_cast<int>(bandEnd) && std::min(nextOutput + radius, outHeight - 1) <= row) {
+                    for (int k = 0; k < ringSize; ++k) {
+                        int source = std::clamp(nextOutput + k - radius, 0, outHeight - 1);
+                        taps[k] = &ring[(source % ringSize) * rowSize];
+                    }
+
+                    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+                    for (int k = 0; k < ringSize; ++k) {
+                        float w = weights[k];
+                        const float* tap = taps[k];
+                        for (size_t i = 0; i < rowSize; ++i) {
+                            accumulator[i] += w * tap[i];
+                        }
+                    }
+
+                    T* out = reinterpret_cast<T*>(output.data.data()) + nextOutput * rowSize;
+                    for (size_t i = 0; i < rowSize; ++i) {
+                        out[i] = PixelTraits<T>::saturate(accumulator[i]);
+                    }
+                    ++nextOutput;
+                }
+            }
+        });
+    };
+
+    switch (input.format) {
+        case PixelFormat::UINT8:
+            run(static_cast<unsigned char>(0));
+            break;
+        case PixelFormat::UINT16:
+            run(static_cast<std::uint16_t>(0));
+            break;
+        case PixelFormat::FLOAT32:
+            run(0.0f);
+            break;
+    }
+}
+
+void ImageAugmenter::applyBatch(std::vector<Image>& images, std::mt19937& rng, int numThreads) const {
+    // Parameters are drawn up front so results don't depend on the thread count
+    std::vector<AugmentationParams> params;
+    params.reserve(images.size());
+    for (const auto& image : images) {
+        params.push_back(sample(rng, image.width, image.height));
+    }
+
+    Parallel::forRange(0, images.size(), numThreads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Image augmented = apply(images[i], params[i], 1);
+            images[i] = std::move(augmented);
+        }
+    });
+}
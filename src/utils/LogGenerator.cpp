@@ -0,0 +1,597 @@
+#include "LogGenerator.h"
+#include "AliasTable.h"
+#include "DateTime.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+namespace {
+    const std::string_view LEVEL_NAMES[] = { "DEBUG", "INFO", "WARN", "ERROR", "FATAL" };
+    const int LEVEL_COUNT = 5;
+    // Syslog severities of the levels, reported under facility local0
+    const int LEVEL_SEVERITY[] = { 7, 6, 4, 3, 2 };
+    const int FACILITY_LOCAL0 = 16;
+
+    const char* const MONTHS[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    // Access-log status codes by level: success, client error, server error
+    const int SUCCESS_STATUS[] = { 200, 200, 200, 200, 200, 200, 200, 201, 204, 304, 302, 200 };
+    const int CLIENT_ERROR_STATUS[] = { 400, 401, 403, 404, 404, 404, 409, 429 };
+    const int SERVER_ERROR_STATUS[] = { 500, 500, 502, 503, 504 };
+
+    struct PathShape {
+        std::string_view prefix;
+        std::string_view suffix;
+        bool number;  // a random number below PATH_NUMBERS goes between prefix and suffix
+    };
+    const std::uint32_t PATH_NUMBERS = 100000;
+    const PathShape PATHS[] = {
+        { "/", "", false },
+        { "/index.html", "", false },
+        { "/api/v1/users/", "", true },
+        { "/api/v1/orders/", "", true },
+        { "/api/v1/products?page=", "", true },
+        { "/api/v1/search?q=item", "", true },
+        { "/static/app.", ".js", true },
+        { "/health", "", false },
+        { "/login", "", false },
+        { "/metrics", "", false }
+    };
+
+    const std::string_view METHODS[] = { "GET", "POST", "PUT", "DELETE", "PATCH" };
+    const std::string_view REFERRERS[] = {
+        "-", "-", "https://www.example.com/", "https://www.google.com/search?q=shop", "https://news.example.org/article"
+    };
+    const std::string_view USER_AGENTS[] = {
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36",
+        "Mozilla/5.0 (Macintosh; Intel Mac OS X 14_5) AppleWebKit/605.1.15 (KHTML, like Gecko) Version/17.5 Safari/605.1.15",
+        "Mozilla/5.0 (X11; Linux x86_64; rv:127.0) Gecko/20100101 Firefox/127.0",
+        "Mozilla/5.0 (iPhone; CPU iPhone OS 17_5 like Mac OS X) AppleWebKit/605.1.15 (KHTML, like Gecko) Mobile/15E148",
+        "curl/8.5.0",
+        "python-requests/2.32.3"
+    };
+
+    const char* const PRESETS[] = {
+        // SYSLOG
+        "<$priority>1 $timestamp $host $service $pid - - $level $message request_id=$uuid client=$ip latency_ms=$latency",
+        // JSON
+        "{\"timestamp\":\"$timestamp\",\"level\":\"$level\",\"host\":\"$host\",\"service\":\"$service\","
+        "\"request_id\":\"$uuid\",\"client_ip\":\"$ip\",\"latency_ms\":$latency,\"message\":\"$message\"}",
+        // APACHE_COMBINED
+        "$ip - - [$clf_time] \"$method $path HTTP/1.1\" $status $bytes \"$referrer\" \"$user_agent\""
+    };
+
+    const std::vector<std::string> DEFAULT_MESSAGES = {
+        "user $USER $ACTION $RESOURCE",
+        "cache $CACHE_EVENT for $RESOURCE",
+        "$RESOURCE request failed: $ERROR",
+        "connection pool $POOL_EVENT in $REGION",
+        "job $JOB finished with status $JOB_STATUS",
+        "retrying $RESOURCE lookup after $ERROR"
+    };
+
+    std::unordered_map<std::string, TemplateSlot> defaultMessageSlots() {
+        return {
+            { "USER", { { "alice", "bob", "carol", "dave", "erin", "frank", "grace", "heidi", "ivan", "judy" }, {} } },
+            { "ACTION", { { "created", "updated", "deleted", "fetched", "listed" }, { 2.0, 2.0, 1.0, 6.0, 3.0 } } },
+            { "RESOURCE", { { "order", "invoice", "profile", "session", "cart", "product", "token" }, {} } },
+            { "CACHE_EVENT", { { "hit", "miss", "eviction", "refresh" }, { 8.0, 3.0, 1.0, 1.0 } } },
+            { "ERROR", { { "timeout", "connection reset", "permission denied", "invalid argument", "not found", "upstream unavailable" }, {} } },
+            { "POOL_EVENT", { { "exhausted", "resized", "connection opened", "connection closed" }, { 1.0, 1.0, 4.0, 4.0 } } },
+            { "REGION", { { "us-east-1", "eu-west-1", "ap-south-1" }, {} } },
+            { "JOB", { { "ingest", "reindex", "backup", "compaction", "email digest" }, {} } },
+            { "JOB_STATUS", { { "success", "failure" }, { 9.0, 1.0 } } }
+        };
+    }
+
+    template<typename T, size_t N>
+    inline const T& pick(const T(&items)[N], std::mt19937& rng) {
+        return items[(static_cast<std::uint64_t>(rng()) * N) >> 32];
+    }
+
+    inline std::uint32_t pickIndex(size_t count, std::mt19937& rng) {
+        return static_cast<std::uint32_t>((static_cast<std::uint64_t>(rng()) * count) >> 32);
+    }
+
+    template<size_t N>
+    size_t longest(const std::string_view(&items)[N]) {
+        size_t length = 0;
+        for (const auto& item : items) {
+            length = std::max(length, item.size());
+        }
+        return length;
+    }
+
+    inline char* put(char* p, std::string_view text) {
+        std::memcpy(p, text.data(), text.size());
+        return p + text.size();
+    }
+
+    inline char* putUnsigned(char* p, std::uint64_t value) {
+        char digits[20];
+        char* start = digits + sizeof(digits);
+        do {
+            *--start = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return put(p, std::string_view(start, digits + sizeof(digits) - start));
+    }
+
+    inline void put2(char* p, unsigned value) {
+        p[0] = static_cast<char>('0' + value / 10);
+        p[1] = static_cast<char>('0' + value % 10);
+    }
+
+    inline void put3(char* p, unsigned value) {
+        p[0] = static_cast<char>('0' + value / 100);
+        put2(p + 1, value % 100);
+    }
+
+    inline void putHex(char* p, std::uint32_t value, int digits) {
+        static const char HEX[] = "0123456789abcdef";
+        for (int i = digits - 1; i >= 0; --i) {
+            p[i] = HEX[value & 0xf];
+            value >>= 4;
+        }
+    }
+
+    // JSON string escaping; writes at most 6 bytes per input byte
+    char* putJsonEscaped(char* p, const char* text, size_t length) {
+        static const char HEX[] = "0123456789abcdef";
+        for (size_t i = 0; i < length; ++i) {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c == '"' || c == '\\') {
+                *p++ = '\\';
+                *p++ = static_cast<char>(c);
+            }
+            else if (c < 0x20) {
+                p = put(p, "\\u00");
+                *p++ = HEX[c >> 4];
+                *p++ = HEX[c & 0xf];
+            }
+            else {
+                *p++ = static_cast<char>(c);
+            }
+        }
+        return p;
+    }
+
+    std::string jsonEscaped(const std::string& text) {
+        std::string result(text.size() * 6, '\0');
+        result.resize(putJsonEscaped(&result[0], text.data(), text.size()) - result.data());
+        return result;
+    }
+
+    // Standard normal quantile (P. J. Acklam's rational approximation, |error| < 1.2e-9)
+    double normalQuantile(double p) {
+        static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+            1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+        static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+            6.680131188771972e+01, -1.328068155288572e+01 };
+        static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+            -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+        static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+            3.754408661907416e+00 };
+        const double low = 0.02425;
+        if (p < low || p > 1.0 - low) {
+            const double q = std::sqrt(-2.0 * std::log(p < low ? p : 1.0 - p));
+            const double x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+                / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+            return p < low ? x : -x;
+        }
+        const double q = p - 0.5;
+        const double r = q * q;
+        return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+            / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+
+    // Latency draws interpolate between 2^LATENCY_BITS + 1 quantiles, which clips the
+    // log-normal tails at about 3.7 sigma
+    const int LATENCY_BITS = 12;
+}
+
+// Per-block random stream and formatting caches; timestamps only change their
+// date-and-time prefix once per second, so it is formatted once and copied
+struct LogGenerator::RenderState {
+    RenderState(std::seed_seq& seed, size_t maxLineLength, size_t maxMessageLength)
+        : rng(seed), line(maxLineLength), message(maxMessageLength) {}
+
+    std::mt19937 rng;
+    std::vector<char> line;
+    std::vector<char> message;  // unescaped message of JSON lines
+    std::int64_t second = std::numeric_limits<std::int64_t>::min();
+    char iso[19];  // YYYY-MM-DDTHH:MM:SS
+    char clf[20];  // DD/Mon/YYYY:HH:MM:SS
+    std::int64_t timeUs = 0;
+    int level = 0;
+
+    void setSecond(std::int64_t value) {
+        if (value == second) {
+            return;
+        }
+        second = value;
+        const std::int64_t days = DateTime::floorDiv(value, DateTime::SECONDS_PER_DAY);
+        const unsigned secondOfDay = static_cast<unsigned>(value - days * DateTime::SECONDS_PER_DAY);
+        DateTime::writeDate(days, iso);
+        iso[10] = 'T';
+        DateTime::writeTime(secondOfDay, iso + 11);
+
+        std::int64_t year;
+        unsigned month, day;
+        DateTime::civilFromDays(days, year, month, day);
+        put2(clf, day);
+        clf[2] = '/';
+        clf[3] = MONTHS[month - 1][0];
+        clf[4] = MONTHS[month - 1][1];
+        clf[5] = MONTHS[month - 1][2];
+        clf[6] = '/';
+        std::copy(iso, iso + 4, clf + 7);
+        clf[11] = ':';
+        std::copy(iso + 11, iso + 19, clf + 12);
+    }
+};
+
+LogGenerator::LogGenerator(const LogConfig& config)
+    : escapeJson(config.format == LogFormat::JSON) {
+    if (!(config.linesPerSecond > 0.0)) {
+        throw std::invalid_argument("Log lines per second must be positive");
+    }
+    if (config.levelWeights.size() != LEVEL_COUNT) {
+        throw std::invalid_argument("Log level weights need one value per level (DEBUG, INFO, WARN, ERROR, FATAL)");
+    }
+    if (!(config.latencyMedianMs > 0.0) || config.latencySigma < 0.0) {
+        throw std::invalid_argument("Log latency median must be positive and its sigma non-negative");
+    }
+    if (config.numHosts < 1 || config.services.empty()) {
+        throw std::invalid_argument("Logs need at least one host and one service");
+    }
+
+    startTimeUs = config.startTimeMs * 1000;
+    intervalUs = 1e6 / config.linesPerSecond;
+    const double latencyMu = std::log(config.latencyMedianMs);
+    const int knots = (1 << LATENCY_BITS) + 1;
+    latencyQuantiles.resize(knots);
+    for (int k = 0; k < knots; ++k) {
+        const double p = (k + 0.5) / knots;
+        latencyQuantiles[k] = std::exp(latencyMu + config.latencySigma * normalQuantile(p));
+    }
+    levelProbability.resize(LEVEL_COUNT);
+    levelAlias.resize(LEVEL_COUNT);
+    AliasTable::build(config.levelWeights.data(), LEVEL_COUNT, levelProbability.data(), levelAlias.data());
+
+    for (int h = 1; h <= config.numHosts; ++h) {
+        hosts.push_back(std::string(h < 10 ? "host-0" : "host-") + std::to_string(h));
+    }
+    for (const auto& service : config.services) {
+        services.push_back(escapeJson ? jsonEscaped(service) : service);
+    }
+
+    std::unordered_map<std::string, TemplateSlot> slots = defaultMessageSlots();
+    for (const auto& slot : config.messageSlots) {
+        slots[slot.first] = slot.second;
+    }
+    messages = std::make_shared<const TemplateEngine>(
+        config.messageTemplates.empty() ? DEFAULT_MESSAGES : config.messageTemplates, slots);
+
+    // Compile the layout: literal runs into one pool, fields into ops
+    static const std::unordered_map<std::string, Field> FIELDS = {
+        { "timestamp", Field::TIMESTAMP }, { "epoch_ms", Field::EPOCH_MS }, { "clf_time", Field::CLF_TIME },
+        { "level", Field::LEVEL }, { "priority", Field::PRIORITY }, { "host", Field::HOST },
+        { "service", Field::SERVICE }, { "pid", Field::PID }, { "ip", Field::IP }, { "uuid", Field::UUID },
+        { "latency", Field::LATENCY }, { "method", Field::METHOD }, { "path", Field::PATH },
+        { "status", Field::STATUS }, { "bytes", Field::BYTES }, { "referrer", Field::REFERRER },
+        { "user_agent", Field::USER_AGENT }, { "message", Field::MESSAGE }
+    };
+    const std::string pattern = config.pattern.empty() ? PRESETS[static_cast<int>(config.format)] : config.pattern;
+    auto appendLiteral = [&](char c) {
+        if (plan.empty() || plan.back().field != Field::LITERAL) {
+            plan.push_back({ Field::LITERAL, static_cast<std::uint32_t>(literals.size()), 0 });
+        }
+        literals += c;
+        ++plan.back().length;
+    };
+    size_t i = 0;
+    while (i < pattern.size()) {
+        if (pattern[i] != '$' || i + 1 == pattern.size()) {
+            appendLiteral(pattern[i++]);
+            continue;
+        }
+        if (pattern[i + 1] == '$') {
+            appendLiteral('$');
+            i += 2;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < pattern.size() && ((pattern[end] >= 'a' && pattern[end] <= 'z') || pattern[end] == '_')) {
+            ++end;
+        }
+        if (end == i + 1) {
+            appendLiteral(pattern[i++]);
+            continue;
+        }
+        const std::string name = pattern.substr(i + 1, end - i - 1);
+        auto field = FIELDS.find(name);
+        if (field == FIELDS.end()) {
+            throw std::invalid_argument("Unknown log field: $" + name);
+        }
+        plan.push_back({ field->second, 0, 0 });
+        i = end;
+    }
+
+    // Worst case of every op, so a line never overruns the line buffer
+    size_t maxHost = 0, maxService = 0, maxPath = 0;
+    for (const auto& host : hosts) {
+        maxHost = std::max(maxHost, host.size());
+    }
+    for (const auto& service : services) {
+        maxService = std::max(maxService, service.size());
+    }
+    for (const auto& path : PATHS) {
+        maxPath = std::max(maxPath, path.prefix.size() + path.suffix.size() + 5);
+    }
+    maxLineLength = 0;
+    for (const Op& op : plan) {
+        switch (op.field) {
+        case Field::LITERAL: maxLineLength += op.length; break;
+        case Field::TIMESTAMP: maxLineLength += 24; break;
+        case Field::EPOCH_MS: maxLineLength += 20; break;
+        case Field::CLF_TIME: maxLineLength += 26; break;
+        case Field::LEVEL: maxLineLength += longest(LEVEL_NAMES); break;
+        case Field::PRIORITY: maxLineLength += 3; break;
+        case Field::HOST: maxLineLength += maxHost; break;
+        case Field::SERVICE: maxLineLength += maxService; break;
+        case Field::PID: maxLineLength += 5; break;
+        case Field::IP: maxLineLength += 15; break;
+        case Field::UUID: maxLineLength += 36; break;
+        case Field::LATENCY: maxLineLength += 24; break;
+        case Field::METHOD: maxLineLength += longest(METHODS); break;
+        case Field::PATH: maxLineLength += maxPath; break;
+        case Field::STATUS: maxLineLength += 3; break;
+        case Field::BYTES: maxLineLength += 5; break;
+        case Field::REFERRER: maxLineLength += longest(REFERRERS); break;
+        case Field::USER_AGENT: maxLineLength += longest(USER_AGENTS); break;
+        case Field::MESSAGE: maxLineLength += messages->maxLength() * (escapeJson ? 6 : 1); break;
+        }
+    }
+}
+
+char* LogGenerator::renderLine(std::uint64_t line, RenderState& state, char* out) const {
+    std::mt19937& rng = state.rng;
+
+    // Line i falls at a random point of its own interval, so time never runs backwards
+    const double offset = (static_cast<double>(line) + static_cast<double>(rng() >> 8) * (1.0 / 16777216.0)) * intervalUs;
+    state.timeUs = startTimeUs + static_cast<std::int64_t>(offset);
+    state.level = static_cast<int>(AliasTable::sample(levelProbability.data(), levelAlias.data(), LEVEL_COUNT, rng));
+    int status = 0;
+
+    for (const Op& op : plan) {
+        switch (op.field) {
+        case Field::LITERAL:
+            std::memcpy(out, literals.data() + op.offset, op.length);
+            out += op.length;
+            break;
+        case Field::TIMESTAMP: {
+            state.setSecond(DateTime::floorDiv(state.timeUs, 1000000));
+            std::memcpy(out, state.iso, sizeof(state.iso));
+            out[19] = '.';
+            put3(out + 20, static_cast<unsigned>(state.timeUs - state.second * 1000000) / 1000);
+            out[23] = 'Z';
+            out += 24;
+            break;
+        }
+        case Field::EPOCH_MS: {
+            const std::int64_t milliseconds = DateTime::floorDiv(state.timeUs, 1000);
+            if (milliseconds < 0) {
+                *out++ = '-';
+            }
+            out = putUnsigned(out, static_cast<std::uint64_t>(milliseconds < 0 ? -milliseconds : milliseconds));
+            break;
+        }
+        case Field::CLF_TIME:
+            state.setSecond(DateTime::floorDiv(state.timeUs, 1000000));
+            std::memcpy(out, state.clf, sizeof(state.clf));
+            out = put(out + sizeof(state.clf), " +0000");
+            break;
+        case Field::LEVEL:
+            out = put(out, LEVEL_NAMES[state.level]);
+            break;
+        case Field::PRIORITY:
+            out = putUnsigned(out, static_cast<std::uint64_t>(FACILITY_LOCAL0 * 8 + LEVEL_SEVERITY[state.level]));
+            break;
+        case Field::HOST:
+            out = put(out, hosts[pickIndex(hosts.size(), rng)]);
+            break;
+        case Field::SERVICE:
+            out = put(out, services[pickIndex(services.size(), rng)]);
+            break;
+        case Field::PID:
+            out = putUnsigned(out, 1000 + pickIndex(31000, rng));
+            break;
+        case Field::IP: {
+            const std::uint32_t bits = rng();
+            const unsigned octets[4] = { 1 + (((bits >> 24) * 223) >> 8), (bits >> 16) & 0xff, (bits >> 8) & 0xff, bits & 0xff };
+            for (int i = 0; i < 4; ++i) {
+                const unsigned octet = octets[i];
+                if (octet >= 100) {
+                    *out++ = static_cast<char>('0' + octet / 100);
+                }
+                if (octet >= 10) {
+                    *out++ = static_cast<char>('0' + octet / 10 % 10);
+                }
+                *out++ = static_cast<char>('0' + octet % 10);
+                *out++ = '.';
+            }
+            --out;
+            break;
+        }
+        case Field::UUID: {
+            // Version 4, RFC 4122 variant
+            const std::uint32_t a = rng();
+            const std::uint32_t b = (rng() & 0xffff0fffu) | 0x00004000u;
+            const std::uint32_t c = (rng() & 0x3fffffffu) | 0x80000000u;
+            const std::uint32_t d = rng();
+            putHex(out, a, 8);
+            out[8] = '-';
+            putHex(out + 9, b >> 16, 4);
+            out[13] = '-';
+            putHex(out + 14, b & 0xffff, 4);
+            out[18] = '-';
+            putHex(out + 19, c >> 16, 4);
+            out[23] = '-';
+            putHex(out + 24, c & 0xffff, 4);
+            putHex(out + 28, d, 8);
+            out += 36;
+            break;
+        }
+        case Field::LATENCY: {
+            const std::uint32_t bits = rng();
+            const std::uint32_t knot = bits >> (32 - LATENCY_BITS);
+            const double fraction = static_cast<double>(bits & ((1u << (32 - LATENCY_BITS)) - 1)) * (1.0 / (1u << (32 - LATENCY_BITS)));
+            const double milliseconds = latencyQuantiles[knot] + fraction * (latencyQuantiles[knot + 1] - latencyQuantiles[knot]);
+            const std::uint64_t microseconds = static_cast<std::uint64_t>(milliseconds * 1000.0 + 0.5);
+            out = putUnsigned(out, microseconds / 1000);
+            *out++ = '.';
+            put3(out, static_cast<unsigned>(microseconds % 1000));
+            out += 3;
+            break;
+        }
+        case Field::METHOD: {
+            const std::uint32_t r = pickIndex(100, rng);
+            out = put(out, METHODS[r < 70 ? 0 : r < 88 ? 1 : r < 94 ? 2 : r < 98 ? 3 : 4]);
+            break;
+        }
+        case Field::PATH: {
+            const PathShape& path = pick(PATHS, rng);
+            out = put(out, path.prefix);
+            if (path.number) {
+                out = putUnsigned(out, pickIndex(PATH_NUMBERS, rng));
+            }
+            out = put(out, path.suffix);
+            break;
+        }
+        case Field::STATUS:
+        case Field::BYTES:
+            // One status per line, matched to its level; bytes follow from it
+            if (status == 0) {
+                status = state.level <= 1 ? pick(SUCCESS_STATUS, rng)
+                    : state.level == 2 ? pick(CLIENT_ERROR_STATUS, rng) : pick(SERVER_ERROR_STATUS, rng);
+            }
+            if (op.field == Field::STATUS) {
+                out = putUnsigned(out, static_cast<std::uint64_t>(status));
+            }
+            else {
+                out = putUnsigned(out, status == 204 || status == 304 ? 0 : 128 + pickIndex(65408, rng));
+            }
+            break;
+        case Field::REFERRER:
+            out = put(out, pick(REFERRERS, rng));
+            break;
+        case Field::USER_AGENT:
+            out = put(out, pick(USER_AGENTS, rng));
+            break;
+        case Field::MESSAGE:
+            if (escapeJson) {
+                char* message = state.message.data();
+                const char* end = messages->render(messages->pickTemplate(rng), rng, message);
+                out = putJsonEscaped(out, message, end - message);
+            }
+            else {
+                out = messages->render(messages->pickTemplate(rng), rng, out);
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+void LogGenerator::renderBlock(std::uint64_t block, size_t count, unsigned int seed, std::string& out,
+    std::vector<size_t>* lineEnds) const {
+    if (count > BLOCK_LINES) {
+        throw std::invalid_argument("A log block holds at most BLOCK_LINES lines");
+    }
+    std::seed_seq seedSequence{ seed, static_cast<unsigned int>(block), static_cast<unsigned int>(block >> 32) };
+    RenderState state(seedSequence, maxLineLength + 1, messages->maxLength());
+    // Lines are written raw into the line buffer and appended whole
+    char* line = state.line.data();
+    const std::uint64_t first = block * BLOCK_LINES;
+    for (size_t i = 0; i < count; ++i) {
+        char* end = renderLine(first + i, state, line);
+        *end++ = '\n';
+        out.append(line, end - line);
+        if (lineEnds != nullptr) {
+            lineEnds->push_back(out.size());
+        }
+    }
+}
+
+std::uint64_t LogGenerator::write(StreamSink& sink, std::uint64_t lines, unsigned int seed, int numThreads,
+    const std::atomic<bool>* stop) const {
+    const int threads = Parallel::resolveThreadCount(numThreads);
+    const size_t batchBlocks = static_cast<size_t>(threads) * 4;
+    auto linesInBlock = [&](std::uint64_t block) -> size_t {
+        if (lines == 0) {
+            return BLOCK_LINES;
+        }
+        const std::uint64_t first = block * BLOCK_LINES;
+        return first >= lines ? 0 : static_cast<size_t>(std::min<std::uint64_t>(BLOCK_LINES, lines - first));
+    };
+    auto renderBatch = [&](std::vector<std::string>& buffers, std::uint64_t firstBlock) {
+        Parallel::forRange(0, buffers.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                buffers[b].clear();
+                const size_t count = linesInBlock(firstBlock + b);
+                if (count > 0) {
+                    renderBlock(firstBlock + b, count, seed, buffers[b]);
+                }
+            }
+        });
+    };
+
+    // Double buffering: one batch is written while the workers render the next
+    std::vector<std::string> current(batchBlocks), next(batchBlocks);
+    std::uint64_t firstBlock = 0;
+    renderBatch(current, firstBlock);
+    std::uint64_t written = 0;
+    bool readerOpen = true;
+    while (!current[0].empty() && !(stop != nullptr && stop->load())) {
+        std::exception_ptr writeError;
+        std::thread writer([&, firstBlock]() {
+            try {
+                for (size_t b = 0; b < batchBlocks && !current[b].empty(); ++b) {
+                    if (!sink.write(reinterpret_cast<const unsigned char*>(current[b].data()), current[b].size())) {
+                        readerOpen = false;
+                        return;
+                    }
+                    written += linesInBlock(firstBlock + b);
+                }
+            }
+            catch (...) {
+                writeError = std::current_exception();
+            }
+        });
+        try {
+            renderBatch(next, firstBlock + batchBlocks);
+        }
+        catch (...) {
+            writer.join();
+            throw;
+        }
+        writer.join();
+        if (writeError) {
+            std::rethrow_exception(writeError);
+        }
+        if (!readerOpen) {
+            break;
+        }
+        std::swap(current, next);
+        firstBlock += batchBlocks;
+    }
+    return written;
+}
@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename)
+    : bytes(nullptr), length(0) {
+#ifdef _WIN32
+    file = nullptr;
+    mapping = nullptr;
+    HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    file = handle;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize)) {
+        release();
+        throw std::runtime_error("Failed to read file size: " + filename);
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        return;
+    }
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        release();
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+    bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (bytes == nullptr) {
+        release();
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to read file size: " + filename);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+        bytes = static_cast<const char*>(address);
+    }
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {
+#ifdef _WIN32
+    file = std::exchange(other.file, nullptr);
+    mapping = std::exchange(other.mapping, nullptr);
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        bytes = std::exchange(other.bytes, nullptr);
+        length = std::exchange(other.length, 0);
+#ifdef _WIN32
+        file = std::exchange(other.file, nullptr);
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+#ifdef _WIN32
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    file = nullptr;
+    mapping = nullptr;
+#else
+    if (bytes != nullptr) {
+        munmap(const_cast<char*>(bytes), length);
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+}
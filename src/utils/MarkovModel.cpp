@@ -0,0 +1,553 @@
+#include "MarkovModel.h"
+#include "AliasTable.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+    inline std::uint64_t mix64(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    const char MODEL_MAGIC[8] = { 'S', 'D', 'G', 'M', 'A', 'R', 'K', 'V' };
+    const std::uint32_t MODEL_VERSION = 1;
+    const std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+    const int TABLE_COUNT = 12;
+
+    struct ModelHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint32_t order;
+        std::uint32_t reserved;
+        std::uint64_t sizes[TABLE_COUNT];  // element counts, in Tables member order
+    };
+
+    // Tables start on 8-byte boundaries so every view is aligned inside the mapping
+    inline std::uint64_t alignUp(std::uint64_t offset) {
+        return (offset + 7) & ~static_cast<std::uint64_t>(7);
+    }
+
+    // Count the width-token grams starting at positions [0, starts) of tokens. The result
+    // is sorted lexicographically: grams holds width tokens per entry, counts one value.
+    void countGrams(const std::uint32_t* tokens, size_t starts, size_t width,
+        std::vector<std::uint32_t>& grams, std::vector<std::uint64_t>& counts) {
+        std::vector<std::uint32_t> positions(starts);
+        for (size_t p = 0; p < starts; ++p) {
+            positions[p] = static_cast<std::uint32_t>(p);
+        }
+        std::sort(positions.begin(), positions.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return std::lexicographical_compare(tokens + a, tokens + a + width, tokens + b, tokens + b + width);
+        });
+        grams.clear();
+        counts.clear();
+        for (size_t i = 0; i < starts; ++i) {
+            const std::uint32_t* gram = tokens + positions[i];
+            if (!counts.empty() && std::equal(gram, gram + width, grams.end() - width)) {
+                ++counts.back();
+            } else {
+                grams.insert(grams.end(), gram, gram + width);
+                counts.push_back(1);
+            }
+        }
+    }
+
+    // Merge sorted count lists b into a, adding the counts of equal grams
+    void mergeCounts(std::vector<std::uint32_t>& gramsA, std::vector<std::uint64_t>& countsA,
+        const std::vector<std::uint32_t>& gramsB, const std::vector<std::uint64_t>& countsB, size_t width) {
+        std::vector<std::uint32_t> grams;
+        std::vector<std::uint64_t> counts;
+        grams.reserve(gramsA.size() + gramsB.size());
+        counts.reserve(countsA.size() + countsB.size());
+        size_t i = 0, j = 0;
+        while (i < countsA.size() || j < countsB.size()) {
+            const std::uint32_t* a = gramsA.data() + i * width;
+            const std::uint32_t* b = gramsB.data() + j * width;
+            if (j == countsB.size() || (i < countsA.size() && std::lexicographical_compare(a, a + width, b, b + width))) {
+                grams.insert(grams.end(), a, a + width);
+                counts.push_back(countsA[i++]);
+            } else if (i == countsA.size() || std::lexicographical_compare(b, b + width, a, a + width)) {
+                grams.insert(grams.end(), b, b + width);
+                counts.push_back(countsB[j++]);
+            } else {
+                grams.insert(grams.end(), a, a + width);
+                counts.push_back(countsA[i++] + countsB[j++]);
+            }
+        }
+        gramsA.swap(grams);
+        countsA.swap(counts);
+    }
+
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    // ASCII punctuation; bytes of multi-byte UTF-8 sequences count as word characters
+    inline bool isPunctuation(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return u < 0x80 && std::ispunct(u);
+    }
+
+    // One chunk of a corpus file: its own vocabulary and token IDs, later remapped
+    struct CorpusChunk {
+        std::unordered_map<std::string, std::uint32_t> vocabulary;
+        std::vector<std::string> words;
+        std::vector<double> wordCounts;
+        std::vector<std::uint32_t> tokens;
+        size_t ownTokens = 0;
+        std::vector<std::uint32_t> grams;
+        std::vector<std::uint64_t> counts;
+    };
+
+    void tokenizeChunk(const char* begin, const char* end, CorpusChunk& chunk) {
+        std::string word;
+        const char* p = begin;
+        while (p < end) {
+            while (p < end && isSpace(*p)) {
+                ++p;
+            }
+            const char* start = p;
+            while (p < end && !isSpace(*p)) {
+                ++p;
+            }
+            const char* stop = p;
+            while (start < stop && isPunctuation(*start)) {
+                ++start;
+            }
+            while (stop > start && isPunctuation(stop[-1])) {
+                --stop;
+            }
+            if (start == stop) {
+                continue;
+            }
+            word.assign(start, stop);
+            for (char& c : word) {
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c - 'A' + 'a');
+                }
+            }
+            auto found = chunk.vocabulary.find(word);
+            std::uint32_t id;
+            if (found == chunk.vocabulary.end()) {
+                id = static_cast<std::uint32_t>(chunk.words.size());
+                chunk.vocabulary.emplace(word, id);
+                chunk.words.push_back(word);
+                chunk.wordCounts.push_back(0.0);
+            } else {
+                id = found->second;
+            }
+            chunk.wordCounts[id] += 1.0;
+            chunk.tokens.push_back(id);
+        }
+    }
+}
+
+MarkovModel::MarkovModel(int order)
+    : order(order) {
+    if (order < 1) {
+        throw std::invalid_argument("Markov order must be at least 1");
+    }
+}
+
+MarkovModel::MarkovModel(const std::vector<std::string>& words, int order)
+    : MarkovModel(order) {
+    if (words.empty()) {
+        throw std::invalid_argument("Cannot build a Markov model from an empty word list");
+    }
+
+    // Integer-tokenize; IDs follow first appearance
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+    std::vector<std::string> vocabulary;
+    std::vector<double> unigramCounts;
+    std::vector<std::uint32_t> tokens;
+    tokens.reserve(words.size());
+    for (const std::string& w : words) {
+        auto found = ids.emplace(w, static_cast<std::uint32_t>(vocabulary.size()));
+        if (found.second) {
+            vocabulary.push_back(w);
+            unigramCounts.push_back(0.0);
+        }
+        tokens.push_back(found.first->second);
+        unigramCounts[found.first->second] += 1.0;
+    }
+
+    const size_t width = static_cast<size_t>(order) + 1;
+    std::vector<std::uint32_t> grams;
+    std::vector<std::uint64_t> counts;
+    countGrams(tokens.data(), tokens.size() >= width ? tokens.size() - order : 0, width, grams, counts);
+    build(vocabulary, unigramCounts, grams, counts);
+}
+
+MarkovModel MarkovModel::trainFromFiles(const std::vector<std::string>& filenames, int order, int numThreads) {
+    MarkovModel model(order);
+    const size_t width = static_cast<size_t>(order) + 1;
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<std::string> vocabulary;
+    std::vector<double> unigramCounts;
+    std::vector<std::uint32_t> grams;
+    std::vector<std::uint64_t> counts;
+
+    for (const std::string& filename : filenames) {
+        MappedFile file(filename);
+        const char* text = file.data();
+        const size_t size = file.size();
+
+        // Chunk boundaries move forward to the next whitespace so no token is split
+        const size_t threads = static_cast<size_t>(Parallel::resolveThreadCount(numThreads));
+        const size_t numChunks = std::max<size_t>(1, std::min(threads, size / (1 << 16)));
+        std::vector<size_t> bounds(numChunks + 1, size);
+        bounds[0] = 0;
+        for (size_t c = 1; c < numChunks; ++c) {
+            size_t at = std::max(bounds[c - 1], size / numChunks * c);
+            while (at < size && !isSpace(text[at])) {
+                ++at;
+            }
+            bounds[c] = at;
+        }
+
+        std::vector<CorpusChunk> chunks(numChunks);
+        Parallel::forRange(0, numChunks, numThreads, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                tokenizeChunk(text + bounds[c], text + bounds[c + 1], chunks[c]);
+            }
+        });
+
+        // Merge vocabularies; each chunk gets a local -> global ID table
+        std::vector<std::vector<std::uint32_t>> remaps(numChunks);
+        for (size_t c = 0; c < numChunks; ++c) {
+            CorpusChunk& chunk = chunks[c];
+            remaps[c].resize(chunk.words.size());
+            for (size_t w = 0; w < chunk.words.size(); ++w) {
+                auto found = ids.emplace(chunk.words[w], static_cast<std::uint32_t>(vocabulary.size()));
+                if (found.second) {
+                    vocabulary.push_back(chunk.words[w]);
+                    unigramCounts.push_back(0.0);
+                }
+                remaps[c][w] = found.first->second;
+                unigramCounts[found.first->second] += chunk.wordCounts[w];
+            }
+            chunk.vocabulary.clear();
+            chunk.words.clear();
+        }
+        Parallel::forRange(0, numChunks, numThreads, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                for (std::uint32_t& token : chunks[c].tokens) {
+                    token = remaps[c][token];
+                }
+                chunks[c].ownTokens = chunks[c].tokens.size();
+            }
+        });
+
+        // Grams starting near the end of a chunk read on into the following chunks
+        for (size_t c = 0; c < numChunks; ++c) {
+            for (size_t next = c + 1; next < numChunks && chunks[c].tokens.size() < chunks[c].ownTokens + order; ++next) {
+                const std::vector<std::uint32_t>& following = chunks[next].tokens;
+                const size_t take = std::min(following.size(), chunks[c].ownTokens + order - chunks[c].tokens.size());
+                chunks[c].tokens.insert(chunks[c].tokens.end(), following.begin(), following.begin() + take);
+            }
+        }
+        Parallel::forRange(0, numChunks, numThreads, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; ++c) {
+                CorpusChunk& chunk = chunks[c];
+                const size_t complete = chunk.tokens.size() >= width ? chunk.tokens.size() - order : 0;
+                countGrams(chunk.tokens.data(), std::min(chunk.ownTokens, complete), width, chunk.grams, chunk.counts);
+                std::vector<std::uint32_t>().swap(chunk.tokens);
+            }
+        });
+        for (CorpusChunk& chunk : chunks) {
+            mergeCounts(grams, counts, chunk.grams, chunk.counts, width);
+        }
+    }
+
+    if (vocabulary.empty()) {
+        throw std::invalid_argument("Training corpus contains no words");
+    }
+    model.build(vocabulary, unigramCounts, grams, counts);
+    return model;
+}
+
+void MarkovModel::build(const std::vector<std::string>& vocabulary, const std::vector<double>& unigramCounts,
+    const std::vector<std::uint32_t>& grams, const std::vector<std::uint64_t>& gramCounts) {
+    Tables& t = tables;
+    t.wordOffsets.push_back(0);
+    for (const std::string& w : vocabulary) {
+        t.wordChars.insert(t.wordChars.end(), w.begin(), w.end());
+        t.wordOffsets.push_back(t.wordChars.size());
+    }
+    t.unigramProbability.resize(unigramCounts.size());
+    t.unigramAlias.resize(unigramCounts.size());
+    AliasTable::build(unigramCounts.data(), unigramCounts.size(), t.unigramProbability.data(), t.unigramAlias.data());
+
+    // Sorted grams: runs with the same first n tokens form one state's row
+    const size_t width = static_cast<size_t>(order) + 1;
+    std::vector<double> weights(gramCounts.begin(), gramCounts.end());
+    std::vector<double> stateCounts;
+    t.rowOffsets.push_back(0);
+    for (size_t g = 0; g < gramCounts.size();) {
+        const std::uint32_t* context = grams.data() + g * width;
+        t.stateTokens.insert(t.stateTokens.end(), context, context + order);
+        double occurrences = 0.0;
+        while (g < gramCounts.size() && std::equal(context, context + order, grams.data() + g * width)) {
+            t.nextTokens.push_back(grams[g * width + order]);
+            occurrences += weights[g];
+            ++g;
+        }
+        t.rowOffsets.push_back(t.nextTokens.size());
+        stateCounts.push_back(occurrences);
+    }
+    const size_t states = t.rowOffsets.size() - 1;
+
+    // Per-row alias tables over the transition counts
+    t.nextProbability.resize(t.nextTokens.size());
+    t.nextAlias.resize(t.nextTokens.size());
+    for (size_t s = 0; s < states; ++s) {
+        const size_t begin = t.rowOffsets[s];
+        AliasTable::build(weights.data() + begin, t.rowOffsets[s + 1] - begin, t.nextProbability.data() + begin, t.nextAlias.data() + begin);
+    }
+    if (states > 0) {
+        t.startProbability.resize(states);
+        t.startAlias.resize(states);
+        AliasTable::build(stateCounts.data(), states, t.startProbability.data(), t.startAlias.data());
+    }
+
+    // Open addressing with linear probing at a load factor of at most 1/2
+    size_t slots = 2;
+    while (slots < 2 * states) {
+        slots *= 2;
+    }
+    t.stateSlots.assign(slots, 0);
+    for (size_t s = 0; s < states; ++s) {
+        size_t slot = hashContext(t.stateTokens.data() + s * order) & (slots - 1);
+        while (t.stateSlots[slot] != 0) {
+            slot = (slot + 1) & (slots - 1);
+        }
+        t.stateSlots[slot] = static_cast<std::uint32_t>(s + 1);
+    }
+    bind();
+}
+
+void MarkovModel::bind() {
+    auto view = [](auto& array, const auto& vector) {
+        array.data = vector.data();
+        array.size = vector.size();
+    };
+    view(wordOffsets, tables.wordOffsets);
+    view(wordChars, tables.wordChars);
+    view(stateTokens, tables.stateTokens);
+    view(stateSlots, tables.stateSlots);
+    view(rowOffsets, tables.rowOffsets);
+    view(nextTokens, tables.nextTokens);
+    view(nextProbability, tables.nextProbability);
+    view(nextAlias, tables.nextAlias);
+    view(startProbability, tables.startProbability);
+    view(startAlias, tables.startAlias);
+    view(unigramProbability, tables.unigramProbability);
+    view(unigramAlias, tables.unigramAlias);
+}
+
+void MarkovModel::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+    }
+
+    ModelHeader header = {};
+    std::memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    header.version = MODEL_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.order = static_cast<std::uint32_t>(order);
+    const std::uint64_t sizes[TABLE_COUNT] = { wordOffsets.size, wordChars.size, stateTokens.size, stateSlots.size,
+        rowOffsets.size, nextTokens.size, nextProbability.size, nextAlias.size, startProbability.size, startAlias.size,
+        unigramProbability.size, unigramAlias.size };
+    std::copy(sizes, sizes + TABLE_COUNT, header.sizes);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::uint64_t offset = sizeof(header);
+    auto write = [&](const auto& array) {
+        const std::uint64_t bytes = array.size * sizeof(*array.data);
+        file.write(reinterpret_cast<const char*>(array.data), static_cast<std::streamsize>(bytes));
+        const std::uint64_t padded = alignUp(offset + bytes);
+        for (std::uint64_t i = offset + bytes; i < padded; ++i) {
+            file.put(0);
+        }
+        offset = padded;
+    };
+    write(wordOffsets);
+    write(wordChars);
+    write(stateTokens);
+    write(stateSlots);
+    write(rowOffsets);
+    write(nextTokens);
+    write(nextProbability);
+    write(nextAlias);
+    write(startProbability);
+    write(startAlias);
+    write(unigramProbability);
+    write(unigramAlias);
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+MarkovModel MarkovModel::load(const std::string& filename) {
+    auto mapped = std::make_unique<MappedFile>(filename);
+    const char* base = mapped->data();
+    const std::uint64_t size = mapped->size();
+
+    ModelHeader header;
+    if (size < sizeof(header)) {
+        throw std::runtime_error("Not a Markov model file: " + filename);
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0 || header.version != MODEL_VERSION) {
+        throw std::runtime_error("Not a Markov model file: " + filename);
+    }
+    if (header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Markov model file was written with a different byte order: " + filename);
+    }
+
+    MarkovModel model(static_cast<int>(header.order));
+    std::uint64_t offset = sizeof(header);
+    int table = 0;
+    auto view = [&](auto& array) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(array.data)>>;
+        const std::uint64_t count = header.sizes[table++];
+        if (count > (size - offset) / sizeof(T)) {
+            throw std::runtime_error("Truncated Markov model file: " + filename);
+        }
+        array.data = reinterpret_cast<const T*>(base + offset);
+        array.size = static_cast<size_t>(count);
+        offset = std::min(size, alignUp(offset + count * sizeof(T)));
+    };
+    view(model.wordOffsets);
+    view(model.wordChars);
+    view(model.stateTokens);
+    view(model.stateSlots);
+    view(model.rowOffsets);
+    view(model.nextTokens);
+    view(model.nextProbability);
+    view(model.nextAlias);
+    view(model.startProbability);
+    view(model.startAlias);
+    view(model.unigramProbability);
+    view(model.unigramAlias);
+
+    // Cross-check the table sizes, then the contents in one pass over each table, so
+    // sampling can never index outside the mapping or probe a full hash table
+    const size_t vocabulary = model.wordOffsets.size > 0 ? model.wordOffsets.size - 1 : 0;
+    const size_t states = model.rowOffsets.size > 0 ? model.rowOffsets.size - 1 : 0;
+    const size_t slots = model.stateSlots.size;
+    if (vocabulary == 0 || model.rowOffsets.size == 0 || model.wordOffsets[vocabulary] != model.wordChars.size ||
+        model.stateTokens.size != states * model.order || slots < 2 || (slots & (slots - 1)) != 0 || slots <= states ||
+        model.rowOffsets[states] != model.nextTokens.size || model.nextProbability.size != model.nextTokens.size ||
+        model.nextAlias.size != model.nextTokens.size || model.startProbability.size != states ||
+        model.startAlias.size != states || model.unigramProbability.size != vocabulary || model.unigramAlias.size != vocabulary ||
+        vocabulary > std::numeric_limits<std::uint32_t>::max() || states >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Corrupt Markov model file: " + filename);
+    }
+    auto below = [](const auto& array, size_t limit) {
+        return std::all_of(array.data, array.data + array.size, [limit](std::uint32_t value) { return value < limit; });
+    };
+    bool valid = below(model.stateTokens, vocabulary) && below(model.nextTokens, vocabulary) &&
+        below(model.startAlias, states) && below(model.unigramAlias, vocabulary);
+    for (size_t i = 0; valid && i < vocabulary; ++i) {
+        valid = model.wordOffsets[i] <= model.wordOffsets[i + 1];
+    }
+    // Every state has at least one successor; alias entries stay inside their row
+    for (size_t s = 0; valid && s < states; ++s) {
+        const std::uint64_t begin = model.rowOffsets[s];
+        const std::uint64_t end = model.rowOffsets[s + 1];
+        valid = begin < end && end - begin <= std::numeric_limits<std::uint32_t>::max();
+        for (std::uint64_t i = begin; valid && i < end; ++i) {
+            valid = model.nextAlias[static_cast<size_t>(i)] < end - begin;
+        }
+    }
+    // Occupied slots name real states, and at least one slot is empty so probes end
+    size_t occupied = 0;
+    for (size_t i = 0; valid && i < slots; ++i) {
+        valid = model.stateSlots[i] <= states;
+        occupied += model.stateSlots[i] != 0 ? 1 : 0;
+    }
+    if (!valid || occupied >= slots) {
+        throw std::runtime_error("Corrupt Markov model file: " + filename);
+    }
+
+    model.mapping = std::move(mapped);
+    return model;
+}
+
+int MarkovModel::getOrder() const {
+    return order;
+}
+
+size_t MarkovModel::vocabularySize() const {
+    return wordOffsets.size - 1;
+}
+
+size_t MarkovModel::numStates() const {
+    return rowOffsets.size - 1;
+}
+
+std::string_view MarkovModel::word(std::uint32_t id) const {
+    return std::string_view(wordChars.data + wordOffsets[id], wordOffsets[id + 1] - wordOffsets[id]);
+}
+
+std::uint64_t MarkovModel::hashContext(const std::uint32_t* context) const {
+    std::uint64_t h = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < order; ++i) {
+        h = mix64(h ^ context[i]);
+    }
+    return h;
+}
+
+std::int64_t MarkovModel::findState(const std::uint32_t* context) const {
+    const size_t mask = stateSlots.size - 1;
+    size_t slot = hashContext(context) & mask;
+    while (stateSlots[slot] != 0) {
+        const size_t state = stateSlots[slot] - 1;
+        if (std::equal(context, context + order, stateTokens.data + state * order)) {
+            return static_cast<std::int64_t>(state);
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+void MarkovModel::sampleStart(std::mt19937& rng, std::uint32_t* context) const {
+    if (numStates() == 0) {
+        // Corpus shorter than one context: any words will do
+        for (int i = 0; i < order; ++i) {
+            context[i] = AliasTable::sample(unigramProbability.data, unigramAlias.data,
+                static_cast<std::uint32_t>(vocabularySize()), rng);
+        }
+        return;
+    }
+    const std::uint32_t state = AliasTable::sample(startProbability.data, startAlias.data,
+        static_cast<std::uint32_t>(numStates()), rng);
+    std::copy(stateTokens.data + static_cast<size_t>(state) * order,
+        stateTokens.data + static_cast<size_t>(state + 1) * order, context);
+}
+
+std::uint32_t MarkovModel::sampleNext(const std::uint32_t* context, std::mt19937& rng) const {
+    const std::int64_t state = findState(context);
+    if (state < 0) {
+        return AliasTable::sample(unigramProbability.data, unigramAlias.data,
+            static_cast<std::uint32_t>(vocabularySize()), rng);
+    }
+    const size_t begin = rowOffsets[state];
+    const std::uint32_t count = static_cast<std::uint32_t>(rowOffsets[state + 1] - begin);
+    return nextTokens[begin + AliasTable::sample(nextProbability.data + begin, nextAlias.data + begin, count, rng)];
+}
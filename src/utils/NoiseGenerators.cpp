@@ -0,0 +1,164 @@
+#include "NoiseGenerators.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    constexpr float TWO_PI = 6.28318530717958647692f;
+
+    // Shuffled 0..255, duplicated so perm[perm[x] + y] never needs wrapping
+    void buildPermutation(std::array<int, 512>& permutation, std::mt19937& rng) {
+        std::iota(permutation.begin(), permutation.begin() + 256, 0);
+        std::shuffle(permutation.begin(), permutation.begin() + 256, rng);
+        std::copy(permutation.begin(), permutation.begin() + 256, permutation.begin() + 256);
+    }
+
+    // Number of pixels, starting at x, that stay inside the lattice cell [xi, xi + 1)
+    int cellSpan(float x, int xi, float dx, int remaining) {
+        int span = static_cast<int>(std::ceil((static_cast<float>(xi + 1) - x) / dx));
+        return std::clamp(span, 1, remaining);
+    }
+
+    // Sum octaves into out and normalize by the total amplitude
+    template<typename Noise>
+    void accumulateFractal(const Noise& noise, float y, float x0, float dx, int count,
+        const FractalParameters& params, float* out) {
+        std::fill(out, out + count, 0.0f);
+
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float amplitudeSum = 0.0f;
+        int octaves = std::max(1, params.octaves);
+
+        for (int octave = 0; octave < octaves; ++octave) {
+            // Offset each octave so their lattices don't line up at the origin
+            float offset = 17.31f * octave;
+            noise.addRow(y * frequency + offset, x0 * frequency + offset, dx * frequency, count, amplitude, out);
+            amplitudeSum += amplitude;
+            frequency *= params.lacunarity;
+            amplitude *= params.gain;
+        }
+
+        float scale = 1.0f / amplitudeSum;
+        for (int i = 0; i < count; ++i) {
+            out[i] *= scale;
+        }
+    }
+}
+
+GradientNoise::GradientNoise(std::mt19937& rng) {
+    buildPermutation(permutation, rng);
+
+    std::uniform_real_distribution<float> angle(0.0f, TWO_PI);
+    for (int i = 0; i < 256; ++i) {
+        float a = angle(rng);
+        gradientX[i] = std::cos(a);
+        gradientY[i] = std::sin(a);
+    }
+}
+
+void GradientNoise::addRow(float y, float x0, float dx, int count, float amplitude, float* out) const {
+    // Everything that depends on y alone is hoisted out of the row
+    int yi = static_cast<int>(std::floor(y));
+    float yf = y - yi;
+    float v = yf * yf * yf * (yf * (yf * 6.0f - 15.0f) + 10.0f);
+    int yA = yi & 255;
+    int yB = (yi + 1) & 255;
+
+    // Unit gradients give |noise| <= sqrt(2)/2; rescale to [-1, 1]
+    float scaled = amplitude * 1.41421356f;
+
+    int i = 0;
+    while (i < count) {
+        float x = x0 + i * dx;
+        int xi = static_cast<int>(std::floor(x));
+        int end = i + cellSpan(x, xi, dx, count - i);
+
+        // The four corner gradients are constant across the cell, so the per-pixel
+        // work below is straight-line arithmetic the compiler can vectorize
+        int xA = xi & 255;
+        int xB = (xi + 1) & 255;
+        int h00 = permutation[permutation[xA] + yA];
+        int h10 = permutation[permutation[xB] + yA];
+        int h01 = permutation[permutation[xA] + yB];
+        int h11 = permutation[permutation[xB] + yB];
+
+        float gx00 = gradientX[h00], gx10 = gradientX[h10];
+        float gx01 = gradientX[h01], gx11 = gradientX[h11];
+        float c00 = gradientY[h00] * yf;
+        float c10 = gradientY[h10] * yf - gx10;
+        float c01 = gradientY[h01] * (yf - 1.0f);
+        float c11 = gradientY[h11] * (yf - 1.0f) - gx11;
+        float cellOrigin = x0 - xi;
+
+        for (int k = i; k < end; ++k) {
+            float xf = cellOrigin + k * dx;
+            float u = xf * xf * xf * (xf * (xf * 6.0f - 15.0f) + 10.0f);
+            float n0 = c00 + gx00 * xf;
+            float n1 = c01 + gx01 * xf;
+            n0 += u * ((c10 + gx10 * xf) - n0);
+            n1 += u * ((c11 + gx11 * xf) - n1);
+            out[k] += scaled * (n0 + v * (n1 - n0));
+        }
+
+        i = end;
+    }
+}
+
+void GradientNoise::fractalRow(float y, float x0, float dx, int count, const FractalParameters& params, float* out) const {
+    accumulateFractal(*this, y, x0, dx, count, params, out);
+}
+
+CellularNoise::CellularNoise(std::mt19937& rng) {
+    buildPermutation(permutation, rng);
+
+    std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+    for (int i = 0; i < 256; ++i) {
+        jitterX[i] = jitter(rng);
+        jitterY[i] = jitter(rng);
+    }
+}
+
+void CellularNoise::addRow(float y, float x0, float dx, int count, float amplitude, float* out) const {
+    int yi = static_cast<int>(std::floor(y));
+
+    int i = 0;
+    while (i < count) {
+        float x = x0 + i * dx;
+        int xi = static_cast<int>(std::floor(x));
+        int end = i + cellSpan(x, xi, dx, count - i);
+
+        // Feature points of the 3x3 neighbourhood are fixed for every pixel in this cell;
+        // the vertical distance is also constant along the row
+        float pointX[9];
+        float distanceY[9];
+        int n = 0;
+        for (int cy = yi - 1; cy <= yi + 1; ++cy) {
+            for (int cx = xi - 1; cx <= xi + 1; ++cx) {
+                int h = permutation[permutation[cx & 255] + (cy & 255)];
+                float py = cy + jitterY[h] - y;
+                pointX[n] = cx + jitterX[h] - x0;
+                distanceY[n] = py * py;
+                ++n;
+            }
+        }
+
+        for (int k = i; k < end; ++k) {
+            float px = k * dx;
+            float nearest = 4.0f;
+            for (int j = 0; j < 9; ++j) {
+                float ddx = pointX[j] - px;
+                nearest = std::min(nearest, ddx * ddx + distanceY[j]);
+            }
+            // F1 is in [0, ~1]; map it to [-1, 1] like the gradient noise
+            float f1 = std::min(std::sqrt(nearest), 1.0f);
+            out[k] += amplitude * (2.0f * f1 - 1.0f);
+        }
+
+        i = end;
+    }
+}
+
+void CellularNoise::fractalRow(float y, float x0, float dx, int count, const FractalParameters& params, float* out) const {
+    accumulateFractal(*this, y, x0, dx, count, params, out);
+}
@@ -0,0 +1,187 @@
+#include "Oscillators.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 256;
+    constexpr float TWO_PI = 6.28318530717958647692f;
+
+    // sin(2 * pi * t) for t in [0, 1): fold to a quarter wave, then an odd Taylor polynomial
+    // (error < 1e-7), with selects only so the calling loop vectorizes
+    inline float sineCycles(float t) {
+        float x = t > 0.5f ? t - 1.0f : t;
+        x = std::min(x, 0.5f - x);
+        x = std::max(x, -0.5f - x);
+        float y = TWO_PI * x;
+        float y2 = y * y;
+        float p = -1.0f / 39916800.0f;
+        p = p * y2 + 1.0f / 362880.0f;
+        p = p * y2 - 1.0f / 5040.0f;
+        p = p * y2 + 1.0f / 120.0f;
+        p = p * y2 - 1.0f / 6.0f;
+        return y + y * y2 * p;
+    }
+
+    // Residual of a unit step smoothed over one sample either side of t = 0 (mod 1)
+    inline float polyBlep(float t, float dt) {
+        float a = t / dt;
+        float b = (t - 1.0f) / dt;
+        float before = a + a - a * a - 1.0f;
+        float after = b * b + b + b + 1.0f;
+        return t < dt ? before : (t > 1.0f - dt ? after : 0.0f);
+    }
+
+    // Integral of polyBlep: residual of a change of slope of 2 per sample at t = 0 (mod 1)
+    inline float polyBlamp(float t, float dt) {
+        float a = t / dt - 1.0f;
+        float b = (t - 1.0f) / dt + 1.0f;
+        float before = -a * a * a / 3.0f;
+        float after = b * b * b / 3.0f;
+        return t < dt ? before : (t > 1.0f - dt ? after : 0.0f);
+    }
+
+    inline float wrapHalf(float t) {
+        return t + (t >= 0.5f ? -0.5f : 0.5f);
+    }
+}
+
+Oscillator::Oscillator(Waveform waveform, double frequency, double sampleRate, double phase)
+    : waveform(waveform), sampleRate(sampleRate), sweeping(false), sweepType(SweepType::LINEAR),
+    sweepLength(0), logRatio(0.0), position(0), phase(phase - std::floor(phase)),
+    offsetTable(BLOCK_SIZE + 1), ratioTable(BLOCK_SIZE + 1) {
+    if (sampleRate <= 0.0 || frequency <= 0.0) {
+        throw std::invalid_argument("Oscillator frequency and sample rate must be positive");
+    }
+    startIncrement = endIncrement = frequency / sampleRate;
+}
+
+void Oscillator::setSweep(double endFrequency, std::int64_t duration, SweepType type) {
+    if (endFrequency <= 0.0 || duration <= 0) {
+        throw std::invalid_argument("Sweep end frequency and duration must be positive");
+    }
+
+    // The sweep starts at the current frequency and position
+    startIncrement = incrementAt(position);
+    endIncrement = endFrequency / sampleRate;
+    sweeping = true;
+    sweepType = type;
+    sweepLength = duration;
+    position = 0;
+
+    // Discrete phase of a sweep is a sum of increments. Within a block starting with
+    // increment inc, sample k sits at inc * offsetTable[k] (+ a k(k-1)/2 term for linear
+    // sweeps) and runs at inc * ratioTable[k]; both tables depend only on the sweep shape.
+    logRatio = std::log(endIncrement / startIncrement) / static_cast<double>(duration);
+    for (size_t k = 0; k <= BLOCK_SIZE; ++k) {
+        if (type == SweepType::EXPONENTIAL && logRatio != 0.0) {
+            offsetTable[k] = std::expm1(k * logRatio) / std::expm1(logRatio);
+            ratioTable[k] = std::exp(k * logRatio);
+        } else {
+            offsetTable[k] = static_cast<double>(k);
+            ratioTable[k] = 1.0;
+        }
+    }
+}
+
+double Oscillator::incrementAt(std::int64_t n) const {
+    if (!sweeping || n >= sweepLength) {
+        return endIncrement;
+    }
+    if (sweepType == SweepType::LINEAR) {
+        return startIncrement + (endIncrement - startIncrement) * static_cast<double>(n) / sweepLength;
+    }
+    return startIncrement * std::exp(logRatio * static_cast<double>(n));
+}
+
+double Oscillator::getPhase() const {
+    return phase;
+}
+
+double Oscillator::getFrequency() const {
+    return incrementAt(position) * sampleRate;
+}
+
+void Oscillator::fillBlock(size_t count, float* phases, float* increments) {
+    // Increment at the block start comes from the closed form, never from accumulation
+    double increment = incrementAt(position);
+    double end = static_cast<double>(count);
+    double advance;
+
+    if (!sweeping || position >= sweepLength) {
+        for (int k = 0; k < static_cast<int>(count); ++k) {
+            // Offsets stay below a few hundred cycles, so an int truncation wraps them
+            double t = phase + increment * k;
+            t -= static_cast<double>(static_cast<int>(t));
+            phases[k] = static_cast<float>(t);
+            increments[k] = static_cast<float>(increment);
+        }
+        advance = increment * end;
+    } else {
+        double slope = sweepType == SweepType::LINEAR ? (endIncrement - startIncrement) / sweepLength : 0.0;
+        const double* offsets = offsetTable.data();
+        const double* ratios = ratioTable.data();
+        for (int k = 0; k < static_cast<int>(count); ++k) {
+            double kd = k;
+            double t = phase + increment * offsets[k] + slope * kd * (kd - 1.0) * 0.5;
+            t -= static_cast<double>(static_cast<int>(t));
+            phases[k] = static_cast<float>(t);
+            increments[k] = static_cast<float>(increment * ratios[k] + slope * kd);
+        }
+        advance = increment * offsets[count] + slope * end * (end - 1.0) * 0.5;
+    }
+
+    phase += advance;
+    phase -= std::floor(phase);
+    position += static_cast<std::int64_t>(count);
+}
+
+void Oscillator::render(float* out, size_t count, float amplitude) {
+    float phases[BLOCK_SIZE];
+    float increments[BLOCK_SIZE];
+
+    size_t done = 0;
+    while (done < count) {
+        size_t block = std::min(BLOCK_SIZE, count - done);
+        // Blocks never straddle the end of a sweep, so each uses a single phase law
+        if (sweeping && position < sweepLength) {
+            block = static_cast<size_t>(std::min<std::int64_t>(static_cast<std::int64_t>(block), sweepLength - position));
+        }
+        fillBlock(block, phases, increments);
+        float* dst = out + done;
+
+        switch (waveform) {
+            case Waveform::SINE:
+                for (int k = 0; k < static_cast<int>(block); ++k) {
+                    dst[k] = amplitude * sineCycles(phases[k]);
+                }
+                break;
+            case Waveform::SAWTOOTH:
+                for (int k = 0; k < static_cast<int>(block); ++k) {
+                    float t = phases[k];
+                    dst[k] = amplitude * (2.0f * t - 1.0f - polyBlep(t, increments[k]));
+                }
+                break;
+            case Waveform::SQUARE:
+                for (int k = 0; k < static_cast<int>(block); ++k) {
+                    float t = phases[k];
+                    float dt = increments[k];
+                    float naive = t < 0.5f ? 1.0f : -1.0f;
+                    dst[k] = amplitude * (naive + polyBlep(t, dt) - polyBlep(wrapHalf(t), dt));
+                }
+                break;
+            case Waveform::TRIANGLE:
+                for (int k = 0; k < static_cast<int>(block); ++k) {
+                    // Corners at t = 0 and t = 0.5 change the slope by -/+ 8 per cycle (8 * dt per sample)
+                    float t = phases[k];
+                    float dt = increments[k];
+                    float naive = 4.0f * std::abs(t - 0.5f) - 1.0f;
+                    float corners = polyBlamp(wrapHalf(t), dt) - polyBlamp(t, dt);
+                    dst[k] = amplitude * (naive + 4.0f * dt * corners);
+                }
+                break;
+        }
+
+        done += block;
+    }
+}
@@ -0,0 +1,136 @@
+#include "PCMEncoder.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 256;
+
+    // Cheap 32-bit integer hash (good avalanche), used as a counter-based noise source
+    inline std::uint32_t hash32(std::uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Full-scale factor and saturation limits; the PCM32 limit is the largest float below 2^31
+    void formatRange(SampleFormat format, float& scale, float& low, float& high) {
+        switch (format) {
+            case SampleFormat::PCM16:
+                scale = 32768.0f;
+                high = 32767.0f;
+                low = -scale;
+                return;
+            case SampleFormat::PCM24:
+                scale = 8388608.0f;
+                high = 8388607.0f;
+                low = -scale;
+                return;
+            case SampleFormat::PCM32:
+            case SampleFormat::FLOAT32:
+                scale = 2147483648.0f;
+                high = 2147483520.0f;
+                low = -scale;
+                return;
+        }
+        throw std::invalid_argument("Unknown sample format");
+    }
+}
+
+PCMEncoder::PCMEncoder(SampleFormat format, bool dither, std::uint32_t seed)
+    : format(format), dither(dither), seed(seed), position(0) {
+}
+
+int PCMEncoder::bitsPerSample(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::PCM16:
+            return 16;
+        case SampleFormat::PCM24:
+            return 24;
+        case SampleFormat::PCM32:
+        case SampleFormat::FLOAT32:
+            return 32;
+    }
+    throw std::invalid_argument("Unknown sample format");
+}
+
+int PCMEncoder::bytesPerSample() const {
+    return bitsPerSample(format) / 8;
+}
+
+void PCMEncoder::encode(const float* in, size_t count, unsigned char* out) {
+    if (format == SampleFormat::FLOAT32) {
+        // Bit patterns go out little-endian, like the integer formats
+        for (size_t i = 0; i < count; ++i) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &in[i], sizeof(bits));
+            out[4 * i] = static_cast<unsigned char>(bits);
+            out[4 * i + 1] = static_cast<unsigned char>(bits >> 8);
+            out[4 * i + 2] = static_cast<unsigned char>(bits >> 16);
+            out[4 * i + 3] = static_cast<unsigned char>(bits >> 24);
+        }
+        position += count;
+        return;
+    }
+
+    float scale, low, high;
+    formatRange(format, scale, low, high);
+    const int bytes = bytesPerSample();
+    std::int32_t values[BLOCK_SIZE];
+
+    for (size_t done = 0; done < count; done += BLOCK_SIZE) {
+        const int block = static_cast<int>(std::min(BLOCK_SIZE, count - done));
+        const float* src = in + done;
+
+        if (dither) {
+            // TPDF: the sum of two independent uniform [0, 1) LSB draws, minus one
+            std::uint32_t key = seed * 0x9e3779b9u ^ static_cast<std::uint32_t>(position >> 32) * 0x85ebca6bu;
+            std::uint32_t base = static_cast<std::uint32_t>(position);
+            for (int k = 0; k < block; ++k) {
+                std::uint32_t h = hash32(key + base + static_cast<std::uint32_t>(k));
+                float noise = static_cast<float>(static_cast<std::int32_t>(h & 0xffffu) + static_cast<std::int32_t>(h >> 16)) *
+                    (1.0f / 65536.0f) - 1.0f;
+                float v = src[k] * scale + noise;
+                v += v >= 0.0f ? 0.5f : -0.5f;
+                values[k] = static_cast<std::int32_t>(std::min(std::max(v, low), high));
+            }
+        } else {
+            for (int k = 0; k < block; ++k) {
+                float v = src[k] * scale;
+                v += v >= 0.0f ? 0.5f : -0.5f;
+                values[k] = static_cast<std::int32_t>(std::min(std::max(v, low), high));
+            }
+        }
+
+        // Pack little-endian regardless of the host byte order
+        unsigned char* dst = out + done * bytes;
+        switch (format) {
+            case SampleFormat::PCM16:
+                for (int k = 0; k < block; ++k) {
+                    dst[2 * k] = static_cast<unsigned char>(values[k]);
+                    dst[2 * k + 1] = static_cast<unsigned char>(values[k] >> 8);
+                }
+                break;
+            case SampleFormat::PCM24:
+                for (int k = 0; k < block; ++k) {
+                    dst[3 * k] = static_cast<unsigned char>(values[k]);
+                    dst[3 * k + 1] = static_cast<unsigned char>(values[k] >> 8);
+                    dst[3 * k + 2] = static_cast<unsigned char>(values[k] >> 16);
+                }
+                break;
+            default:
+                for (int k = 0; k < block; ++k) {
+                    dst[4 * k] = static_cast<unsigned char>(values[k]);
+                    dst[4 * k + 1] = static_cast<unsigned char>(values[k] >> 8);
+                    dst[4 * k + 2] = static_cast<unsigned char>(values[k] >> 16);
+                    dst[4 * k + 3] = static_cast<unsigned char>(values[k] >> 24);
+                }
+                break;
+        }
+
+        position += static_cast<std::uint64_t>(block);
+    }
+}
@@ -0,0 +1,10 @@
+#include "Parallel.h"
+
+int Parallel::resolveThreadCount(int requested) {
+    if (requested > 0) {
+        return requested;
+    }
+
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 0 ? static_cast<int>(hardwareThreads) : 1;
+}
@@ -21,37 +21,47 @@ int RandomGenerators::getRandomInt(int min, int max) {
 	if (!isInitialized) {
 		initialize();
 	}
+	return getRandomInt(generator, min, max);
+}
+
+int RandomGenerators::getRandomInt(std::mt19937& rng, int min, int max) {
 	if (min > max) {
 		throw std::invalid_argument("Min value must be less than or equal to max value");
 	}
 	std::uniform_int_distribution<int> distribution(min, max);
-	return distribution(generator);
+	return distribution(rng);
 }
 
-
 float RandomGenerators::getRandomFloat(float min, float max) {
 	if (!isInitialized) {
 		initialize();
 	}
+	return getRandomFloat(generator, min, max);
+}
+
+float RandomGenerators::getRandomFloat(std::mt19937& rng, float min, float max) {
 	if (min > max) {
 		throw std::invalid_argument("Min value must be less than or equal to max value");
 	}
 
 	std::uniform_real_distribution<float> distribution(min, max);
-	return distribution(generator);
+	return distribution(rng);
 }
 
 double RandomGenerators::getRandomDouble(double min, double max) {
     if (!isInitialized) {
         initialize();
     }
+    return getRandomDouble(generator, min, max);
+}
 
+double RandomGenerators::getRandomDouble(std::mt19937& rng, double min, double max) {
     if (min > max) {
         throw std::invalid_argument("Min value must be less than or equal to max value");
     }
 
     std::uniform_real_distribution<double> distribution(min, max);
-    return distribution(generator);
+    return distribution(rng);
 }
 
 bool RandomGenerators::getRandomBool(double trueProbability) {
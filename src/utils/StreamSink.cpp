@@ -0,0 +1,139 @@
+#include "StreamSink.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+#ifdef MSG_NOSIGNAL
+    const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    const int SEND_FLAGS = 0;
+#endif
+}
+#endif
+
+StreamSink::StreamSink(StreamTarget target, const std::string& path)
+    : target(target), fd(-1), ownsDescriptor(false) {
+#ifdef _WIN32
+    file = nullptr;
+    if (target == StreamTarget::REGULAR_FILE) {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to open file for writing: " + path);
+        }
+        ownsDescriptor = true;
+        return;
+    }
+    if (target != StreamTarget::STDOUT) {
+        throw std::runtime_error("FIFO and UNIX socket streaming are not supported on Windows");
+    }
+    _setmode(_fileno(stdout), _O_BINARY);
+    fd = _fileno(stdout);
+    file = stdout;
+#else
+    switch (target) {
+        case StreamTarget::STDOUT:
+            fd = STDOUT_FILENO;
+            break;
+        case StreamTarget::FIFO: {
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0) {
+                if (mkfifo(path.c_str(), 0666) != 0) {
+                    throw std::runtime_error("Failed to create FIFO: " + path + " (" + std::strerror(errno) + ")");
+                }
+            } else if (!S_ISFIFO(info.st_mode)) {
+                throw std::invalid_argument("Not a FIFO: " + path);
+            }
+            // Blocks until a reader opens the other end
+            fd = open(path.c_str(), O_WRONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to open FIFO: " + path + " (" + std::strerror(errno) + ")");
+            }
+            ownsDescriptor = true;
+            break;
+        }
+        case StreamTarget::UNIX_SOCKET: {
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+                throw std::invalid_argument("Invalid UNIX socket path: " + path);
+            }
+            std::memcpy(address.sun_path, path.c_str(), path.size());
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) {
+                throw std::runtime_error(std::string("Failed to create socket: ") + std::strerror(errno));
+            }
+            ownsDescriptor = true;
+#ifdef SO_NOSIGPIPE
+            // No MSG_NOSIGNAL on macOS; a closed peer must surface as EPIPE, not SIGPIPE
+            const int noSignal = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSignal, sizeof(noSignal));
+#endif
+            if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                std::string reason = std::strerror(errno);
+                close(fd);
+                throw std::runtime_error("Failed to connect to socket: " + path + " (" + reason + ")");
+            }
+            break;
+        }
+        case StreamTarget::REGULAR_FILE:
+            fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                throw std::runtime_error("Failed to open file for writing: " + path + " (" + std::strerror(errno) + ")");
+            }
+            ownsDescriptor = true;
+            break;
+    }
+#endif
+}
+
+StreamSink::~StreamSink() {
+#ifdef _WIN32
+    if (ownsDescriptor && file != nullptr) {
+        std::fclose(file);
+    }
+#else
+    if (ownsDescriptor && fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+bool StreamSink::write(const unsigned char* data, size_t size) {
+#ifdef _WIN32
+    if (std::fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    return std::fflush(file) == 0;
+#else
+    while (size > 0) {
+        // Sockets report a closed peer as EPIPE without raising SIGPIPE; pipes rely on
+        // the host process ignoring it
+        ssize_t written = target == StreamTarget::UNIX_SOCKET ? send(fd, data, size, SEND_FLAGS)
+            : ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EPIPE || errno == ECONNRESET) {
+                return false;
+            }
+            throw std::runtime_error(std::string("Stream write failed: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,225 @@
+#include "TemplateEngine.h"
+#include "AliasTable.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    inline bool isSlotChar(char c) {
+        return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+}
+
+TemplateEngine::TemplateEngine(const std::vector<std::string>& templates,
+    const std::unordered_map<std::string, TemplateSlot>& slots)
+    : longestRendering(0) {
+    if (templates.empty()) {
+        throw std::invalid_argument("Template engine needs at least one template");
+    }
+
+    // Slots are compiled on first reference, so unused vocabularies cost nothing
+    std::unordered_map<std::string, std::uint32_t> slotIndex;
+    std::unordered_map<std::string, std::uint32_t> tokenIndex;
+    auto tokenId = [&](const std::string& token) {
+        auto inserted = tokenIndex.emplace(token, static_cast<std::uint32_t>(vocabulary.size()));
+        if (inserted.second) {
+            vocabulary.push_back(token);
+        }
+        return inserted.first->second;
+    };
+    slotWords.push_back(0);
+    auto resolveSlot = [&](const std::string& name) {
+        auto found = slotIndex.find(name);
+        if (found != slotIndex.end()) {
+            return found->second;
+        }
+        auto slot = slots.find(name);
+        if (slot == slots.end()) {
+            throw std::invalid_argument("Unknown template slot: $" + name);
+        }
+        const TemplateSlot& definition = slot->second;
+        if (definition.words.empty()) {
+            throw std::invalid_argument("Template slot has no words: $" + name);
+        }
+        if (!definition.weights.empty() && definition.weights.size() != definition.words.size()) {
+            throw std::invalid_argument("Template slot weights do not match its words: $" + name);
+        }
+        const size_t first = wordOffsets.size();
+        const size_t count = definition.words.size();
+        for (const std::string& word : definition.words) {
+            wordOffsets.push_back(static_cast<std::uint32_t>(pool.size()));
+            wordLengths.push_back(static_cast<std::uint32_t>(word.size()));
+            wordTokens.push_back(tokenId(word));
+            pool += word;
+        }
+        std::vector<double> weights = definition.weights;
+        if (weights.empty()) {
+            weights.assign(count, 1.0);
+        }
+        wordProbability.resize(first + count);
+        wordAlias.resize(first + count);
+        AliasTable::build(weights.data(), count, wordProbability.data() + first, wordAlias.data() + first);
+        slotWords.push_back(static_cast<std::uint32_t>(wordOffsets.size()));
+
+        const std::uint32_t index = static_cast<std::uint32_t>(slotWords.size() - 2);
+        slotIndex.emplace(name, index);
+        return index;
+    };
+
+    templateTokens.push_back(0);
+    for (const std::string& text : templates) {
+        int words = 0;
+        bool inWord = false;
+        // Adjacent literal characters extend the previous literal token
+        auto appendLiteral = [&](char c) {
+            if (tokens.size() > templateTokens.back() && tokens.back().slot == LITERAL
+                && tokens.back().offset + tokens.back().length == pool.size()) {
+                ++tokens.back().length;
+            } else {
+                tokens.push_back({ LITERAL, static_cast<std::uint32_t>(pool.size()), 1, 0, 0 });
+            }
+            pool += c;
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                inWord = false;
+            } else if (!inWord) {
+                ++words;
+                inWord = true;
+            }
+        };
+
+        size_t i = 0;
+        while (i < text.size()) {
+            if (text[i] != '$' || i + 1 == text.size()) {
+                appendLiteral(text[i++]);
+                continue;
+            }
+            std::string name;
+            if (text[i + 1] == '$') {
+                appendLiteral('$');
+                i += 2;
+                continue;
+            } else if (text[i + 1] == '{') {
+                size_t close = text.find('}', i + 2);
+                if (close == std::string::npos || close == i + 2) {
+                    throw std::invalid_argument("Malformed template placeholder in: " + text);
+                }
+                name = text.substr(i + 2, close - i - 2);
+                i = close + 1;
+            } else if (isSlotChar(text[i + 1])) {
+                size_t end = i + 1;
+                while (end < text.size() && isSlotChar(text[end])) {
+                    ++end;
+                }
+                name = text.substr(i + 1, end - i - 1);
+                i = end;
+            } else {
+                appendLiteral(text[i++]);
+                continue;
+            }
+            tokens.push_back({ resolveSlot(name), 0, 0, 0, 0 });
+            if (!inWord) {
+                ++words;
+                inWord = true;
+            }
+        }
+        templateTokens.push_back(static_cast<std::uint32_t>(tokens.size()));
+        templateWords.push_back(words > 0 ? words : 1);
+    }
+
+    // Bound every rendering by its literals plus the longest word of each slot
+    for (size_t t = 0; t < numTemplates(); ++t) {
+        size_t length = 0;
+        for (std::uint32_t k = templateTokens[t]; k < templateTokens[t + 1]; ++k) {
+            if (tokens[k].slot == LITERAL) {
+                length += tokens[k].length;
+                continue;
+            }
+            std::uint32_t longest = 0;
+            for (std::uint32_t w = slotWords[tokens[k].slot]; w < slotWords[tokens[k].slot + 1]; ++w) {
+                longest = std::max(longest, wordLengths[w]);
+            }
+            length += longest;
+        }
+        longestRendering = std::max(longestRendering, length);
+    }
+
+    // Split the finished literals into word and punctuation tokens
+    for (Token& token : tokens) {
+        if (token.slot != LITERAL) {
+            continue;
+        }
+        token.firstToken = static_cast<std::uint32_t>(literalTokens.size());
+        const char* text = pool.data() + token.offset;
+        size_t i = 0;
+        while (i < token.length) {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (std::isspace(c)) {
+                ++i;
+                continue;
+            }
+            size_t end = i + 1;
+            if (std::isalnum(c) || c == '\'') {
+                while (end < token.length && (std::isalnum(static_cast<unsigned char>(text[end])) || text[end] == '\'')) {
+                    ++end;
+                }
+            }
+            literalTokens.push_back(tokenId(std::string(text + i, end - i)));
+            i = end;
+        }
+        token.tokenCount = static_cast<std::uint32_t>(literalTokens.size()) - token.firstToken;
+    }
+}
+
+std::unordered_map<std::string, TemplateSlot> TemplateEngine::defaultSlots() {
+    return {
+        { "NOUN", { { "time", "person", "year", "way", "day", "thing", "man", "world", "life", "hand", "part", "child", "eye", "woman", "place", "work", "week", "case", "point", "government" }, {} } },
+        { "VERB", { { "is", "are", "was", "were", "has", "have", "had", "can", "could", "will", "would", "should", "may", "might", "must", "shall", "do", "does", "did", "make", "makes", "made" }, {} } },
+        { "ADJECTIVE", { { "good", "new", "first", "last", "long", "great", "little", "own", "other", "old", "right", "big", "high", "different", "small", "large", "next", "early", "young", "important" }, {} } }
+    };
+}
+
+size_t TemplateEngine::pickTemplate(std::mt19937& rng) const {
+    return static_cast<size_t>((static_cast<std::uint64_t>(rng()) * numTemplates()) >> 32);
+}
+
+void TemplateEngine::render(size_t index, std::mt19937& rng, std::string& out,
+    std::vector<std::uint32_t>* tokenIds) const {
+    const char* text = pool.data();
+    for (std::uint32_t t = templateTokens[index]; t < templateTokens[index + 1]; ++t) {
+        const Token& token = tokens[t];
+        if (token.slot == LITERAL) {
+            out.append(text + token.offset, token.length);
+            if (tokenIds != nullptr) {
+                tokenIds->insert(tokenIds->end(), literalTokens.begin() + token.firstToken,
+                    literalTokens.begin() + token.firstToken + token.tokenCount);
+            }
+        } else {
+            const std::uint32_t first = slotWords[token.slot];
+            const std::uint32_t count = slotWords[token.slot + 1] - first;
+            const std::uint32_t word = first + AliasTable::sample(wordProbability.data() + first, wordAlias.data() + first, count, rng);
+            out.append(text + wordOffsets[word], wordLengths[word]);
+            if (tokenIds != nullptr) {
+                tokenIds->push_back(wordTokens[word]);
+            }
+        }
+    }
+}
+
+char* TemplateEngine::render(size_t index, std::mt19937& rng, char* out) const {
+    const char* text = pool.data();
+    for (std::uint32_t t = templateTokens[index]; t < templateTokens[index + 1]; ++t) {
+        const Token& token = tokens[t];
+        if (token.slot == LITERAL) {
+            std::memcpy(out, text + token.offset, token.length);
+            out += token.length;
+        } else {
+            const std::uint32_t first = slotWords[token.slot];
+            const std::uint32_t count = slotWords[token.slot + 1] - first;
+            const std::uint32_t word = first + AliasTable::sample(wordProbability.data() + first, wordAlias.data() + first, count, rng);
+            std::memcpy(out, text + wordOffsets[word], wordLengths[word]);
+            out += wordLengths[word];
+        }
+    }
+    return out;
+}
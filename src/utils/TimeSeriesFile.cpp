@@ -0,0 +1,499 @@
+#include "TimeSeriesFile.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+    const char FILE_MAGIC[8] = { 'S', 'D', 'G', 'T', 'S', 'B', 'I', 'N' };
+    const std::uint32_t FILE_VERSION = 1;
+    const std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+    struct FileHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint32_t dimensions;
+        std::uint32_t blockPoints;
+        std::uint64_t numPoints;
+        std::uint64_t numBlocks;
+        std::uint64_t indexOffset;
+    };
+
+    // Followed by one uint32 byte size per column
+    struct BlockHeader {
+        std::uint32_t count;
+        std::uint32_t dimensions;
+        std::int64_t firstTimestamp;
+    };
+
+    // Index entries are written and read as raw structs
+    static_assert(sizeof(TimeSeriesBlockInfo) == 40, "TimeSeriesBlockInfo must not be padded");
+
+    inline int leadingZeros(std::uint64_t x) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, x);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(x);
+#endif
+    }
+
+    inline int trailingZeros(std::uint64_t x) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(x);
+#endif
+    }
+
+    inline std::uint64_t byteSwap(std::uint64_t x) {
+#ifdef _MSC_VER
+        return _byteswap_uint64(x);
+#else
+        return __builtin_bswap64(x);
+#endif
+    }
+
+    inline std::uint64_t bitsOf(double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline double valueOf(std::uint64_t bits) {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // MSB-first bit packing
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<unsigned char>& out) : out(out), accumulator(0), pending(0) {}
+
+        // The low n bits of value, 1 <= n <= 64
+        void write(std::uint64_t value, int n) {
+            if (n > 32) {
+                write(value >> 32, n - 32);
+                value &= 0xffffffffu;
+                n = 32;
+            }
+            accumulator = (accumulator << n) | value;
+            pending += n;
+            while (pending >= 8) {
+                pending -= 8;
+                out.push_back(static_cast<unsigned char>(accumulator >> pending));
+            }
+        }
+
+        // Pad the last byte with zeros
+        void finish() {
+            if (pending > 0) {
+                out.push_back(static_cast<unsigned char>(accumulator << (8 - pending)));
+                pending = 0;
+            }
+        }
+
+    private:
+        std::vector<unsigned char>& out;
+        std::uint64_t accumulator;
+        int pending;
+    };
+
+    class BitReader {
+    public:
+        BitReader(const unsigned char* begin, const unsigned char* end)
+            : position(begin), end(end), buffer(0), available(0) {}
+
+        // The next n bits, 1 <= n <= 64
+        std::uint64_t read(int n) {
+            if (n > 56) {
+                const std::uint64_t high = read(n - 32);
+                return (high << 32) | read(32);
+            }
+            if (available < n) {
+                refill();
+                if (available < n) {
+                    throw std::runtime_error("Truncated time-series block");
+                }
+            }
+            const std::uint64_t value = buffer >> (64 - n);
+            buffer <<= n;
+            available -= n;
+            return value;
+        }
+
+        bool readBit() {
+            return read(1) != 0;
+        }
+
+    private:
+        void refill() {
+            if (end - position >= 8) {
+                // Bits past the whole bytes taken are the right ones, so or-ing them in
+                // again on the next refill changes nothing
+                std::uint64_t word;
+                std::memcpy(&word, position, sizeof(word));
+                buffer |= byteSwap(word) >> available;
+                const int taken = (63 - available) >> 3;
+                position += taken;
+                available += taken * 8;
+                return;
+            }
+            while (available <= 56 && position < end) {
+                buffer |= static_cast<std::uint64_t>(*position++) << (56 - available);
+                available += 8;
+            }
+        }
+
+        const unsigned char* position;
+        const unsigned char* end;
+        std::uint64_t buffer;  // unread bits, MSB first
+        int available;
+    };
+
+    // Delta-of-delta timestamps after the first, which the block header holds. The
+    // first delta is coded against 0. Differences wrap, so any int64 sequence is exact.
+    void encodeTimestamps(const std::int64_t* timestamps, size_t count, BitWriter& writer) {
+        std::uint64_t previousDelta = 0;
+        for (size_t i = 1; i < count; ++i) {
+            const std::uint64_t delta = static_cast<std::uint64_t>(timestamps[i]) - static_cast<std::uint64_t>(timestamps[i - 1]);
+            const std::int64_t dod = static_cast<std::int64_t>(delta - previousDelta);
+            previousDelta = delta;
+            if (dod == 0) {
+                writer.write(0, 1);
+            } else if (dod >= -63 && dod <= 64) {
+                writer.write(0x2, 2);
+                writer.write(static_cast<std::uint64_t>(dod + 63), 7);
+            } else if (dod >= -255 && dod <= 256) {
+                writer.write(0x6, 3);
+                writer.write(static_cast<std::uint64_t>(dod + 255), 9);
+            } else if (dod >= -2047 && dod <= 2048) {
+                writer.write(0xe, 4);
+                writer.write(static_cast<std::uint64_t>(dod + 2047), 12);
+            } else {
+                writer.write(0xf, 4);
+                writer.write(static_cast<std::uint64_t>(dod), 64);
+            }
+        }
+        writer.finish();
+    }
+
+    void decodeTimestamps(std::int64_t first, size_t count, BitReader& reader, std::time_t* out) {
+        std::uint64_t previous = static_cast<std::uint64_t>(first);
+        std::uint64_t previousDelta = 0;
+        out[0] = static_cast<std::time_t>(first);
+        for (size_t i = 1; i < count; ++i) {
+            std::uint64_t dod = 0;
+            if (reader.readBit()) {
+                if (!reader.readBit()) {
+                    dod = reader.read(7) - 63;
+                } else if (!reader.readBit()) {
+                    dod = reader.read(9) - 255;
+                } else if (!reader.readBit()) {
+                    dod = reader.read(12) - 2047;
+                } else {
+                    dod = reader.read(64);
+                }
+            }
+            previousDelta += dod;
+            previous += previousDelta;
+            out[i] = static_cast<std::time_t>(static_cast<std::int64_t>(previous));
+        }
+    }
+
+    // Gorilla XOR coding of one column: the first value raw, then per value '0' if it
+    // repeats, '10' + the meaningful bits if the XOR with its predecessor fits the last
+    // window, or '11' + 6-bit leading zero count + 6-bit length - 1 + the meaningful bits
+    void encodeValues(const double* values, size_t stride, size_t count, BitWriter& writer) {
+        std::uint64_t previous = bitsOf(values[0]);
+        writer.write(previous, 64);
+        int leading = 64;  // no window yet
+        int trailing = 64;
+        for (size_t i = 1; i < count; ++i) {
+            const std::uint64_t bits = bitsOf(values[i * stride]);
+            const std::uint64_t difference = bits ^ previous;
+            previous = bits;
+            if (difference == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+            const int newLeading = leadingZeros(difference);
+            const int newTrailing = trailingZeros(difference);
+            if (newLeading >= leading && newTrailing >= trailing) {
+                writer.write(0x2, 2);
+                writer.write(difference >> trailing, 64 - leading - trailing);
+            } else {
+                leading = newLeading;
+                trailing = newTrailing;
+                const int length = 64 - leading - trailing;
+                writer.write(0x3, 2);
+                writer.write(static_cast<std::uint64_t>(leading), 6);
+                writer.write(static_cast<std::uint64_t>(length - 1), 6);
+                writer.write(difference >> trailing, length);
+            }
+        }
+        writer.finish();
+    }
+
+    void decodeValues(size_t count, BitReader& reader, double* out, size_t stride) {
+        std::uint64_t previous = reader.read(64);
+        out[0] = valueOf(previous);
+        int leading = 64;
+        int trailing = 64;
+        for (size_t i = 1; i < count; ++i) {
+            if (reader.readBit()) {
+                if (reader.readBit()) {
+                    leading = static_cast<int>(reader.read(6));
+                    trailing = 64 - leading - static_cast<int>(reader.read(6)) - 1;
+                }
+                const int length = 64 - leading - trailing;
+                if (trailing < 0 || length <= 0) {
+                    throw std::runtime_error("Corrupt time-series block");
+                }
+                previous ^= reader.read(length) << trailing;
+            }
+            out[i * stride] = valueOf(previous);
+        }
+    }
+}
+
+TimeSeriesWriter::TimeSeriesWriter(const std::string& filename, int dimensions, size_t blockPoints)
+    : filename(filename), file(filename, std::ios::binary), dimensions(dimensions), blockPoints(blockPoints),
+    numPoints(0), offset(sizeof(FileHeader)), closed(false) {
+    if (dimensions < 1) {
+        throw std::invalid_argument("Time series needs at least one dimension");
+    }
+    if (blockPoints == 0 || blockPoints > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("Time series block size must be positive and fit 32 bits");
+    }
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + filename);
+    }
+    // Placeholder until close() knows the counts
+    const FileHeader header = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    timestamps.reserve(blockPoints);
+    values.reserve(blockPoints * dimensions);
+}
+
+TimeSeriesWriter::~TimeSeriesWriter() {
+    if (!closed) {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+}
+
+void TimeSeriesWriter::append(std::int64_t timestamp, const double* point) {
+    if (closed) {
+        throw std::runtime_error("Time-series file already closed: " + filename);
+    }
+    timestamps.push_back(timestamp);
+    values.insert(values.end(), point, point + dimensions);
+    ++numPoints;
+    if (timestamps.size() == blockPoints) {
+        flushBlock();
+    }
+}
+
+void TimeSeriesWriter::append(const TimeSeriesBlock& block) {
+    if (block.dimensions != dimensions) {
+        throw std::invalid_argument("Block has " + std::to_string(block.dimensions) + " dimensions, file has "
+            + std::to_string(dimensions));
+    }
+    for (size_t i = 0; i < block.size(); ++i) {
+        append(static_cast<std::int64_t>(block.timestamps[i]), block.point(i));
+    }
+}
+
+void TimeSeriesWriter::flushBlock() {
+    const size_t count = timestamps.size();
+    if (count == 0) {
+        return;
+    }
+    const size_t columnCount = static_cast<size_t>(dimensions) + 1;
+    const size_t headerBytes = sizeof(BlockHeader) + columnCount * sizeof(std::uint32_t);
+    encoded.assign(headerBytes, 0);
+
+    std::vector<std::uint32_t> columnBytes(columnCount);
+    BitWriter writer(encoded);
+    size_t start = encoded.size();
+    encodeTimestamps(timestamps.data(), count, writer);
+    columnBytes[0] = static_cast<std::uint32_t>(encoded.size() - start);
+    for (int d = 0; d < dimensions; ++d) {
+        start = encoded.size();
+        encodeValues(values.data() + d, dimensions, count, writer);
+        columnBytes[d + 1] = static_cast<std::uint32_t>(encoded.size() - start);
+    }
+    if (encoded.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Time-series block too large; use fewer points per block");
+    }
+
+    const BlockHeader header = { static_cast<std::uint32_t>(count), static_cast<std::uint32_t>(dimensions), timestamps[0] };
+    std::memcpy(encoded.data(), &header, sizeof(header));
+    std::memcpy(encoded.data() + sizeof(header), columnBytes.data(), columnCount * sizeof(std::uint32_t));
+    file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+
+    const TimeSeriesBlockInfo info = { offset, numPoints - count, timestamps[0], timestamps[count - 1],
+        static_cast<std::uint32_t>(count), static_cast<std::uint32_t>(encoded.size()) };
+    index.push_back(info);
+    offset += encoded.size();
+    timestamps.clear();
+    values.clear();
+}
+
+void TimeSeriesWriter::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+    flushBlock();
+    file.write(reinterpret_cast<const char*>(index.data()),
+        static_cast<std::streamsize>(index.size() * sizeof(TimeSeriesBlockInfo)));
+
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.dimensions = static_cast<std::uint32_t>(dimensions);
+    header.blockPoints = static_cast<std::uint32_t>(blockPoints);
+    header.numPoints = numPoints;
+    header.numBlocks = index.size();
+    header.indexOffset = offset;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + filename);
+    }
+}
+
+TimeSeriesReader::TimeSeriesReader(const std::string& filename)
+    : filename(filename), mapping(filename), numDimensions(0), totalPoints(0) {
+    FileHeader header;
+    if (mapping.size() < sizeof(header)) {
+        throw std::runtime_error("Not a time-series file: " + filename);
+    }
+    std::memcpy(&header, mapping.data(), sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        throw std::runtime_error("Not a time-series file: " + filename);
+    }
+    if (header.version != FILE_VERSION || header.byteOrder != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Unsupported time-series file version or byte order: " + filename);
+    }
+    const std::uint64_t indexBytes = header.numBlocks * sizeof(TimeSeriesBlockInfo);
+    if (header.dimensions == 0 || header.dimensions > static_cast<std::uint32_t>(std::numeric_limits<int>::max())
+        || header.indexOffset < sizeof(header) || header.indexOffset > mapping.size()
+        || header.numBlocks > (mapping.size() - header.indexOffset) / sizeof(TimeSeriesBlockInfo)
+        || header.indexOffset + indexBytes != mapping.size()) {
+        throw std::runtime_error("Corrupt time-series file header: " + filename);
+    }
+    numDimensions = static_cast<int>(header.dimensions);
+    totalPoints = header.numPoints;
+
+    index.resize(static_cast<size_t>(header.numBlocks));
+    if (!index.empty()) {
+        std::memcpy(index.data(), mapping.data() + header.indexOffset, static_cast<size_t>(indexBytes));
+    }
+    // Blocks must tile the data region and the points in order
+    std::uint64_t offset = sizeof(header);
+    std::uint64_t points = 0;
+    for (const TimeSeriesBlockInfo& info : index) {
+        if (info.offset != offset || info.firstIndex != points || info.count == 0
+            || info.bytes > header.indexOffset - offset) {
+            throw std::runtime_error("Corrupt time-series file index: " + filename);
+        }
+        offset += info.bytes;
+        points += info.count;
+    }
+    if (offset != header.indexOffset || points != totalPoints) {
+        throw std::runtime_error("Corrupt time-series file index: " + filename);
+    }
+}
+
+size_t TimeSeriesReader::findBlock(std::int64_t timestamp) const {
+    return static_cast<size_t>(std::partition_point(index.begin(), index.end(),
+        [timestamp](const TimeSeriesBlockInfo& info) { return info.lastTimestamp < timestamp; }) - index.begin());
+}
+
+size_t TimeSeriesReader::blockOfPoint(std::uint64_t pointIndex) const {
+    if (pointIndex >= totalPoints) {
+        return index.size();
+    }
+    return static_cast<size_t>(std::partition_point(index.begin(), index.end(),
+        [pointIndex](const TimeSeriesBlockInfo& info) { return info.firstIndex + info.count <= pointIndex; })
+        - index.begin());
+}
+
+void TimeSeriesReader::columns(size_t block, std::vector<const unsigned char*>& starts) const {
+    const TimeSeriesBlockInfo& info = index.at(block);
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(mapping.data()) + info.offset;
+    const size_t columnCount = static_cast<size_t>(numDimensions) + 1;
+    const size_t headerBytes = sizeof(BlockHeader) + columnCount * sizeof(std::uint32_t);
+    BlockHeader header;
+    if (info.bytes < headerBytes) {
+        throw std::runtime_error("Corrupt time-series block header: " + filename);
+    }
+    std::memcpy(&header, begin, sizeof(header));
+    if (header.count != info.count || header.dimensions != static_cast<std::uint32_t>(numDimensions)
+        || header.firstTimestamp != info.firstTimestamp) {
+        throw std::runtime_error("Corrupt time-series block header: " + filename);
+    }
+
+    starts.resize(columnCount + 1);
+    std::uint64_t position = headerBytes;
+    for (size_t c = 0; c < columnCount; ++c) {
+        std::uint32_t bytes;
+        std::memcpy(&bytes, begin + sizeof(header) + c * sizeof(bytes), sizeof(bytes));
+        starts[c] = begin + position;
+        position += bytes;
+    }
+    if (position != info.bytes) {
+        throw std::runtime_error("Corrupt time-series block header: " + filename);
+    }
+    starts[columnCount] = begin + position;
+}
+
+void TimeSeriesReader::readBlock(size_t block, TimeSeriesBlock& out) const {
+    std::vector<const unsigned char*> starts;
+    columns(block, starts);
+    const TimeSeriesBlockInfo& info = index[block];
+    out.firstIndex = info.firstIndex;
+    out.dimensions = numDimensions;
+    out.timestamps.resize(info.count);
+    out.values.resize(static_cast<size_t>(info.count) * numDimensions);
+
+    BitReader timeReader(starts[0], starts[1]);
+    decodeTimestamps(info.firstTimestamp, info.count, timeReader, out.timestamps.data());
+    if (out.timestamps.back() != info.lastTimestamp) {
+        throw std::runtime_error("Corrupt time-series block: " + filename);
+    }
+    for (int d = 0; d < numDimensions; ++d) {
+        BitReader reader(starts[d + 1], starts[d + 2]);
+        decodeValues(info.count, reader, out.values.data() + d, numDimensions);
+    }
+}
+
+void TimeSeriesReader::readColumn(size_t block, int dimension, std::vector<double>& out) const {
+    if (dimension < 0 || dimension >= numDimensions) {
+        throw std::invalid_argument("Dimension out of range: " + std::to_string(dimension));
+    }
+    std::vector<const unsigned char*> starts;
+    columns(block, starts);
+    out.resize(index[block].count);
+    BitReader reader(starts[dimension + 1], starts[dimension + 2]);
+    decodeValues(out.size(), reader, out.data(), 1);
+}
@@ -0,0 +1,110 @@
+#include "ZipfVocabulary.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    const char CONSONANTS[] = "bcdfghjklmnprstvwxyz";
+    const char VOWELS[] = "aeiou";
+    const std::uint64_t SYLLABLES = 100;
+    // Odd and not a multiple of 5, so multiplying permutes each power of 100; small
+    // enough that index * SCRAMBLE cannot overflow for ranks up to MAX_SIZE
+    const std::uint64_t SCRAMBLE = 1640531527ull;
+
+    // log1p(x) / x and expm1(x) / x, with their limits near 0
+    inline double log1pOverX(double x) {
+        if (std::fabs(x) > 1e-8) {
+            return std::log1p(x) / x;
+        }
+        return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    inline double expm1OverX(double x) {
+        if (std::fabs(x) > 1e-8) {
+            return std::expm1(x) / x;
+        }
+        return 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+
+    // Uniform double in [0, 1) with 53 random bits
+    inline double uniform53(std::mt19937& rng) {
+        const std::uint64_t high = rng() >> 5;
+        const std::uint64_t low = rng() >> 6;
+        return static_cast<double>((high << 26) | low) * (1.0 / 9007199254740992.0);
+    }
+}
+
+ZipfVocabulary::ZipfVocabulary(std::uint64_t size, double exponent)
+    : numWords(size), exponent(exponent) {
+    if (size == 0 || size > MAX_SIZE) {
+        throw std::invalid_argument("Zipf vocabulary size must be between 1 and 2^32 - 1");
+    }
+    if (!(exponent > 0.0)) {
+        throw std::invalid_argument("Zipf exponent must be positive");
+    }
+    hIntegralX1 = hIntegral(1.5) - 1.0;
+    hIntegralN = hIntegral(static_cast<double>(size) + 0.5);
+    squeeze = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+}
+
+double ZipfVocabulary::hIntegral(double x) const {
+    const double logX = std::log(x);
+    return expm1OverX((1.0 - exponent) * logX) * logX;
+}
+
+double ZipfVocabulary::hIntegralInverse(double x) const {
+    double t = x * (1.0 - exponent);
+    if (t < -1.0) {
+        t = -1.0;  // rounding guard; the exact value never goes below -1
+    }
+    return std::exp(log1pOverX(t) * x);
+}
+
+double ZipfVocabulary::h(double x) const {
+    return std::exp(-exponent * std::log(x));
+}
+
+std::uint64_t ZipfVocabulary::sampleRank(std::mt19937& rng) const {
+    // Invert the integral of the continuous hat, round to the nearest rank and accept
+    // unless the point falls between the hat and the discrete mass; the squeeze accepts
+    // most draws without evaluating h
+    while (true) {
+        const double u = hIntegralN + uniform53(rng) * (hIntegralX1 - hIntegralN);
+        const double x = hIntegralInverse(u);
+        double k = std::floor(x + 0.5);
+        if (k < 1.0) {
+            k = 1.0;
+        }
+        else if (k > static_cast<double>(numWords)) {
+            k = static_cast<double>(numWords);
+        }
+        if (k - x <= squeeze || u >= hIntegral(k + 0.5) - h(k)) {
+            return static_cast<std::uint64_t>(k);
+        }
+    }
+}
+
+void ZipfVocabulary::appendWord(std::uint64_t rank, std::string& out) const {
+    // Bijective base 100: 100 one-syllable words, then 100^2 two-syllable words, ...
+    std::uint64_t index = rank - 1;
+    std::uint64_t classSize = SYLLABLES;
+    int length = 1;
+    while (index >= classSize) {
+        index -= classSize;
+        classSize *= SYLLABLES;
+        ++length;
+    }
+    // Scatter neighbouring ranks so frequent words do not share a prefix
+    index = index * SCRAMBLE % classSize;
+    for (int i = 0; i < length; ++i) {
+        const std::uint64_t syllable = index % SYLLABLES;
+        index /= SYLLABLES;
+        out += CONSONANTS[syllable / 5];
+        out += VOWELS[syllable % 5];
+    }
+}
+
+std::string ZipfVocabulary::word(std::uint64_t rank) const {
+    std::string result;
+    appendWord(rank, result);
+    return result;
+}
@@ -1,7 +1,24 @@
 #include "AudioData.h"
+#include "RandomGenerators.h"
 #include <iostream>
 #include <cassert>
 #include <filesystem>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "RingBuffer.h"
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -51,7 +68,625 @@ void testAudioDataGeneration() {
     std::cout << "AudioData tests passed!" << std::endl;
 }
 
+void testOscillators() {
+    std::cout << "Testing oscillators..." << std::endl;
+
+    // Sine matches the exact phase, including after a long run
+    const double sampleRate = 48000.0;
+    const double frequency = 441.3;
+    Oscillator sine(Waveform::SINE, frequency, sampleRate);
+    std::vector<float> block(4096);
+    size_t position = 0;
+    for (int i = 0; i < 2000; i++) {
+        sine.render(block.data(), block.size(), 0.5f);
+        position += block.size();
+    }
+    for (size_t k = 0; k < block.size(); k++) {
+        double n = static_cast<double>(position - block.size() + k);
+        double exact = 0.5 * std::sin(2.0 * 3.14159265358979323846 * std::fmod(frequency * n / sampleRate, 1.0));
+        assert(std::abs(block[k] - exact) < 1e-5);
+    }
+
+    // Band-limited shapes stay in range and keep their mean near zero
+    for (Waveform waveform : { Waveform::SQUARE, Waveform::SAWTOOTH, Waveform::TRIANGLE }) {
+        Oscillator oscillator(waveform, 1000.0, sampleRate);
+        std::vector<float> data(48000);
+        oscillator.render(data.data(), data.size());
+        double sum = 0.0;
+        for (float value : data) {
+            assert(std::abs(value) < 1.1f);
+            sum += value;
+        }
+        assert(std::abs(sum / data.size()) < 0.01);
+    }
+
+    // Sweeps reach their end frequency and then hold it
+    for (SweepType type : { SweepType::LINEAR, SweepType::EXPONENTIAL }) {
+        Oscillator chirp(Waveform::SINE, 100.0, sampleRate);
+        chirp.setSweep(4000.0, 10000, type);
+        std::vector<float> data(5000);
+        chirp.render(data.data(), data.size());
+        double midFrequency = type == SweepType::LINEAR ? 2050.0 : std::sqrt(100.0 * 4000.0);
+        assert(std::abs(chirp.getFrequency() - midFrequency) < 1.0);
+        chirp.render(data.data(), data.size());
+        chirp.render(data.data(), data.size());
+        assert(std::abs(chirp.getFrequency() - 4000.0) < 1e-6);
+    }
+
+    AudioData tones(1, 8000, 1);
+    tones.setAudioType(AudioType::TRIANGLE_WAVE);
+    tones.generate();
+    assert(tones.getAudioSamples()[0].data.size() == 8000);
+
+    AudioData chirps(1, 8000, 1);
+    chirps.setAudioType(AudioType::CHIRP);
+    chirps.setSweepType(SweepType::EXPONENTIAL);
+    chirps.generate();
+    assert(chirps.getAudioSamples()[0].data.size() == 8000);
+
+    std::cout << "Oscillator tests passed!" << std::endl;
+}
+
+int readPCM(const unsigned char* bytes, int width) {
+    // Sign-extend a little-endian sample of 2, 3 or 4 bytes
+    std::uint32_t value = 0;
+    for (int i = 0; i < width; i++) {
+        value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+    }
+    int shift = 32 - 8 * width;
+    return static_cast<std::int32_t>(value << shift) >> shift;
+}
+
+void testPCMEncoding() {
+    std::cout << "Testing PCM encoding..." << std::endl;
+
+    // Full scale rounds and saturates instead of wrapping
+    std::vector<float> input = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 1.5f, -1.5f, 0.25f / 32768.0f };
+    std::vector<unsigned char> bytes(input.size() * 4);
+    const int expected16[] = { 0, 16384, -16384, 32767, -32768, 32767, -32768, 0 };
+    const int expected24[] = { 0, 4194304, -4194304, 8388607, -8388608, 8388607, -8388608, 64 };
+
+    PCMEncoder pcm16(SampleFormat::PCM16);
+    pcm16.encode(input.data(), input.size(), bytes.data());
+    for (size_t i = 0; i < input.size(); i++) {
+        assert(readPCM(&bytes[i * 2], 2) == expected16[i]);
+    }
+
+    PCMEncoder pcm24(SampleFormat::PCM24);
+    pcm24.encode(input.data(), input.size(), bytes.data());
+    for (size_t i = 0; i < input.size(); i++) {
+        assert(readPCM(&bytes[i * 3], 3) == expected24[i]);
+    }
+
+    PCMEncoder pcm32(SampleFormat::PCM32);
+    pcm32.encode(input.data(), input.size(), bytes.data());
+    assert(readPCM(&bytes[5 * 4], 4) > 2147483000);
+    assert(readPCM(&bytes[6 * 4], 4) == -2147483647 - 1);
+
+    // TPDF dither stays within +/-1 LSB, is unbiased, and ignores block boundaries
+    std::vector<float> quiet(100000, 0.25f / 32768.0f);
+    std::vector<unsigned char> whole(quiet.size() * 2), split(quiet.size() * 2);
+    PCMEncoder ditherWhole(SampleFormat::PCM16, true, 7);
+    ditherWhole.encode(quiet.data(), quiet.size(), whole.data());
+    PCMEncoder ditherSplit(SampleFormat::PCM16, true, 7);
+    ditherSplit.encode(quiet.data(), 1001, split.data());
+    ditherSplit.encode(quiet.data() + 1001, quiet.size() - 1001, split.data() + 1001 * 2);
+    assert(whole == split);
+    double sum = 0.0;
+    for (size_t i = 0; i < quiet.size(); i++) {
+        int value = readPCM(&whole[i * 2], 2);
+        assert(value >= -1 && value <= 1);
+        sum += value;
+    }
+    assert(std::abs(sum / quiet.size() - 0.25) < 0.02);
+
+    // 24-bit WAV export (extensible format): header fields and data size
+    AudioData audio(1, 8000, 1);
+    audio.setSampleFormat(SampleFormat::PCM24);
+    audio.setDither(true);
+    audio.generate();
+    std::string outputDir = "test_audio_pcm";
+    audio.exportToDirectory(outputDir);
+    std::string filename = outputDir + "/audio_1.wav";
+    assert(fs::file_size(filename) == 68 + 8000 * 3);
+    std::ifstream file(filename, std::ios::binary);
+    std::vector<unsigned char> header(68);
+    file.read(reinterpret_cast<char*>(header.data()), header.size());
+    assert(readPCM(&header[34], 2) == 24);
+    assert(readPCM(&header[64], 4) == 8000 * 3);
+    file.close();
+    fs::remove_all(outputDir);
+
+    std::cout << "PCM encoding tests passed!" << std::endl;
+}
+
+std::vector<unsigned char> readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+std::uint64_t readLE(const std::vector<unsigned char>& bytes, size_t offset, int width) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < width; i++) {
+        value |= static_cast<std::uint64_t>(bytes[offset + i]) << (8 * i);
+    }
+    return value;
+}
+
+void testWAVContainers() {
+    std::cout << "Testing WAV containers..." << std::endl;
+    std::string outputDir = "test_audio_wav";
+
+    // Float32 stereo: IEEE float tag, 18-byte fmt, fact chunk, raw samples
+    AudioData floatAudio(1, 1000, 1);
+    floatAudio.setNumChannels(2);
+    floatAudio.setSampleFormat(SampleFormat::FLOAT32);
+    floatAudio.generate();
+    floatAudio.exportToDirectory(outputDir);
+    std::vector<unsigned char> wav = readFile(outputDir + "/audio_1.wav");
+    assert(std::string(wav.begin(), wav.begin() + 4) == "RIFF");
+    assert(readLE(wav, 4, 4) == wav.size() - 8);
+    assert(readLE(wav, 16, 4) == 18 && readLE(wav, 20, 2) == 3);
+    assert(std::string(wav.begin() + 38, wav.begin() + 42) == "fact");
+    assert(readLE(wav, 46, 4) == 1000);
+    assert(std::string(wav.begin() + 50, wav.begin() + 54) == "data");
+    assert(readLE(wav, 54, 4) == 1000 * 2 * 4);
+    float first;
+    std::uint32_t bits = static_cast<std::uint32_t>(readLE(wav, 58, 4));
+    std::memcpy(&first, &bits, sizeof(first));
+    assert(first == floatAudio.getAudioSamples()[0].data[0]);
+
+    // Forced RF64 with 8 channels of 24-bit: ds64 sizes, extensible fmt, -1 placeholders
+    AudioData soak(1, 1001, 1);
+    soak.setNumChannels(8);
+    soak.setSampleFormat(SampleFormat::PCM24);
+    soak.setWAVContainer(WAVContainer::RF64);
+    soak.generate();
+    soak.exportToDirectory(outputDir);
+    wav = readFile(outputDir + "/audio_1.wav");
+    std::uint64_t dataSize = 1001 * 8 * 3;
+    assert(std::string(wav.begin(), wav.begin() + 4) == "RF64");
+    assert(readLE(wav, 4, 4) == 0xFFFFFFFFull);
+    assert(std::string(wav.begin() + 12, wav.begin() + 16) == "ds64");
+    assert(readLE(wav, 20, 8) == wav.size() - 8);
+    assert(readLE(wav, 28, 8) == dataSize);
+    assert(readLE(wav, 36, 8) == 1001);
+    assert(std::string(wav.begin() + 48, wav.begin() + 52) == "fmt ");
+    assert(readLE(wav, 52, 4) == 40 && readLE(wav, 56, 2) == 0xFFFE);
+    assert(readLE(wav, 58, 2) == 8 && readLE(wav, 70, 2) == 24);
+    assert(readLE(wav, 80, 2) == 1);  // PCM sub-format
+    assert(std::string(wav.begin() + 96, wav.begin() + 100) == "data");
+    assert(readLE(wav, 100, 4) == 0xFFFFFFFFull);
+    assert(wav.size() == 104 + dataSize);
+
+    // Odd-length data chunks get a pad byte
+    AudioData mono(1, 1001, 1);
+    mono.setSampleFormat(SampleFormat::PCM24);
+    mono.generate();
+    mono.exportToDirectory(outputDir);
+    wav = readFile(outputDir + "/audio_1.wav");
+    assert(std::string(wav.begin(), wav.begin() + 4) == "RIFF");
+    assert(readLE(wav, 20, 2) == 0xFFFE);
+    assert(wav.size() % 2 == 0 && readLE(wav, 4, 4) == wav.size() - 8);
+
+    fs::remove_all(outputDir);
+    std::cout << "WAV container tests passed!" << std::endl;
+}
+
+void testMultichannel() {
+    std::cout << "Testing multichannel synthesis..." << std::endl;
+
+    // Fully correlated channels are identical; delays shift the shared signal
+    AudioData delayed(1, 8000, 1);
+    delayed.setAudioType(AudioType::WHITE_NOISE);
+    delayed.setNumChannels(3);
+    delayed.setChannelDelays({ 0.0, 0.001, 0.0025 });
+    delayed.generate();
+    AudioSample sample = delayed.getAudioSamples()[0];
+    assert(sample.numFrames() == 8000);
+    for (size_t n = 20; n < 8000; n++) {
+        assert(sample.channel(1)[n] == sample.channel(0)[n - 8]);
+        assert(sample.channel(2)[n] == sample.channel(0)[n - 20]);
+    }
+
+    // Independent channels, reproducible for a seed regardless of the thread count
+    std::vector<AudioSample> runs[2];
+    for (int threads : { 1, 4 }) {
+        AudioData independent(2, 8000, 1);
+        independent.setAudioType(AudioType::PINK_NOISE);
+        independent.setNumChannels(4);
+        independent.setChannelCorrelation(0.0);
+        independent.setNumThreads(threads);
+        RandomGenerators::initialize(42);
+        independent.generate();
+        runs[threads == 1 ? 0 : 1] = independent.getAudioSamples();
+    }
+    assert(runs[0][1].data == runs[1][1].data);
+    const AudioSample& noise = runs[0][0];
+    for (int c = 1; c < 4; c++) {
+        assert(!std::equal(noise.channel(0), noise.channel(0) + 8000, noise.channel(c)));
+    }
+
+    // Partial correlation lands near the requested coefficient for equal-power noise
+    AudioData partial(1, 48000, 2);
+    partial.setAudioType(AudioType::WHITE_NOISE);
+    partial.setNumChannels(2);
+    partial.setChannelCorrelation(0.6);
+    partial.generate();
+    AudioSample stereo = partial.getAudioSamples()[0];
+    double xy = 0.0, xx = 0.0, yy = 0.0;
+    for (size_t n = 0; n < stereo.numFrames(); n++) {
+        xy += stereo.channel(0)[n] * stereo.channel(1)[n];
+        xx += stereo.channel(0)[n] * stereo.channel(0)[n];
+        yy += stereo.channel(1)[n] * stereo.channel(1)[n];
+    }
+    double correlation = xy / std::sqrt(xx * yy);
+    assert(correlation > 0.3 && correlation < 0.9);
+
+    // WAV export interleaves the planar channels
+    std::string outputDir = "test_audio_planar";
+    partial.setSampleFormat(SampleFormat::FLOAT32);
+    partial.exportToDirectory(outputDir);
+    std::vector<unsigned char> wav = readFile(outputDir + "/audio_1.wav");
+    for (size_t n = 0; n < 100; n++) {
+        for (int c = 0; c < 2; c++) {
+            std::uint32_t bits = static_cast<std::uint32_t>(readLE(wav, 58 + (n * 2 + c) * 4, 4));
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            assert(value == stereo.channel(c)[n]);
+        }
+    }
+    fs::remove_all(outputDir);
+
+    std::cout << "Multichannel synthesis tests passed!" << std::endl;
+}
+
+void testColoredNoise() {
+    std::cout << "Testing colored noise..." << std::endl;
+
+    // Every color is normalized to an RMS of about 1/3. The power of the first difference
+    // relative to the signal measures the spectral tilt, which must rise from brown to violet.
+    const size_t count = 200000;
+    std::vector<float> data(count);
+    double previousTilt = 0.0;
+    for (NoiseColor color : { NoiseColor::BROWN, NoiseColor::PINK, NoiseColor::WHITE, NoiseColor::BLUE, NoiseColor::VIOLET }) {
+        ColoredNoise noise(color, 48000.0, 99);
+        noise.render(data.data(), count);
+        double power = 0.0, differencePower = 0.0;
+        for (size_t i = 1; i < count; i++) {
+            power += data[i] * data[i];
+            differencePower += (data[i] - data[i - 1]) * (data[i] - data[i - 1]);
+        }
+        double rms = std::sqrt(power / (count - 1));
+        assert(rms > 0.28 && rms < 0.39);
+        double tilt = differencePower / power;
+        assert(tilt > previousTilt);
+        previousTilt = tilt;
+    }
+
+    // Output does not depend on how the stream is split into calls
+    ColoredNoise whole(NoiseColor::BLUE, 44100.0, 5);
+    ColoredNoise split(NoiseColor::BLUE, 44100.0, 5);
+    std::vector<float> a(5000), b(5000);
+    whole.render(a.data(), a.size());
+    split.render(b.data(), 1234);
+    split.render(b.data() + 1234, b.size() - 1234);
+    assert(a == b);
+
+    AudioData brown(1, 8000, 1);
+    brown.setAudioType(AudioType::BROWN_NOISE);
+    brown.generate();
+    assert(brown.getAudioSamples()[0].data.size() == 8000);
+
+    std::cout << "Colored noise tests passed!" << std::endl;
+}
+
+void testMixerAndResampler() {
+    std::cout << "Testing mixer and resampler..." << std::endl;
+
+    // A constant source makes the gain curve directly visible
+    const double rate = 1000.0;
+    AudioMixer mixer(rate);
+    MixerTrack track;
+    track.source = [](float* out, size_t count) { std::fill(out, out + count, 1.0f); };
+    track.gain = 0.5f;
+    track.start = 100;
+    track.length = 1000;
+    track.envelope.attack = 0.1f;
+    track.envelope.decay = 0.1f;
+    track.envelope.sustain = 0.5f;
+    track.envelope.release = 0.2f;
+    mixer.addTrack(track);
+    MixerTrack faded;
+    faded.source = track.source;
+    faded.start = 1200;
+    faded.fadeIn = 0.1f;
+    mixer.addTrack(faded);
+    std::vector<float> mix(1500);
+    mixer.render(mix.data(), 700);
+    mixer.render(mix.data() + 700, 800);
+    assert(mix[99] == 0.0f && mix[1100] == 0.0f);
+    assert(std::fabs(mix[150] - 0.25f) < 1e-3f);   // half way up the attack
+    assert(std::fabs(mix[250] - 0.375f) < 1e-3f);  // half way down the decay
+    assert(std::fabs(mix[500] - 0.25f) < 1e-3f);   // sustain
+    assert(std::fabs(mix[1000] - 0.125f) < 1e-3f); // half way through the release
+    assert(mix[1099] < 0.01f);
+    assert(std::fabs(mix[1249] - 0.5f) < 1e-2f && mix[1400] == 1.0f);
+
+    // Resampled tones keep their amplitude and phase at every delivery rate
+    const double pi = 3.14159265358979323846;
+    const int masterRate = 48000;
+    const size_t frames = 48000;
+    std::vector<float> tone(frames);
+    for (size_t n = 0; n < frames; n++) {
+        tone[n] = static_cast<float>(0.8 * std::sin(2.0 * pi * 1000.0 * n / masterRate));
+    }
+    for (int target : { 8000, 16000, 22050, 44100, 96000 }) {
+        Resampler resampler(masterRate, target);
+        std::vector<float> out;
+        resampler.process(tone.data(), 1000, out);
+        resampler.process(tone.data() + 1000, frames - 1000, out);
+        resampler.finish(out);
+        assert(out.size() == static_cast<size_t>(target));
+        double maxError = 0.0;
+        for (size_t n = out.size() / 10; n < out.size() * 9 / 10; n++) {
+            double expected = 0.8 * std::sin(2.0 * pi * 1000.0 * n / target);
+            maxError = std::max(maxError, std::fabs(out[n] - expected));
+        }
+        assert(maxError < 2e-3);
+    }
+
+    // Content above the target Nyquist is filtered out instead of aliasing
+    for (size_t n = 0; n < frames; n++) {
+        tone[n] = static_cast<float>(0.8 * std::sin(2.0 * pi * 6000.0 * n / masterRate));
+    }
+    Resampler down(masterRate, 8000);
+    std::vector<float> aliased;
+    down.process(tone.data(), frames, aliased);
+    down.finish(aliased);
+    double power = 0.0;
+    for (size_t n = 1000; n < 7000; n++) {
+        power += aliased[n] * aliased[n];
+    }
+    assert(std::sqrt(power / 6000) < 1e-3);
+
+    // One master, exported at several rates in one pass
+    AudioData audio(1, 44100, 1);
+    audio.setAudioType(AudioType::COMBINED);
+    audio.setNumChannels(2);
+    audio.setOutputRates({ 8000, 44100, 96000 });
+    audio.generate();
+    std::vector<AudioSample> delivered = AudioData::resample(audio.getAudioSamples()[0], { 8000, 44100, 96000 });
+    assert(delivered[0].numFrames() == 8000 && delivered[2].numFrames() == 96000);
+    assert(delivered[1].data == audio.getAudioSamples()[0].data);
+
+    std::string outputDir = "test_audio_rates";
+    audio.exportToDirectory(outputDir);
+    for (int target : { 8000, 44100, 96000 }) {
+        std::vector<unsigned char> wav = readFile(outputDir + "/audio_1_" + std::to_string(target) + ".wav");
+        assert(readLE(wav, 24, 4) == static_cast<std::uint64_t>(target));
+        assert(readLE(wav, 40, 4) == static_cast<std::uint64_t>(target) * 4);
+    }
+    fs::remove_all(outputDir);
+
+    std::cout << "Mixer and resampler tests passed!" << std::endl;
+}
+
+void testAudioFeatures() {
+    std::cout << "Testing audio features..." << std::endl;
+    const double pi = 3.14159265358979323846;
+
+    // The packed real FFT matches a direct DFT
+    const size_t n = 64;
+    FFT fft(n);
+    std::vector<float> input(n), re(n / 2 + 1), im(n / 2 + 1);
+    for (size_t i = 0; i < n; i++) {
+        input[i] = static_cast<float>(std::sin(0.37 * i) + 0.25 * std::cos(1.9 * i * i));
+    }
+    fft.forwardReal(input.data(), re.data(), im.data());
+    for (size_t k = 0; k <= n / 2; k++) {
+        double sumRe = 0.0, sumIm = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sumRe += input[i] * std::cos(2.0 * pi * k * i / n);
+            sumIm -= input[i] * std::sin(2.0 * pi * k * i / n);
+        }
+        assert(std::fabs(re[k] - sumRe) < 1e-4 && std::fabs(im[k] - sumIm) < 1e-4);
+    }
+
+    // A 1 kHz tone peaks in the matching STFT bin and mel band, regardless of threads
+    const int rate = 16000;
+    std::vector<float> tone(rate);
+    for (size_t i = 0; i < tone.size(); i++) {
+        tone[i] = static_cast<float>(0.5 * std::sin(2.0 * pi * 1000.0 * i / rate));
+    }
+    FeatureConfig config;
+    config.frameSize = 512;
+    config.hopSize = 160;
+    config.numMelBands = 40;
+    AudioFeatures extractor(rate, config);
+    const std::vector<AudioFeature> all = { AudioFeature::SPECTROGRAM, AudioFeature::MEL_SPECTROGRAM, AudioFeature::MFCC };
+    std::vector<std::vector<float>> single, threaded;
+    extractor.compute(tone.data(), tone.size(), all, single, 1);
+    extractor.compute(tone.data(), tone.size(), all, threaded, 4);
+    assert(single == threaded);
+    const size_t frames = extractor.numFrames(tone.size());
+    assert(frames == 1 + (16000 - 512) / 160);
+    assert(single[0].size() == frames * 257 && single[1].size() == frames * 40 && single[2].size() == frames * 13);
+    const float* row = single[0].data() + 10 * 257;
+    assert(std::max_element(row, row + 257) - row == 32);  // 1000 Hz * 512 / 16000
+    assert(std::fabs(row[32] - 0.5f * 512 / 4) < 1.0f);     // Hann coherent gain 1/2, one-sided amplitude 1/2
+    const float* melRow = single[1].data() + 10 * 40;
+    int peakBand = static_cast<int>(std::max_element(melRow, melRow + 40) - melRow);
+    assert(peakBand > 5 && peakBand < 20);
+
+    // Feature files are .npy arrays shaped (channels, frames, values)
+    AudioData audio(1, rate, 1);
+    audio.setNumChannels(2);
+    audio.setFeatures(all);
+    audio.setFeatureConfig(config);
+    audio.generate();
+    std::string outputDir = "test_audio_features";
+    audio.exportToDirectory(outputDir);
+    std::vector<unsigned char> npy = readFile(outputDir + "/audio_1_mfcc.npy");
+    assert(npy[0] == 0x93 && std::string(npy.begin() + 1, npy.begin() + 6) == "NUMPY");
+    size_t headerLength = static_cast<size_t>(readLE(npy, 8, 2));
+    assert((10 + headerLength) % 64 == 0);
+    std::string header(npy.begin() + 10, npy.begin() + 10 + headerLength);
+    assert(header.find("'shape': (2, " + std::to_string(frames) + ", 13)") != std::string::npos);
+    assert(npy.size() == 10 + headerLength + 2 * frames * 13 * 4);
+    assert(fs::exists(outputDir + "/audio_1_spectrogram.npy") && fs::exists(outputDir + "/audio_1_mel.npy"));
+    fs::remove_all(outputDir);
+
+    std::cout << "Audio feature tests passed!" << std::endl;
+}
+
+void testStreaming() {
+    std::cout << "Testing audio streaming..." << std::endl;
+
+    // The ring hands items across threads in order, never holding more than its capacity
+    RingBuffer<int> ring(1000);
+    assert(ring.capacity() == 1000);
+    const int total = 200000;
+    std::thread producer([&ring]() {
+        int next = 0;
+        while (next < total) {
+            int chunk[37];
+            int count = std::min(37, total - next);
+            for (int i = 0; i < count; i++) {
+                chunk[i] = next + i;
+            }
+            int pushed = 0;
+            while (pushed < count) {
+                pushed += static_cast<int>(ring.write(chunk + pushed, count - pushed));
+            }
+            next += count;
+        }
+    });
+    int expected = 0;
+    int chunk[53];
+    while (expected < total) {
+        assert(ring.size() <= 1000);
+        size_t got = ring.read(chunk, 53);
+        for (size_t i = 0; i < got; i++) {
+            assert(chunk[i] == expected++);
+        }
+    }
+    producer.join();
+    assert(ring.size() == 0);
+
+#ifndef _WIN32
+    // Stream one second of stereo PCM16 to a UNIX socket, paced at 20x real time
+    std::string socketPath = "test_audio_stream.sock";
+    ::unlink(socketPath.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    assert(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    assert(listen(listener, 1) == 0);
+
+    size_t received = 0;
+    std::thread reader([&]() {
+        int connection = accept(listener, nullptr, nullptr);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(connection, buffer, sizeof(buffer))) > 0) {
+            received += static_cast<size_t>(n);
+        }
+        close(connection);
+    });
+
+    AudioData audio(1, 8000, 1);
+    audio.setNumChannels(2);
+    StreamConfig config;
+    config.target = StreamTarget::UNIX_SOCKET;
+    config.path = socketPath;
+    config.speed = 20.0;
+    config.maxSeconds = 1.0;
+    auto start = std::chrono::steady_clock::now();
+    StreamStats stats = audio.stream(config);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    reader.join();
+    close(listener);
+    ::unlink(socketPath.c_str());
+    assert(stats.framesWritten == 8000 && !stats.readerClosed);
+    assert(received == 8000 * 2 * 2);
+    assert(elapsed > 0.04);  // 1 s of audio at 20x is paced over about 50 ms
+
+    // An external stop flag ends an endless stream
+    ::unlink(socketPath.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    assert(listen(listener, 1) == 0);
+    std::atomic<bool> stop(false);
+    received = 0;
+    std::thread endlessReader([&]() {
+        int connection = accept(listener, nullptr, nullptr);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(connection, buffer, sizeof(buffer))) > 0) {
+            received += static_cast<size_t>(n);
+            if (received > 100000) {
+                stop.store(true);
+            }
+        }
+        close(connection);
+    });
+    config.speed = 0.0;
+    config.maxSeconds = 0.0;
+    stats = audio.stream(config, &stop);
+    endlessReader.join();
+    close(listener);
+    ::unlink(socketPath.c_str());
+    assert(stats.framesWritten * 4 == received && received > 100000);
+
+    // A reader hanging up ends the stream without SIGPIPE, which is left at its default
+    ::unlink(socketPath.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    assert(listen(listener, 1) == 0);
+    std::thread hangingUpReader([&]() {
+        int connection = accept(listener, nullptr, nullptr);
+        char buffer[4096];
+        assert(read(connection, buffer, sizeof(buffer)) > 0);
+        close(connection);
+    });
+    stats = audio.stream(config);
+    hangingUpReader.join();
+    close(listener);
+    ::unlink(socketPath.c_str());
+    assert(stats.readerClosed);
+#endif
+
+    // Zero-length clips are rejected instead of leaving the writer waiting for frames
+    AudioData empty(1, 16000, 0);
+    StreamConfig emptyConfig;
+    emptyConfig.target = StreamTarget::REGULAR_FILE;
+    emptyConfig.path = "test_empty_stream.pcm";
+    emptyConfig.speed = 0.0;
+    emptyConfig.maxSeconds = 1.0;
+    bool threw = false;
+    try {
+        empty.stream(emptyConfig);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    fs::remove(emptyConfig.path);
+
+    std::cout << "Audio streaming tests passed!" << std::endl;
+}
+
 int main() {
     testAudioDataGeneration();
+    testOscillators();
+    testPCMEncoding();
+    testWAVContainers();
+    testMultichannel();
+    testColoredNoise();
+    testMixerAndResampler();
+    testAudioFeatures();
+    testStreaming();
     return 0;
 }
\ No newline at end of file
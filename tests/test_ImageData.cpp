@@ -1,7 +1,15 @@
 #include "ImageData.h"
+#include "RandomGenerators.h"
 #include <iostream>
 #include <cassert>
 #include <filesystem>
+#include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <fstream>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -15,9 +23,9 @@ void testImageDataGeneration() {
     auto imageData1 = images1.getImages();
 
     assert(imageData1.size() == 5);
-    assert(imageData1[0].rows == 32);
-    assert(imageData1[0].cols == 32);
-    assert(imageData1[0].channels() == 3);
+    assert(imageData1[0].height == 32);
+    assert(imageData1[0].width == 32);
+    assert(imageData1[0].channels == 3);
 
     // Test geometric shapes image generation
     ImageData images2(3, 64, 64, 1);
@@ -26,9 +34,9 @@ void testImageDataGeneration() {
     auto imageData2 = images2.getImages();
 
     assert(imageData2.size() == 3);
-    assert(imageData2[0].rows == 64);
-    assert(imageData2[0].cols == 64);
-    assert(imageData2[0].channels() == 1);
+    assert(imageData2[0].height == 64);
+    assert(imageData2[0].width == 64);
+    assert(imageData2[0].channels == 1);
 
     // Test export to directory
     std::string outputDir = "test_images";
@@ -51,7 +59,327 @@ void testImageDataGeneration() {
     std::cout << "ImageData tests passed!" << std::endl;
 }
 
+void testNoiseTextures() {
+    std::cout << "Testing noise texture generation..." << std::endl;
+
+    for (ImageType type : { ImageType::PERLIN_NOISE, ImageType::WORLEY_NOISE }) {
+        ImageData images(2, 48, 40, 3);
+        images.setImageType(type);
+        images.setNoiseParameters(4.0f, 5);
+        images.setNumThreads(3);
+        images.generate();
+        auto textures = images.getImages();
+
+        assert(textures.size() == 2);
+        assert(textures[0].width == 48);
+        assert(textures[0].height == 40);
+
+        // A smooth texture changes little between neighbouring pixels
+        long long neighbourDiff = 0;
+        for (int y = 0; y < 40; y++) {
+            for (int x = 1; x < 48; x++) {
+                neighbourDiff += std::abs(textures[0].at(y, x, 0) - textures[0].at(y, x - 1, 0));
+            }
+        }
+        assert(neighbourDiff / (40 * 47) < 32);
+    }
+
+    // Raw fBm rows stay normalized and actually vary
+    std::mt19937 rng(7);
+    GradientNoise gradient(rng);
+    CellularNoise cellular(rng);
+    FractalParameters params;
+    std::vector<float> row(256);
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 0) {
+            gradient.fractalRow(3.7f, 0.0f, 0.05f, 256, params, row.data());
+        } else {
+            cellular.fractalRow(3.7f, 0.0f, 0.05f, 256, params, row.data());
+        }
+        float lo = row[0], hi = row[0];
+        for (float v : row) {
+            assert(v >= -1.0f && v <= 1.0f);
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        assert(hi - lo > 0.1f);
+    }
+
+    // Parameters that would give a zero amplitude sum are rejected
+    ImageData invalid(1, 8, 8, 1);
+    for (float gain : { -1.0f, 0.0f }) {
+        bool threw = false;
+        try {
+            invalid.setNoiseParameters(4.0f, 2, 2.0f, gain);
+        }
+        catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    bool threw = false;
+    try {
+        invalid.setNoiseParameters(4.0f, 2, 0.0f, 0.5f);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Noise texture tests passed!" << std::endl;
+}
+
+void testImageAugmentation() {
+    std::cout << "Testing image augmentation..." << std::endl;
+
+    ImageData source(1, 40, 30, 3);
+    source.setImageType(ImageType::GRADIENT);
+    source.generate();
+    Image original = source.getImages()[0];
+
+    ImageAugmenter augmenter;
+
+    // Identity parameters reproduce the input exactly
+    AugmentationParams identity;
+    identity.cropWidth = 40;
+    identity.cropHeight = 30;
+    Image copy = augmenter.apply(original, identity);
+    assert(copy.data == original.data);
+
+    // Flip + crop picks the mirrored window
+    AugmentationParams flip = identity;
+    flip.flipHorizontal = true;
+    flip.cropX = 5;
+    flip.cropWidth = 20;
+    Image flipped = augmenter.apply(original, flip);
+    assert(flipped.width == 20 && flipped.height == 30);
+    assert(flipped.at(3, 0, 1) == original.at(3, 24, 1));
+    assert(flipped.at(3, 19, 2) == original.at(3, 5, 2));
+
+    // Blurring a flat image leaves it flat, whatever the thread split
+    Image flat(33, 17, 3);
+    std::fill(flat.data.begin(), flat.data.end(), 120);
+    AugmentationParams blur;
+    blur.cropWidth = 33;
+    blur.cropHeight = 17;
+    blur.blurSigma = 1.5f;
+    blur.rotationDegrees = 10.0f;
+    Image blurred = augmenter.apply(flat, blur, 4);
+    for (unsigned char v : blurred.data) {
+        assert(v == 120);
+    }
+
+    // Randomized pipeline through ImageData
+    augmenter.setCrop(24, 24);
+    augmenter.setFlipProbability(0.5, 0.5);
+    augmenter.setRotationRange(15.0f);
+    augmenter.setBlurSigmaRange(0.5f, 1.0f);
+    augmenter.setHSVJitter(20.0f, 0.2f, 0.2f);
+    ImageData augmented(3, 32, 32, 3);
+    augmented.setImageType(ImageType::GEOMETRIC_SHAPES);
+    augmented.setAugmenter(augmenter);
+    augmented.generate();
+    for (const auto& img : augmented.getImages()) {
+        assert(img.width == 24 && img.height == 24);
+    }
+
+    std::cout << "Image augmentation tests passed!" << std::endl;
+}
+
+void testStreamingGeneration() {
+    std::cout << "Testing streaming image generation..." << std::endl;
+
+    // Streaming writes the same files as generate() + exportToDirectory() for the same seed
+    ImageData batch(6, 32, 24, 3);
+    batch.setImageType(ImageType::GEOMETRIC_SHAPES);
+    RandomGenerators::initialize(1234);
+    batch.generate();
+    batch.exportToDirectory("test_batch");
+
+    std::string streamDir = "test_stream";
+    fs::create_directories(streamDir + "/image_2.ppm");  // makes one file fail to open
+
+    int callbacks = 0;
+    batch.setAnnotationsEnabled(true);
+    RandomGenerators::initialize(1234);
+    ImageStreamSummary summary = batch.generateToDirectory(streamDir, [&](const ImageWriteResult& result) {
+        callbacks++;
+        assert(result.success == (result.index != 1));
+    });
+
+    assert(callbacks == 6);
+    assert(summary.written == 5);
+    assert(summary.failed == 1);
+    assert(summary.failures[0].index == 1);
+    assert(!summary.failures[0].error.empty());
+
+    for (int i = 1; i <= 6; i++) {
+        if (i == 2) {
+            continue;
+        }
+        std::string name = "/image_" + std::to_string(i) + ".ppm";
+        std::ifstream a("test_batch" + name, std::ios::binary);
+        std::ifstream b(streamDir + name, std::ios::binary);
+        std::string contentA((std::istreambuf_iterator<char>(a)), std::istreambuf_iterator<char>());
+        std::string contentB((std::istreambuf_iterator<char>(b)), std::istreambuf_iterator<char>());
+        assert(!contentA.empty() && contentA == contentB);
+    }
+
+    // The image that failed to write is left out of the annotations
+    std::ifstream labels(streamDir + "/annotations.json");
+    std::string json((std::istreambuf_iterator<char>(labels)), std::istreambuf_iterator<char>());
+    labels.close();
+    assert(json.find("\"image_1.ppm\"") != std::string::npos && json.find("\"image_6.ppm\"") != std::string::npos);
+    assert(json.find("\"image_2.ppm\"") == std::string::npos && json.find("\"image_id\": 2,") == std::string::npos);
+
+    fs::remove_all("test_batch");
+    fs::remove_all(streamDir);
+
+    std::cout << "Streaming image generation tests passed!" << std::endl;
+}
+
+void testShapeAnnotations() {
+    std::cout << "Testing shape annotations..." << std::endl;
+
+    ImageData shapes(20, 48, 40, 3);
+    shapes.setImageType(ImageType::GEOMETRIC_SHAPES);
+    shapes.setAnnotationsEnabled(true);
+    shapes.generate();
+    auto images = shapes.getImages();
+    auto annotations = shapes.getAnnotations();
+    assert(annotations.size() == 20);
+
+    for (size_t i = 0; i < images.size(); i++) {
+        const Image& img = images[i];
+        std::vector<int> owner(img.width * img.height, -1);
+
+        for (size_t s = 0; s < annotations[i].shapes.size(); s++) {
+            const ShapeAnnotation& shape = annotations[i].shapes[s];
+
+            // Decode the column-major RLE; runs must cover the image exactly
+            int pos = 0, area = 0;
+            for (size_t k = 0; k < shape.rleCounts.size(); k++) {
+                if (k % 2 == 1) {
+                    for (int p = pos; p < pos + shape.rleCounts[k]; p++) {
+                        int x = p / img.height;
+                        int y = p % img.height;
+                        assert(owner[y * img.width + x] == -1);
+                        owner[y * img.width + x] = static_cast<int>(s);
+                        assert(x >= shape.bboxX && x < shape.bboxX + shape.bboxWidth);
+                        assert(y >= shape.bboxY && y < shape.bboxY + shape.bboxHeight);
+                        assert(img.at(y, x, 0) == shape.color.r);
+                        assert(img.at(y, x, 1) == shape.color.g);
+                        assert(img.at(y, x, 2) == shape.color.b);
+                        area++;
+                    }
+                }
+                pos += shape.rleCounts[k];
+            }
+            assert(pos == img.width * img.height);
+            assert(area == shape.area);
+        }
+
+        // Everything unlabeled is background
+        for (int y = 0; y < img.height; y++) {
+            for (int x = 0; x < img.width; x++) {
+                if (owner[y * img.width + x] == -1) {
+                    assert(img.at(y, x, 0) == 255 && img.at(y, x, 1) == 255 && img.at(y, x, 2) == 255);
+                }
+            }
+        }
+    }
+
+    std::string labelFile = "test_annotations.json";
+    shapes.exportAnnotations(labelFile);
+    assert(fs::exists(labelFile));
+    assert(fs::file_size(labelFile) > 0);
+    fs::remove(labelFile);
+
+    std::cout << "Shape annotation tests passed!" << std::endl;
+}
+
+void testPixelFormats() {
+    std::cout << "Testing pixel formats..." << std::endl;
+
+    // The same seed renders the same picture in every format, up to the sample scale
+    std::vector<Image> rendered;
+    for (PixelFormat format : { PixelFormat::UINT8, PixelFormat::UINT16, PixelFormat::FLOAT32 }) {
+        ImageData patterns(2, 40, 30, 3);
+        patterns.setImageType(ImageType::PATTERN);
+        patterns.setPixelFormat(format);
+        RandomGenerators::initialize(99);
+        patterns.generate();
+        rendered.push_back(patterns.getImages()[0]);
+        assert(rendered.back().format == format);
+        assert(rendered.back().data.size() == 40 * 30 * 3 * bytesPerSample(format));
+    }
+
+    auto u8 = rendered[0].view<unsigned char, 3>();
+    auto u16 = rendered[1].view<std::uint16_t, 3>();
+    auto f32 = rendered[2].view<float, 3>();
+    for (int y = 0; y < 30; y++) {
+        for (int i = 0; i < 40 * 3; i++) {
+            assert(u16.row(y)[i] == u8.row(y)[i] * 257);
+            assert(std::abs(f32.row(y)[i] - u8.row(y)[i] / 255.0f) < 1e-6f);
+        }
+    }
+
+    // Mismatched views are rejected
+    bool threw = false;
+    try {
+        rendered[0].view<float, 3>();
+    } catch (const std::logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // So is byte access to samples wider than a byte
+    for (size_t i = 1; i < rendered.size(); i++) {
+        threw = false;
+        try {
+            rendered[i].getPixel(0, 0);
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+
+    // Gray float noise augments and exports as PFM
+    ImageData noise(2, 32, 32, 1);
+    noise.setImageType(ImageType::PERLIN_NOISE);
+    noise.setPixelFormat(PixelFormat::FLOAT32);
+    ImageAugmenter augmenter;
+    augmenter.setRotationRange(20.0f);
+    augmenter.setBlurSigmaRange(0.5f, 1.0f);
+    noise.setAugmenter(augmenter);
+    noise.generate();
+    auto noiseImages = noise.getImages();
+    auto gray = noiseImages[1].view<float, 1>();
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 32; x++) {
+            assert(gray.row(y)[x] > -1e-5f && gray.row(y)[x] < 1.0f + 1e-5f);
+        }
+    }
+
+    std::string outputDir = "test_pfm";
+    noise.exportToDirectory(outputDir);
+    std::string pfm = outputDir + "/image_1.pfm";
+    assert(fs::exists(pfm));
+    std::ifstream file(pfm, std::ios::binary);
+    std::string magic;
+    file >> magic;
+    assert(magic == "PF");
+    fs::remove_all(outputDir);
+
+    std::cout << "Pixel format tests passed!" << std::endl;
+}
+
 int main() {
     testImageDataGeneration();
+    testNoiseTextures();
+    testImageAugmentation();
+    testStreamingGeneration();
+    testShapeAnnotations();
+    testPixelFormats();
     return 0;
 }
\ No newline at end of file
@@ -15,6 +15,21 @@ void testTabularDataGeneration() {
 	assert(data1.size() == 10);
 	assert(data1[0].size() == 3);
 
+	//date columns stay within their inclusive range
+	ColumnDefinition dateColumn;
+	dateColumn.name = "Day";
+	dateColumn.type = ColumnType::DATE;
+	dateColumn.parameters["start"] = "2024-02-27";
+	dateColumn.parameters["end"] = "2024-03-01";
+	TabularData dates(200, std::vector<ColumnDefinition>{ dateColumn });
+	dates.generate();
+	bool sawLeapDay = false;
+	for (const auto& row : dates.getData()) {
+		assert(row[0] == "2024-02-27" || row[0] == "2024-02-28" || row[0] == "2024-02-29" || row[0] == "2024-03-01");
+		sawLeapDay = sawLeapDay || row[0] == "2024-02-29";
+	}
+	assert(sawLeapDay);
+
 	//Test with custom column definitions
 	std::vector<ColumnDefinition> columns;
 
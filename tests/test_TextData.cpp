@@ -1,9 +1,19 @@
 #include "TextData.h"
 #include <iostream>
 #include <cassert>
+#include <cmath>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -66,15 +76,536 @@ void testTextDataGeneration() {
 
     // Each sample followed by an empty line, so 5 samples = 10 lines
     assert(lineCount >= 5);
+    file.close();
+
+    // Samples are views into one arena and the export is that arena verbatim
+    assert(text1.getSampleCount() == 5);
+    std::string expected;
+    for (size_t i = 0; i < text1.getSampleCount(); i++) {
+        std::string_view sample = text1.getTextSample(i);
+        assert(!sample.empty() && sample.back() == '.' && sample == samples1[i]);
+        expected.append(sample.data(), sample.size());
+        expected += "\n\n";
+    }
+    std::ifstream exported(outputFile, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(exported)), std::istreambuf_iterator<char>());
+    exported.close();
+    assert(contents == expected);
 
     // Clean up test file
-    file.close();
     fs::remove(outputFile);
 
     std::cout << "TextData tests passed!" << std::endl;
 }
 
+void testMarkovModel() {
+    std::cout << "Testing Markov model..." << std::endl;
+
+    // Order 1: "a" is always followed by "b", "b" by "c" or "d" in a 2:1 ratio
+    std::vector<std::string> words = { "a", "b", "c", "a", "b", "c", "a", "b", "d" };
+    MarkovModel bigram(words, 1);
+    assert(bigram.vocabularySize() == 4 && bigram.numStates() == 3);  // "d" ends the sequence
+    assert(bigram.word(0) == "a" && bigram.word(3) == "d");
+    std::mt19937 rng(7);
+    std::uint32_t a = 0, b = 1;
+    int followC = 0;
+    for (int i = 0; i < 30000; i++) {
+        assert(bigram.sampleNext(&a, rng) == 1);
+        followC += bigram.sampleNext(&b, rng) == 2 ? 1 : 0;
+    }
+    assert(followC > 19000 && followC < 21000);
+
+    // Order 2 over a sequence with unique contexts reproduces the sequence
+    std::vector<std::string> sequence;
+    for (int i = 0; i < 50; i++) {
+        sequence.push_back("w" + std::to_string(i));
+    }
+    MarkovModel trigram(sequence, 2);
+    assert(trigram.numStates() == 48);
+    for (std::uint32_t i = 0; i + 2 < 50; i++) {
+        std::uint32_t context[2] = { i, i + 1 };
+        assert(trigram.sampleNext(context, rng) == i + 2);
+    }
+
+    // One model shared read-only by several threads
+    std::vector<std::thread> threads;
+    std::vector<int> valid(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&trigram, &valid, t]() {
+            std::mt19937 local(t);
+            std::uint32_t context[2];
+            trigram.sampleStart(local, context);
+            for (int i = 0; i < 1000; i++) {
+                std::uint32_t next = trigram.sampleNext(context, local);
+                valid[t] += next < 50 ? 1 : 0;
+                context[0] = context[1];
+                context[1] = next;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    assert(valid == std::vector<int>(4, 1000));
+
+    // TextData builds its model once and reuses it across generate() calls
+    TextData text(20, 40);
+    text.setTextType(TextType::MARKOV_CHAIN);
+    text.setWordList(sequence);
+    text.setMarkovOrder(2);
+    text.generate();
+    std::shared_ptr<const MarkovModel> model = text.getMarkovModel();
+    text.generate();
+    assert(text.getMarkovModel() == model && model->getOrder() == 2);
+    for (const std::string& sample : text.getTextSamples()) {
+        assert(!sample.empty() && sample[0] == 'W' && sample.back() == '.');
+    }
+
+    std::cout << "Markov model tests passed!" << std::endl;
+}
+
+void testMarkovTraining() {
+    std::cout << "Testing Markov corpus training..." << std::endl;
+
+    // A corpus large enough to be split into several chunks; every sentence is
+    // "the <animal> <verb> the <object>." so each context has known successors
+    const std::vector<std::string> animals = { "cat", "dog", "fox", "owl" };
+    const std::vector<std::string> verbs = { "sees", "chases", "likes" };
+    std::string corpusFile = "test_corpus.txt";
+    {
+        std::ofstream corpus(corpusFile);
+        for (int i = 0; i < 60000; i++) {
+            corpus << (i % 7 == 0 ? "The " : "the ") << animals[i % 4] << " " << verbs[i % 3] << " the ball.\n";
+        }
+    }
+
+    for (int threads : { 1, 4 }) {
+        MarkovModel model = MarkovModel::trainFromFiles({ corpusFile }, 1, threads);
+        assert(model.vocabularySize() == 9);  // case and punctuation are normalized away
+        std::mt19937 rng(3);
+        std::uint32_t context[1];
+        model.sampleStart(rng, context);
+        for (int i = 0; i < 2000; i++) {
+            std::uint32_t next = model.sampleNext(context, rng);
+            std::string_view previous = model.word(context[0]);
+            std::string_view word = model.word(next);
+            if (previous == "cat" || previous == "dog" || previous == "fox" || previous == "owl") {
+                assert(word == "sees" || word == "chases" || word == "likes");
+            }
+            if (previous == "ball") {
+                assert(word == "the");
+            }
+            context[0] = next;
+        }
+    }
+
+    // Order-2 counts merged across chunks match a single-chunk run exactly
+    MarkovModel serial = MarkovModel::trainFromFiles({ corpusFile }, 2, 1);
+    MarkovModel parallel = MarkovModel::trainFromFiles({ corpusFile }, 2, 4);
+    assert(serial.numStates() == parallel.numStates());
+
+    // Save, then map the file back and sample identically
+    std::string modelFile = "test_model.bin";
+    parallel.save(modelFile);
+    MarkovModel loaded = MarkovModel::load(modelFile);
+    assert(loaded.getOrder() == 2 && loaded.numStates() == parallel.numStates());
+    assert(loaded.vocabularySize() == parallel.vocabularySize() && loaded.word(3) == parallel.word(3));
+    std::mt19937 rngA(11), rngB(11);
+    std::uint32_t contextA[2], contextB[2];
+    parallel.sampleStart(rngA, contextA);
+    loaded.sampleStart(rngB, contextB);
+    for (int i = 0; i < 1000; i++) {
+        std::uint32_t a = parallel.sampleNext(contextA, rngA);
+        std::uint32_t b = loaded.sampleNext(contextB, rngB);
+        assert(a == b);
+        contextA[0] = contextA[1];
+        contextA[1] = a;
+        contextB[0] = contextB[1];
+        contextB[1] = b;
+    }
+
+    // A loaded model drives TextData directly
+    TextData text(3, 25);
+    text.setTextType(TextType::MARKOV_CHAIN);
+    text.loadMarkovModel(modelFile);
+    text.generate();
+    assert(text.getTextSamples().size() == 3 && text.getMarkovModel()->getOrder() == 2);
+
+    // Files that are not models are rejected
+    bool threw = false;
+    try {
+        MarkovModel::load(corpusFile);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Consistent table sizes with out-of-order word offsets are rejected too
+    std::string corruptFile = "test_model_corrupt.bin";
+    fs::copy_file(modelFile, corruptFile, fs::copy_options::overwrite_existing);
+    {
+        std::fstream corrupt(corruptFile, std::ios::in | std::ios::out | std::ios::binary);
+        const std::uint64_t offset = ~0ull;
+        corrupt.seekp(120 + sizeof(std::uint64_t));  // wordOffsets[1], after the 120-byte header
+        corrupt.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    threw = false;
+    try {
+        MarkovModel::load(corruptFile);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    fs::remove(corpusFile);
+    fs::remove(modelFile);
+    fs::remove(corruptFile);
+    std::cout << "Markov corpus training tests passed!" << std::endl;
+}
+
+void testTemplateEngine() {
+    std::cout << "Testing template engine..." << std::endl;
+
+    // Literals, bare and braced slots and $$ render in one pass
+    std::unordered_map<std::string, TemplateSlot> slots = {
+        { "COLOR", { { "red", "blue" }, { 1.0, 0.0 } } },
+        { "Item", { { "cup" }, {} } }
+    };
+    TemplateEngine engine({ "A $COLOR ${Item}s costs $$5.", "$COLOR" }, slots);
+    assert(engine.numTemplates() == 2);
+    assert(engine.wordCount(0) == 5 && engine.wordCount(1) == 1);
+    std::mt19937 rng(3);
+    std::string out;
+    engine.render(0, rng, out);
+    assert(out == "A red cups costs $5.");
+
+    // Weights are honored
+    slots["COLOR"].weights = { 1.0, 3.0 };
+    TemplateEngine weighted({ "$COLOR" }, slots);
+    int blue = 0;
+    for (int i = 0; i < 20000; i++) {
+        out.clear();
+        weighted.render(0, rng, out);
+        blue += out == "blue";
+    }
+    assert(blue > 14500 && blue < 15500);
+
+    // Unknown slots are reported when compiling
+    bool threw = false;
+    try {
+        TemplateEngine bad({ "$MISSING" }, slots);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Samples chain templates until they reach wordsPerSample
+    TextData text(5, 40);
+    text.setTextType(TextType::TEMPLATE_BASED);
+    text.setTemplates({ "The $NOUN $VERB $ANIMAL." });
+    text.setTemplateSlot("ANIMAL", { "cat", "dog" });
+    text.generate();
+    for (const auto& sample : text.getTextSamples()) {
+        int words = 1;
+        for (char c : sample) {
+            words += c == ' ';
+        }
+        assert(words == 40);
+        assert(sample.find('$') == std::string::npos);
+    }
+
+    std::cout << "Template engine tests passed!" << std::endl;
+}
+
+// Read an .npy file written by FileExport: returns the header dict and the raw data
+static std::string readNPY(const std::string& filename, std::string& data) {
+    std::ifstream file(filename, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t headerLength = static_cast<unsigned char>(contents[8]) | (static_cast<unsigned char>(contents[9]) << 8);
+    assert((10 + headerLength) % 64 == 0);
+    data = contents.substr(10 + headerLength);
+    return contents.substr(10, headerLength);
+}
+
+void testTokenExport() {
+    std::cout << "Testing token export..." << std::endl;
+
+    // Random words: the token stream spells out each sample exactly
+    TextData text(4, 30);
+    text.setTextType(TextType::RANDOM_WORDS);
+    text.setRecordTokens(true);
+    text.generate();
+    assert(text.getToken(TextData::EOS_TOKEN) == "<eos>" && text.getToken(TextData::PAD_TOKEN) == "<pad>");
+    text.exportTokens("test_tokens");
+
+    std::string data;
+    std::string header = readNPY("test_tokens.tokens.npy", data);
+    assert(header.find("'<u2'") != std::string::npos);
+    std::vector<std::uint16_t> tokens(data.size() / 2);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        tokens[i] = static_cast<std::uint16_t>(static_cast<unsigned char>(data[2 * i]) | (static_cast<unsigned char>(data[2 * i + 1]) << 8));
+    }
+    std::string docsHeader = readNPY("test_tokens.docs.npy", data);
+    assert(docsHeader.find("'<u8'") != std::string::npos && docsHeader.find("(5,)") != std::string::npos);
+    std::vector<std::uint64_t> docs(5);
+    std::memcpy(docs.data(), data.data(), data.size());  // little-endian host
+    assert(docs[0] == 0 && docs[4] == tokens.size());
+
+    for (size_t d = 0; d < 4; d++) {
+        assert(tokens[docs[d + 1] - 1] == TextData::EOS_TOKEN);
+        std::string rebuilt;
+        for (size_t t = docs[d]; t + 1 < docs[d + 1]; t++) {
+            const std::string token = text.getToken(tokens[t]);
+            if (!rebuilt.empty() && token != "." && token != "?" && token != "!") {
+                rebuilt += ' ';
+            }
+            rebuilt += token;
+        }
+        rebuilt[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(rebuilt[0])));
+        assert(rebuilt == text.getTextSample(d));
+    }
+
+    std::ifstream vocabularyFile("test_tokens.vocab.txt");
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(vocabularyFile, line)) {
+        assert(line == text.getToken(static_cast<std::uint32_t>(lines)));
+        lines++;
+    }
+    vocabularyFile.close();
+    assert(lines == text.getTokenVocabularySize());
+
+    // Packed into fixed-length 32-bit rows with the last row padded
+    TokenExportConfig packed;
+    packed.width = TokenWidth::UINT32;
+    packed.sequenceLength = 16;
+    text.exportTokens("test_tokens", packed);
+    const size_t rows = (tokens.size() + 15) / 16;
+    header = readNPY("test_tokens.tokens.npy", data);
+    assert(header.find("'<u4'") != std::string::npos);
+    assert(header.find("(" + std::to_string(rows) + ", 16)") != std::string::npos);
+    assert(data.size() == rows * 16 * 4);
+    std::uint32_t last;
+    std::memcpy(&last, data.data() + data.size() - 4, 4);
+    assert(tokens.size() % 16 == 0 || last == TextData::PAD_TOKEN);
+
+    packed.dropRemainder = true;
+    text.exportTokens("test_tokens", packed);
+    header = readNPY("test_tokens.tokens.npy", data);
+    assert(data.size() == tokens.size() / 16 * 16 * 4);
+
+    // Every generator records one EOS per sample
+    for (TextType type : { TextType::LOREM_IPSUM, TextType::MARKOV_CHAIN, TextType::TEMPLATE_BASED }) {
+        TextData other(3, 20);
+        other.setTextType(type);
+        other.setRecordTokens(true);
+        other.generate();
+        other.exportTokens("test_tokens");
+        readNPY("test_tokens.docs.npy", data);
+        std::vector<std::uint64_t> offsets(4);
+        std::memcpy(offsets.data(), data.data(), data.size());
+        for (size_t d = 0; d < 3; d++) {
+            assert(offsets[d + 1] - offsets[d] > 20);  // 20 words, punctuation and EOS
+        }
+    }
+
+    // Exporting without recording fails
+    TextData plain(1, 5);
+    plain.generate();
+    bool threw = false;
+    try {
+        plain.exportTokens("test_tokens");
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    fs::remove("test_tokens.tokens.npy");
+    fs::remove("test_tokens.docs.npy");
+    fs::remove("test_tokens.vocab.txt");
+    std::cout << "Token export tests passed!" << std::endl;
+}
+
+void testZipfVocabulary() {
+    std::cout << "Testing Zipf vocabulary..." << std::endl;
+
+    // Rank frequencies follow k^-s: with s = 1 and 1000 words, P(k) = 1 / (k H(1000))
+    ZipfVocabulary zipf(1000, 1.0);
+    std::mt19937 rng(5);
+    std::vector<int> counts(1001, 0);
+    const int draws = 200000;
+    for (int i = 0; i < draws; i++) {
+        std::uint64_t rank = zipf.sampleRank(rng);
+        assert(rank >= 1 && rank <= 1000);
+        counts[rank]++;
+    }
+    double harmonic = 0.0;
+    for (int k = 1; k <= 1000; k++) {
+        harmonic += 1.0 / k;
+    }
+    for (int k : { 1, 2, 10 }) {
+        double expected = draws / (k * harmonic);
+        assert(std::abs(counts[k] - expected) < 0.05 * expected);
+    }
+
+    // Words are derived from ranks: distinct, and short for frequent ranks
+    std::unordered_map<std::string, std::uint64_t> seen;
+    for (std::uint64_t rank = 1; rank <= 20000; rank++) {
+        std::string word = zipf.word(rank);
+        assert(seen.emplace(word, rank).second);
+        assert(word.size() == (rank <= 100 ? 2u : rank <= 10100 ? 4u : 6u));
+    }
+    assert(zipf.word(42) == ZipfVocabulary(5, 2.0).word(42));
+
+    // Huge vocabularies cost nothing to set up
+    ZipfVocabulary huge(50000000, 1.1);
+    for (int i = 0; i < 1000; i++) {
+        std::uint64_t rank = huge.sampleRank(rng);
+        assert(rank >= 1 && rank <= 50000000);
+    }
+    assert(huge.word(50000000).size() == 8);
+
+    // RANDOM_WORDS draws from it; token IDs after the reserved ones are ranks
+    TextData text(3, 25);
+    text.setTextType(TextType::RANDOM_WORDS);
+    text.setZipfVocabulary(1000000, 1.2);
+    text.setRecordTokens(true);
+    text.generate();
+    assert(text.getTokenVocabularySize() == 5 + 1000000);
+    assert(text.getToken(5) == zipf.word(1));
+    text.exportTokens("test_zipf");
+    std::string data;
+    std::string header = readNPY("test_zipf.tokens.npy", data);
+    assert(header.find("'<u4'") != std::string::npos);  // the vocabulary needs 32 bits
+    std::uint32_t token;
+    std::memcpy(&token, data.data(), 4);
+    std::string word = text.getToken(token);
+    word[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(word[0])));
+    std::string_view sample = text.getTextSample(0);
+    assert(sample.substr(0, sample.find(' ')) == word);
+    fs::remove("test_zipf.tokens.npy");
+    fs::remove("test_zipf.docs.npy");
+    fs::remove("test_zipf.vocab.txt");
+
+    bool threw = false;
+    try {
+        ZipfVocabulary bad(0, 1.0);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    std::cout << "Zipf vocabulary tests passed!" << std::endl;
+}
+
+void testLogLines() {
+    std::cout << "Testing log lines..." << std::endl;
+
+    // JSON lines with monotonic timestamps, one per sample, exported one per line
+    TextData logs(10000, 0);
+    logs.setTextType(TextType::LOG_LINES);
+    LogConfig config;
+    config.linesPerSecond = 500.0;
+    config.levelWeights = { 0.0, 1.0, 0.0, 0.0, 0.0 };
+    config.messageSlots["USER"] = { { "quote\"d" }, {} };
+    logs.setLogConfig(config);
+    logs.generate();
+    assert(logs.getSampleCount() == 10000);
+    std::string previous;
+    for (size_t i = 0; i < logs.getSampleCount(); i++) {
+        std::string_view line = logs.getTextSample(i);
+        assert(line.front() == '{' && line.back() == '}');
+        assert(line.find('\n') == std::string_view::npos);
+        assert(line.find("\"level\":\"INFO\"") != std::string_view::npos);
+        // Raw quotes from slot words are escaped inside the message
+        size_t user = line.find("quote");
+        assert(user == std::string_view::npos || line.substr(user, 8) == "quote\\\"d");
+        std::string timestamp(line.substr(14, 24));  // {"timestamp":"YYYY-MM-DDTHH:MM:SS.mmmZ"
+        assert(timestamp.back() == 'Z' && timestamp >= previous);
+        previous = timestamp;
+    }
+    assert(std::string(logs.getTextSample(0)).find("2026-01-01T00:00:00.") != std::string::npos);
+    assert(previous.compare(0, 19, "2026-01-01T00:00:19") == 0);  // 10000 lines at 500/s
+
+    std::string outputFile = "test_logs.txt";
+    logs.exportToFile(outputFile);
+    std::ifstream file(outputFile);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(file, line)) {
+        assert(line == logs.getTextSample(lines));
+        lines++;
+    }
+    file.close();
+    assert(lines == 10000);
+
+    // Apache combined and syslog presets
+    config = LogConfig();
+    config.format = LogFormat::APACHE_COMBINED;
+    config.startTimeMs = 951782400000;  // 2000-02-29T00:00:00Z
+    logs.setLogConfig(config);
+    logs.generate();
+    std::string apache(logs.getTextSample(0));
+    assert(apache.find(" - - [29/Feb/2000:00:00:00 +0000] \"") != std::string::npos);
+    assert(apache.find(" HTTP/1.1\" ") != std::string::npos);
+
+    config.format = LogFormat::SYSLOG;
+    logs.setLogConfig(config);
+    logs.generate();
+    std::string syslog(logs.getTextSample(0));
+    assert(syslog[0] == '<' && syslog.find(">1 2000-02-29T00:00:00.") != std::string::npos);
+    assert(syslog.find(" request_id=") != std::string::npos && syslog.find(" latency_ms=") != std::string::npos);
+
+    // Custom layouts compile from fields; unknown fields are rejected
+    config.pattern = "$epoch_ms $$ $uuid";
+    logs.setLogConfig(config);
+    logs.generate();
+    std::string custom(logs.getTextSample(0));
+    assert(custom.compare(0, 10, "9517824000") == 0 && custom.find(" $ ") != std::string::npos);
+    assert(custom.size() == custom.find(" $ ") + 3 + 36 && custom[custom.size() - 22] == '4');
+    config.pattern = "$nonsense";
+    bool threw = false;
+    try {
+        LogGenerator bad(config);
+    }
+    catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Streaming matches rendering in blocks and stops at the requested count
+    config = LogConfig();
+    logs.setLogConfig(config);
+    std::uint64_t written = logs.streamLogLines(LogGenerator::BLOCK_LINES * 3 + 17, StreamTarget::REGULAR_FILE, outputFile, 2);
+    assert(written == LogGenerator::BLOCK_LINES * 3 + 17);
+    file.open(outputFile);
+    lines = 0;
+    previous.clear();
+    while (std::getline(file, line)) {
+        std::string timestamp = line.substr(14, 24);
+        assert(timestamp >= previous);
+        previous = timestamp;
+        lines++;
+    }
+    file.close();
+    assert(lines == written);
+    fs::remove(outputFile);
+
+    std::cout << "Log line tests passed!" << std::endl;
+}
+
 int main() {
     testTextDataGeneration();
+    testMarkovModel();
+    testMarkovTraining();
+    testTemplateEngine();
+    testTokenExport();
+    testZipfVocabulary();
+    testLogLines();
     return 0;
 }
\ No newline at end of file
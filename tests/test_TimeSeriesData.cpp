@@ -2,7 +2,18 @@
 #include <iostream>
 #include <cassert>
 #include <filesystem>
+#include <fstream>
+#include <string>
 #include <ctime>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "RandomGenerators.h"
+#include "DateTime.h"
+#include "TimeSeriesFile.h"
 
 namespace fs = std::filesystem;
 
@@ -49,7 +60,487 @@ void testTimeSeriesDataGeneration() {
     std::cout << "TimeSeriesData tests passed!" << std::endl;
 }
 
+void testTimeSeriesStream() {
+    std::cout << "Testing TimeSeriesStream..." << std::endl;
+
+    TimeSeriesData config(0, 3);
+    config.setStartTime(1000);
+    config.setTimeStep(60);
+
+    // The same seed gives the same series whatever the block size
+    const TimeSeriesPattern patterns[] = { TimeSeriesPattern::RANDOM_WALK, TimeSeriesPattern::TREND,
+        TimeSeriesPattern::SEASONAL, TimeSeriesPattern::CYCLICAL, TimeSeriesPattern::COMBINED };
+    for (TimeSeriesPattern pattern : patterns) {
+        config.setPattern(pattern);
+        TimeSeriesStream whole(config, 42, 1000, 1000);
+        TimeSeriesBlock reference;
+        assert(whole.nextBlock(reference) == 1000);
+        assert(whole.finished());
+        assert(whole.nextBlock(reference) == 0);
+        whole = TimeSeriesStream(config, 42, 1000, 1000);
+        whole.nextBlock(reference);
+
+        TimeSeriesStream pieces(config, 42, 1000, 7);
+        size_t seen = 0;
+        for (const TimeSeriesBlock& block : pieces) {
+            assert(block.firstIndex == seen);
+            assert(block.size() <= 7);
+            for (size_t i = 0; i < block.size(); ++i) {
+                assert(block.timestamps[i] == reference.timestamps[seen + i]);
+                for (int d = 0; d < 3; ++d) {
+                    assert(block.point(i)[d] == reference.point(seen + i)[d]);
+                }
+            }
+            seen += block.size();
+        }
+        assert(seen == 1000);
+        assert(reference.timestamps[999] == 1000 + 999 * 60);
+    }
+
+    // Oscillators follow the exact phase far into an unbounded stream
+    config.setPattern(TimeSeriesPattern::SEASONAL);
+    TimeSeriesStream endless(config, 7, 0, 4096);
+    TimeSeriesBlock block;
+    double minimum = 1e9;
+    double maximum = -1e9;
+    for (int b = 0; b < 500; ++b) {
+        assert(endless.nextBlock(block) == 4096);
+        for (double value : block.values) {
+            minimum = std::min(minimum, value);
+            maximum = std::max(maximum, value);
+        }
+    }
+    assert(!endless.finished());
+    assert(endless.position() == 500ull * 4096);
+    assert(minimum >= -5.5 && maximum <= 5.5);
+    assert(maximum - minimum > 2.0);
+
+    // generate() is the materialized stream
+    RandomGenerators::initialize(9);
+    TimeSeriesData materialized(300, 2);
+    materialized.setPattern(TimeSeriesPattern::COMBINED);
+    materialized.generate();
+    RandomGenerators::initialize(9);
+    TimeSeriesStream replay = materialized.stream(300, 64);
+    auto points = materialized.getTimeSeries();
+    for (const TimeSeriesBlock& b : replay) {
+        for (size_t i = 0; i < b.size(); ++i) {
+            assert(points[b.firstIndex + i].values[1] == b.point(i)[1]);
+        }
+    }
+
+    std::cout << "TimeSeriesStream tests passed!" << std::endl;
+}
+
+void testCorrelatedTimeSeries() {
+    std::cout << "Testing correlated TimeSeriesData..." << std::endl;
+
+    const std::vector<double> target = {
+        1.0, 0.8, -0.5,
+        0.8, 1.0, 0.0,
+        -0.5, 0.0, 1.0
+    };
+    TimeSeriesData config(0, 3);
+    config.setPattern(TimeSeriesPattern::RANDOM_WALK);
+    config.setCorrelation(target);
+
+    // Walk increments are the innovations: check their correlation and variance
+    TimeSeriesStream walk(config, 11, 200001, 1000);
+    std::vector<double> previous;
+    double sum[3] = { 0, 0, 0 };
+    double products[3][3] = {};
+    size_t samples = 0;
+    for (const TimeSeriesBlock& block : walk) {
+        for (size_t i = 0; i < block.size(); ++i) {
+            const double* point = block.point(i);
+            if (!previous.empty()) {
+                double step[3];
+                for (int d = 0; d < 3; ++d) {
+                    step[d] = point[d] - previous[d];
+                    sum[d] += step[d];
+                }
+                for (int a = 0; a < 3; ++a) {
+                    for (int b = 0; b < 3; ++b) {
+                        products[a][b] += step[a] * step[b];
+                    }
+                }
+                ++samples;
+            }
+            previous.assign(point, point + 3);
+        }
+    }
+    assert(samples == 200000);
+    double covariance[3][3];
+    for (int a = 0; a < 3; ++a) {
+        for (int b = 0; b < 3; ++b) {
+            covariance[a][b] = products[a][b] / samples - (sum[a] / samples) * (sum[b] / samples);
+        }
+    }
+    for (int a = 0; a < 3; ++a) {
+        assert(std::fabs(covariance[a][a] - 1.0 / 3.0) < 0.01);
+        for (int b = 0; b < 3; ++b) {
+            const double correlation = covariance[a][b] / std::sqrt(covariance[a][a] * covariance[b][b]);
+            assert(std::fabs(correlation - target[a * 3 + b]) < 0.02);
+        }
+    }
+
+    // Perfectly correlated dimensions are allowed and move together
+    TimeSeriesData twins(0, 2);
+    twins.setCorrelation({ 1.0, 1.0, 1.0, 1.0 });
+    TimeSeriesStream twinStream(twins, 3, 100, 100);
+    TimeSeriesBlock block;
+    twinStream.nextBlock(block);
+    const double gap = block.point(0)[0] - block.point(0)[1];
+    assert(std::fabs((block.point(99)[0] - block.point(99)[1]) - gap) < 1e-9);
+
+    // Invalid matrices are rejected
+    bool threw = false;
+    try { config.setCorrelation({ 1.0, 0.5, 1.0, 1.0 }); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { config.setCorrelation({ 1.0, 0.9, 0.9, 0.9, 1.0, -0.9, 0.9, -0.9, 1.0 }); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { config.setCorrelation({ 1.0, 0.2, 0.0, 0.3, 1.0, 0.0, 0.0, 0.0, 1.0 }); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // Clearing the matrix restores independent uniform innovations
+    config.setCorrelation({});
+    TimeSeriesStream independent(config, 11, 1000, 1000);
+    independent.nextBlock(block);
+    for (size_t i = 1; i < block.size(); ++i) {
+        assert(std::fabs(block.point(i)[0] - block.point(i - 1)[0]) <= 1.0);
+    }
+
+    std::cout << "Correlated TimeSeriesData tests passed!" << std::endl;
+}
+
+void testProcessPatterns() {
+    std::cout << "Testing stochastic process patterns..." << std::endl;
+
+    auto collect = [](const TimeSeriesData& config, unsigned int seed, size_t points, size_t blockPoints) {
+        TimeSeriesStream stream(config, seed, points, blockPoints);
+        std::vector<double> values;
+        for (const TimeSeriesBlock& block : stream) {
+            values.insert(values.end(), block.values.begin(), block.values.end());
+        }
+        return values;
+    };
+    auto moments = [](const std::vector<double>& x, double& mean, double& variance, double& lag1) {
+        mean = 0.0;
+        for (double v : x) mean += v;
+        mean /= x.size();
+        variance = 0.0;
+        lag1 = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            variance += (x[i] - mean) * (x[i] - mean);
+            if (i > 0) lag1 += (x[i] - mean) * (x[i - 1] - mean);
+        }
+        lag1 /= variance;
+        variance /= x.size();
+    };
+
+    // AR(1): variance sigma^2 / (1 - phi^2) and lag-1 autocorrelation phi
+    TimeSeriesData ar(0, 1);
+    ar.setPattern(TimeSeriesPattern::AUTOREGRESSIVE);
+    ProcessConfig process;
+    process.mean = 5.0;
+    process.arCoefficients = { 0.8 };
+    ar.setProcessConfig(process);
+    std::vector<double> x = collect(ar, 1, 400000, 4096);
+    double mean, variance, lag1;
+    moments(x, mean, variance, lag1);
+    assert(std::fabs(mean - 5.0) < 0.05);
+    assert(std::fabs(variance - 1.0 / 0.36) < 0.1);
+    assert(std::fabs(lag1 - 0.8) < 0.01);
+
+    // ARMA(1, 1) over several dimensions is independent of the block size
+    TimeSeriesData arma(0, 3);
+    arma.setPattern(TimeSeriesPattern::ARMA);
+    assert(collect(arma, 5, 5000, 5000) == collect(arma, 5, 5000, 33));
+
+    // GARCH(1, 1): unconditional variance omega / (1 - alpha - beta), fat tails and
+    // autocorrelated squared returns
+    TimeSeriesData garch(0, 1);
+    garch.setPattern(TimeSeriesPattern::GARCH);
+    x = collect(garch, 2, 400000, 4096);
+    moments(x, mean, variance, lag1);
+    assert(std::fabs(variance - 1.0) < 0.1);
+    std::vector<double> squares(x.size());
+    double fourth = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        squares[i] = (x[i] - mean) * (x[i] - mean);
+        fourth += squares[i] * squares[i];
+    }
+    assert(fourth / x.size() / (variance * variance) > 3.2);
+    double squareMean, squareVariance, squareLag1;
+    moments(squares, squareMean, squareVariance, squareLag1);
+    assert(squareLag1 > 0.1);
+
+    // Regime switching: sticky regimes far apart, shared by all dimensions
+    TimeSeriesData regimes(0, 2);
+    regimes.setPattern(TimeSeriesPattern::REGIME_SWITCHING);
+    process = ProcessConfig();
+    process.regimeMeans = { 0.0, 10.0 };
+    process.regimeStddevs = { 1.0, 1.0 };
+    process.regimeTransitions = { 0.99, 0.01, 0.02, 0.98 };
+    regimes.setProcessConfig(process);
+    x = collect(regimes, 3, 100000, 1000);
+    size_t high = 0;
+    size_t switches = 0;
+    for (size_t i = 0; i < x.size(); i += 2) {
+        const bool isHigh = x[i] > 5.0;
+        assert(isHigh == (x[i + 1] > 5.0));
+        high += isHigh;
+        if (i > 0 && isHigh != (x[i - 2] > 5.0)) {
+            ++switches;
+        }
+    }
+    assert(std::fabs(high / 100000.0 - 1.0 / 3.0) < 0.05);
+    assert(switches > 1000 && switches < 1700);
+
+    // Invalid parameters are rejected
+    bool threw = false;
+    process = ProcessConfig();
+    process.garchAlpha = 0.3;
+    process.garchBeta = 0.8;
+    try { garch.setProcessConfig(process); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    process = ProcessConfig();
+    process.regimeTransitions = { 0.5, 0.4, 0.5, 0.5 };
+    try { garch.setProcessConfig(process); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    std::cout << "Stochastic process pattern tests passed!" << std::endl;
+}
+
+void testTimestampFormatting() {
+    std::cout << "Testing timestamp formatting..." << std::endl;
+
+    // Calendar arithmetic round-trips and matches known dates
+    assert(DateTime::daysFromCivil(1970, 1, 1) == 0);
+    assert(DateTime::daysFromCivil(2000, 3, 1) == 11017);
+    assert(DateTime::daysFromCivil(1969, 12, 31) == -1);
+    for (std::int64_t days = -800000; days <= 800000; days += 37) {
+        std::int64_t year;
+        unsigned month, day;
+        DateTime::civilFromDays(days, year, month, day);
+        assert(DateTime::daysFromCivil(year, month, day) == days);
+    }
+    assert(DateTime::parseDate("2024-02-29") == DateTime::daysFromCivil(2024, 2, 29));
+    assert(DateTime::parseDate("2020-1-5") == DateTime::daysFromCivil(2020, 1, 5));
+    const char* invalid[] = { "2023-02-29", "2023-13-01", "2023/01/01", "20230101", "" };
+    for (const char* text : invalid) {
+        bool threw = false;
+        try { DateTime::parseDate(text); } catch (const std::invalid_argument&) { threw = true; }
+        assert(threw);
+    }
+
+    // Incremental formatting matches a full rendering for every step, across day,
+    // month and year boundaries and before the epoch
+    TimestampFormatter iso(TimestampFormat::ISO_8601, TimeZone::UTC);
+    TimestampFormatter plain(TimestampFormat::DATE_TIME, TimeZone::UTC);
+    const std::int64_t steps[] = { 1, 59, 3600, 86399, 86401 };
+    for (std::int64_t step : steps) {
+        for (std::int64_t t = -100000000; t < 100000000; t += step * 997) {
+            const std::int64_t day = DateTime::floorDiv(t, 86400);
+            char expected[20];
+            DateTime::writeDate(day, expected);
+            expected[10] = ' ';
+            DateTime::writeTime(static_cast<unsigned>(t - day * 86400), expected + 11);
+            assert(plain.format(t) == std::string_view(expected, 19));
+            expected[10] = 'T';
+            expected[19] = 'Z';
+            assert(iso.format(t) == std::string_view(expected, 20));
+        }
+    }
+    assert(plain.format(951782400) == "2000-02-29 00:00:00");
+    assert(iso.format(-1) == "1969-12-31T23:59:59Z");
+
+    TimestampFormatter seconds(TimestampFormat::EPOCH_SECONDS);
+    TimestampFormatter millis(TimestampFormat::EPOCH_MILLIS);
+    assert(seconds.format(1700000000) == "1700000000");
+    assert(seconds.format(-42) == "-42");
+    assert(millis.format(1700000000) == "1700000000000");
+
+    // Local time agrees with the C library, offset included
+    TimestampFormatter local(TimestampFormat::DATE_TIME);
+    TimestampFormatter localIso(TimestampFormat::ISO_8601);
+    for (std::int64_t t = 1600000000; t < 1700000000; t += 1800 + 7) {
+        const std::time_t instant = static_cast<std::time_t>(t);
+        char expected[32];
+        std::strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M:%S", std::localtime(&instant));
+        assert(local.format(t) == expected);
+        const std::string_view withOffset = localIso.format(t);
+        assert(withOffset.size() == 25);
+        const int offset = DateTime::localOffset(t);
+        const int minutes = (offset < 0 ? -offset : offset) / 60;
+        char suffix[7];
+        suffix[0] = offset < 0 ? '-' : '+';
+        DateTime::write2(suffix + 1, minutes / 60);
+        suffix[3] = ':';
+        DateTime::write2(suffix + 4, minutes % 60);
+        assert(withOffset.substr(19) == std::string_view(suffix, 6));
+    }
+
+    // CSV export uses the configured format
+    TimeSeriesData series(3, 1);
+    series.setStartTime(1704067140);
+    series.setTimeStep(30);
+    series.setTimestampFormat(TimestampFormat::ISO_8601, TimeZone::UTC);
+    series.generate();
+    series.exportToCSV("test_timestamps.csv");
+    std::ifstream csv("test_timestamps.csv");
+    std::string line;
+    std::getline(csv, line);
+    std::getline(csv, line);
+    assert(line.rfind("2023-12-31T23:59:00Z,", 0) == 0);
+    std::getline(csv, line);
+    assert(line.rfind("2023-12-31T23:59:30Z,", 0) == 0);
+    std::getline(csv, line);
+    assert(line.rfind("2024-01-01T00:00:00Z,", 0) == 0);
+    csv.close();
+    fs::remove("test_timestamps.csv");
+
+    std::cout << "Timestamp formatting tests passed!" << std::endl;
+}
+
+void testBinaryTimeSeriesFile() {
+    std::cout << "Testing compressed binary time-series files..." << std::endl;
+
+    auto sameBits = [](double a, double b) {
+        return std::memcmp(&a, &b, sizeof(a)) == 0;
+    };
+
+    // Awkward values and timestamps survive bit for bit across several blocks
+    const int dims = 3;
+    const size_t points = 2500;
+    std::vector<std::int64_t> timestamps(points);
+    std::vector<double> values(points * dims);
+    const double specials[] = { std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(), -0.0, 0.0, std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::max(), std::numeric_limits<double>::min() };
+    std::mt19937_64 rng(7);
+    std::int64_t t = -5000;
+    for (size_t i = 0; i < points; ++i) {
+        // Mostly regular steps, with jitter, gaps and jumps across the whole int64 range
+        if (i % 500 == 250) {
+            t = i % 1000 == 250 ? std::numeric_limits<std::int64_t>::max() - 100000000 : std::numeric_limits<std::int64_t>::min();
+        } else {
+            t += i % 97 == 0 ? static_cast<std::int64_t>(rng() % 100000) : i % 13 == 0 ? 61 : 60;
+        }
+        timestamps[i] = t;
+        values[i * dims] = std::sin(0.01 * i);                 // smooth
+        values[i * dims + 1] = i % 10 < 7 ? 42.5 : -1e300;     // repeats
+        values[i * dims + 2] = i % 11 == 0 ? specials[i / 11 % 8] : std::ldexp(static_cast<double>(rng()), -40);
+    }
+    const std::string filename = "test_series.sdts";
+    {
+        TimeSeriesWriter writer(filename, dims, 1000);
+        for (size_t i = 0; i < points; ++i) {
+            writer.append(timestamps[i], values.data() + i * dims);
+        }
+        writer.close();
+    }
+    {
+        TimeSeriesReader reader(filename);
+        assert(reader.dimensions() == dims);
+        assert(reader.numPoints() == points);
+        assert(reader.numBlocks() == 3);
+        assert(reader.blockInfo(2).firstIndex == 2000 && reader.blockInfo(2).count == 500);
+        assert(reader.blockOfPoint(999) == 0 && reader.blockOfPoint(1000) == 1 && reader.blockOfPoint(points) == 3);
+
+        // Read the blocks out of order
+        TimeSeriesBlock block;
+        for (size_t b : { 2, 0, 1 }) {
+            reader.readBlock(b, block);
+            assert(block.dimensions == dims && block.firstIndex == b * 1000);
+            for (size_t i = 0; i < block.size(); ++i) {
+                const size_t index = block.firstIndex + i;
+                assert(block.timestamps[i] == timestamps[index]);
+                for (int d = 0; d < dims; ++d) {
+                    assert(sameBits(block.point(i)[d], values[index * dims + d]));
+                }
+            }
+        }
+        std::vector<double> column;
+        reader.readColumn(1, 2, column);
+        assert(column.size() == 1000);
+        for (size_t i = 0; i < column.size(); ++i) {
+            assert(sameBits(column[i], values[(1000 + i) * dims + 2]));
+        }
+    }
+
+    // A generated series: random access by time, and far smaller than 16 bytes a value
+    TimeSeriesData series(20000, 4);
+    series.setPattern(TimeSeriesPattern::SEASONAL);
+    series.setStartTime(1700000000);
+    series.setTimeStep(60);
+    series.generate();
+    series.exportToBinary(filename);
+    {
+        TimeSeriesReader reader(filename);
+        assert(reader.numPoints() == 20000);
+        const std::vector<TimePoint> expected = series.getTimeSeries();
+        const std::int64_t target = 1700000000 + 60 * 12345;
+        const size_t b = reader.findBlock(target);
+        assert(b < reader.numBlocks());
+        assert(reader.blockInfo(b).firstTimestamp <= target && reader.blockInfo(b).lastTimestamp >= target);
+        assert(reader.findBlock(std::numeric_limits<std::int64_t>::max()) == reader.numBlocks());
+        TimeSeriesBlock block;
+        reader.readBlock(b, block);
+        const size_t i = static_cast<size_t>(12345 - block.firstIndex);
+        assert(block.timestamps[i] == target);
+        for (int d = 0; d < 4; ++d) {
+            assert(sameBits(block.point(i)[d], expected[12345].values[d]));
+        }
+    }
+    const double bytesPerValue = static_cast<double>(fs::file_size(filename)) / (20000.0 * 5);
+    std::cout << "  " << bytesPerValue << " bytes per value" << std::endl;
+    assert(bytesPerValue < 8.0);
+
+    // A file without points is valid
+    {
+        TimeSeriesWriter writer(filename, 2);
+        writer.close();
+        TimeSeriesReader reader(filename);
+        assert(reader.numPoints() == 0 && reader.numBlocks() == 0 && reader.findBlock(0) == 0);
+    }
+    series.exportToBinary(filename);
+
+    // Damage is reported, not decoded
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(0);
+        file.put('X');
+    }
+    bool rejected = false;
+    try {
+        TimeSeriesReader reader(filename);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    fs::resize_file(filename, 100);
+    rejected = false;
+    try {
+        TimeSeriesReader reader(filename);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+    fs::remove(filename);
+
+    std::cout << "Binary time-series file tests passed!" << std::endl;
+}
+
 int main() {
     testTimeSeriesDataGeneration();
+    testTimeSeriesStream();
+    testCorrelatedTimeSeries();
+    testProcessPatterns();
+    testTimestampFormatting();
+    testBinaryTimeSeriesFile();
     return 0;
 }
\ No newline at end of file